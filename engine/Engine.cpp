@@ -6,6 +6,7 @@
 
 #include "Engine.h"
 
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
@@ -22,7 +23,11 @@
 #include "data/Dictionary.h"
 #include "data/UserDictionary.h"
 #include "input/BufferMgr.h"
+#include "input/CandidateCache.h"
+#include "input/CandidatePrefetcher.h"
+#include "input/KeyEventWorker.h"
 #include "input/SyllableParser.h"
+#include "utils/CommandArena.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
@@ -39,6 +44,27 @@ bool ModKeyPressed(KeyEvent key_event, ModifierKey modifier) {
     });
 }
 
+// Keys that HandleSendKey inserts into the composition
+bool IsInsertKey(KeyEvent const &key_event) {
+    return key_event.special_key() == SK_NONE && isprint(key_event.key_code()) != 0;
+}
+
+bool IsInsertCommand(Request const *request) {
+    return request->type() == CMD_SEND_KEY && IsInsertKey(request->key_event());
+}
+
+// False for the commands that only read the state of the engine
+bool ChangesState(Request const *request) {
+    switch (request->type()) {
+    case CMD_TEST_SEND_KEY:
+    case CMD_GET_CANDIDATES:
+    case CMD_LIST_EMOJIS:
+        return false;
+    default:
+        return true;
+    }
+}
+
 class EngineImpl final : public Engine {
   public:
     EngineImpl() = default;
@@ -59,21 +85,53 @@ class EngineImpl final : public Engine {
     }
 
     void SendCommand(const Request *request, Response *response) override {
-        //std::lock_guard<std::mutex> lock(m_mutex);
+        auto changes_state = ChangesState(request);
+        if (changes_state) {
+            CancelPrefetch();
+        }
+
+        auto deferred = m_config->deferred_candidates();
+        if (deferred) {
+            if (SendDeferredCommand(request, response)) {
+                return;
+            }
+            KeyWorker().Wait();
+        }
 
-        decltype(&EngineImpl::HandleNone) handler;
+        {
+            auto lock = std::unique_lock<std::mutex>(m_mutex);
+            auto arena_scope = CommandArena::Scope(&m_arena);
+            decltype(&EngineImpl::HandleNone) handler;
 
-        if (auto it = m_cmd_handlers.find(request->type()); it != m_cmd_handlers.end()) {
-            handler = it->second;
-        } else {
-            handler = &EngineImpl::HandleNone;
+            if (auto it = m_cmd_handlers.find(request->type()); it != m_cmd_handlers.end()) {
+                handler = it->second;
+            } else {
+                handler = &EngineImpl::HandleNone;
+            }
+
+            (this->*handler)(request, response);
+
+            if (m_config->deferred_candidates()) {
+                UpdateKeyWorkerResult(request, response);
+            }
+
+            // Prefetched results are only for inserting into the composition
+            // they were computed for
+            if (changes_state && !IsInsertCommand(request)) {
+                ClearPrefetched();
+            }
         }
 
-        (this->*handler)(request, response);
+        if (changes_state) {
+            UpdatePrefetcher();
+        }
     }
 
     void LoadDictionary(std::string const &file_path) override {
-        //std::lock_guard<std::mutex> lock(m_mutex);
+        CancelPrefetch();
+        WaitForKeyWorker();
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        ClearPrefetched();
 
         if (auto curr_db = m_database->CurrentConnection(); curr_db != file_path) {
             m_dbfilename = file_path;
@@ -83,7 +141,10 @@ class EngineImpl final : public Engine {
     }
 
     void LoadUserDictionary(std::string file_path) override {
-        //std::lock_guard<std::mutex> lock(m_mutex);
+        CancelPrefetch();
+        WaitForKeyWorker();
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        ClearPrefetched();
 
         if (file_path.empty()) {
             m_userdict = nullptr;
@@ -92,12 +153,28 @@ class EngineImpl final : public Engine {
                 m_userdict = UserDictionary::Create(file_path);
             }
         }
+
+        if (m_candidate_cache) {
+            m_candidate_cache->Clear();
+        }
     }
 
     BufferMgr *buffer_mgr() override {
         return m_buffer_mgr.get();
     }
 
+    CandidateCache *candidate_cache() override {
+        return m_candidate_cache.get();
+    }
+
+    CandidatePrefetcher *candidate_prefetcher() override {
+        return m_prefetcher.get();
+    }
+
+    CommandArena *command_arena() override {
+        return &m_arena;
+    }
+
     Database *database() override {
         return m_database.get();
     }
@@ -122,12 +199,22 @@ class EngineImpl final : public Engine {
         return m_config.get();
     }
 
+    void SetCandidatesReadyCallback(std::function<void()> callback) override {
+        m_candidates_ready = std::move(callback);
+        if (m_key_worker) {
+            m_key_worker->SetReadyCallback(m_candidates_ready);
+        }
+    }
+
     void RegisterConfigChangedListener(ConfigChangeListener *listener) override {
         m_config_change_listeners.push_back(listener);
     }
 
   private:
     void Reinit() {
+        // Unregisters from the database it listens to before that is replaced
+        m_candidate_cache = nullptr;
+
         auto db_path = fs::path(m_dbfilename);
         if (fs::exists(db_path)) {
             m_database = Database::Connect(db_path.string());
@@ -139,6 +226,7 @@ class EngineImpl final : public Engine {
         m_keyconfig = KeyConfig::Create(this);
         m_syllable_parser = SyllableParser::Create(this);
         m_dictionary = Dictionary::Create(this);
+        m_candidate_cache = CandidateCache::Create(this);
         m_buffer_mgr = BufferMgr::Create(this);
 
         if (m_cmd_handlers.empty()) {
@@ -272,11 +360,20 @@ class EngineImpl final : public Engine {
             if (mods.size() > 1 || mods.at(0) != MODK_SHIFT) {
                 response->set_consumable(false);
             }
-        } else if (m_buffer_mgr->IsEmpty() && isgraph(key) == 0) {
+        } else if (BufferIsEmpty() && isgraph(key) == 0) {
             response->set_consumable(false);
         }
     }
 
+    // A key that the worker has not applied yet always inserts a letter
+    bool BufferIsEmpty() {
+        if (m_key_worker && m_key_worker->busy()) {
+            return false;
+        }
+
+        return m_buffer_mgr->IsEmpty();
+    }
+
     void AttachPreeditWithCandidates(const Request *request, Response *response) {
         auto *preedit = response->mutable_preedit();
         m_buffer_mgr->BuildPreedit(preedit);
@@ -333,6 +430,134 @@ class EngineImpl final : public Engine {
         m_database->ClearNGramsData();
     }
 
+    //+---------------------------------------------------------------------------
+    //
+    // Deferred candidates
+    //
+    //----------------------------------------------------------------------------
+
+    // Handles the commands that do not need to wait for the worker. Letters
+    // are posted to the worker, which inserts them and computes the
+    // candidates while the host gets a provisional preedit back.
+    bool SendDeferredCommand(const Request *request, Response *response) {
+        auto &worker = KeyWorker();
+
+        switch (request->type()) {
+        case CMD_SEND_KEY:
+            if (IsInsertKey(request->key_event())) {
+                worker.Post(*request, response);
+                return true;
+            }
+            return false;
+        case CMD_GET_CANDIDATES:
+            worker.GetResult(response);
+            return true;
+        case CMD_TEST_SEND_KEY:
+            if (worker.busy()) {
+                HandleTestSendKey(request, response);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    // Keeps the worker's result in step with commands handled outside it,
+    // since provisional preedits are built on top of it
+    void UpdateKeyWorkerResult(const Request *request, Response *response) {
+        switch (request->type()) {
+        case CMD_TEST_SEND_KEY:
+        case CMD_LIST_EMOJIS:
+            return;
+        default:
+            break;
+        }
+
+        if (response->has_preedit()) {
+            KeyWorker().SetResult(*response);
+        } else {
+            auto result = Response();
+            AttachPreeditWithCandidates(request, &result);
+            KeyWorker().SetResult(result);
+        }
+    }
+
+    KeyEventWorker &KeyWorker() {
+        if (!m_key_worker) {
+            m_key_worker = std::make_unique<KeyEventWorker>(
+                [this](std::string const &keys, KeyEventWorker::SupersededFn const &superseded) {
+                    auto lock = std::unique_lock<std::mutex>(m_mutex);
+                    auto arena_scope = CommandArena::Scope(&m_arena);
+                    return m_buffer_mgr->Insert(keys, superseded);
+                },
+                [this](Response *response) {
+                    {
+                        auto lock = std::unique_lock<std::mutex>(m_mutex);
+                        auto arena_scope = CommandArena::Scope(&m_arena);
+                        AttachPreeditWithCandidates(nullptr, response);
+                    }
+                    if (m_prefetcher) {
+                        m_prefetcher->Schedule();
+                    }
+                });
+            m_key_worker->SetReadyCallback(m_candidates_ready);
+        }
+
+        return *m_key_worker;
+    }
+
+    void WaitForKeyWorker() {
+        if (m_key_worker) {
+            m_key_worker->Wait();
+        }
+    }
+
+    //+---------------------------------------------------------------------------
+    //
+    // Prefetching
+    //
+    //----------------------------------------------------------------------------
+
+    // Creates or removes the prefetcher to follow the config, and starts
+    // prefetching for the state left by the last command. Must not hold
+    // |m_mutex|, since the prefetch thread is joined when it is removed.
+    void UpdatePrefetcher() {
+        auto budget = std::chrono::milliseconds(m_config->prefetch_budget_ms());
+
+        if (!m_config->prefetch_candidates()) {
+            m_prefetcher = nullptr;
+            return;
+        }
+
+        if (!m_prefetcher) {
+            m_prefetcher = std::make_unique<CandidatePrefetcher>(
+                [this](CandidatePrefetcher::StopFn const &stop) {
+                    auto lock = std::unique_lock<std::mutex>(m_mutex);
+                    auto arena_scope = CommandArena::Scope(&m_arena);
+                    return m_buffer_mgr->PrefetchNextKey(stop);
+                },
+                budget);
+        } else {
+            m_prefetcher->set_budget(budget);
+        }
+
+        m_prefetcher->Schedule();
+    }
+
+    void CancelPrefetch() {
+        if (m_prefetcher) {
+            m_prefetcher->Cancel();
+        }
+    }
+
+    // Requires |m_mutex|
+    void ClearPrefetched() {
+        if (m_prefetcher) {
+            m_prefetcher->Clear();
+        }
+    }
+
     // void HandleRevert(Command *command, Output *output) {}
     // void HandlePlaceCursor(Command *command, Output *output) {}
 
@@ -345,6 +570,8 @@ class EngineImpl final : public Engine {
     std::unique_ptr<SyllableParser> m_syllable_parser = nullptr;
     std::unique_ptr<Dictionary> m_dictionary = nullptr;
     std::unique_ptr<UserDictionary> m_userdict = nullptr;
+    // Declared after everything it observes, so that it is destroyed first
+    std::unique_ptr<CandidateCache> m_candidate_cache = nullptr;
 
     std::vector<std::string> m_valid_syllables;
 
@@ -352,7 +579,17 @@ class EngineImpl final : public Engine {
     std::vector<ConfigChangeListener *> m_config_change_listeners;
     std::unique_ptr<Config> m_config = nullptr;
 
-    //mutable std::mutex m_mutex;
+    // Held while the buffer manager is used, by either the host's thread or
+    // the key worker
+    std::mutex m_mutex;
+    // Only used while holding |m_mutex|
+    CommandArena m_arena;
+    std::function<void()> m_candidates_ready;
+    // Declared after everything their threads use, so that they stop before
+    // any of it is destroyed. The key worker uses the prefetcher and stops
+    // first.
+    std::unique_ptr<CandidatePrefetcher> m_prefetcher = nullptr;
+    std::unique_ptr<KeyEventWorker> m_key_worker = nullptr;
 };
 
 } // namespace
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -12,6 +13,9 @@ class Response;
 namespace khiin::engine {
 
 class BufferMgr;
+class CandidateCache;
+class CandidatePrefetcher;
+class CommandArena;
 class Config;
 class ConfigChangeListener;
 class Database;
@@ -34,7 +38,16 @@ class Engine {
     virtual void LoadUserDictionary(std::string file_path) = 0;
     virtual void RegisterConfigChangedListener(ConfigChangeListener *listener) = 0;
 
+    // Called on an engine thread when the candidates computed for
+    // CMD_GET_CANDIDATES are ready, with |deferred_candidates| enabled
+    virtual void SetCandidatesReadyCallback(std::function<void()> callback) = 0;
+
     virtual BufferMgr *buffer_mgr() = 0;
+    virtual CandidateCache *candidate_cache() = 0;
+    // Only while |prefetch_candidates| is enabled, otherwise nullptr
+    virtual CandidatePrefetcher *candidate_prefetcher() = 0;
+    // Scratch memory released after each command
+    virtual CommandArena *command_arena() = 0;
     virtual Database *database() = 0;
     virtual Dictionary *dictionary() = 0;
     virtual UserDictionary *user_dict() = 0;
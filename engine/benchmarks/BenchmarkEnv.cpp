@@ -0,0 +1,155 @@
+#include "BenchmarkEnv.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "data/Database.h"
+
+namespace {
+
+std::atomic<size_t> g_allocated_bytes = 0;
+std::atomic<size_t> g_allocation_count = 0;
+
+// Each allocation is prefixed with its size so that operator delete
+// can subtract it again.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+void *CountedAlloc(size_t size) {
+    auto *ptr = static_cast<char *>(std::malloc(size + kHeaderSize));
+
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    *reinterpret_cast<size_t *>(ptr) = size;
+    g_allocated_bytes += size;
+    ++g_allocation_count;
+    return ptr + kHeaderSize;
+}
+
+void CountedFree(void *ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    auto *base = static_cast<char *>(ptr) - kHeaderSize;
+    g_allocated_bytes -= *reinterpret_cast<size_t *>(base);
+    std::free(base);
+}
+
+// Used by the aligned forms of operator new, which std::pmr's heap resource
+// calls for every allocation. The size and the start of the block are
+// stored right before the aligned pointer.
+void *CountedAlignedAlloc(size_t size, std::align_val_t alignment) {
+    auto align = static_cast<uintptr_t>(alignment);
+    auto *base = static_cast<char *>(std::malloc(size + align + 2 * sizeof(void *)));
+
+    if (base == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    auto addr = reinterpret_cast<uintptr_t>(base + 2 * sizeof(void *));
+    auto *ptr = reinterpret_cast<char *>((addr + align - 1) & ~(align - 1));
+    reinterpret_cast<void **>(ptr)[-1] = base;
+    reinterpret_cast<size_t *>(ptr)[-2] = size;
+    g_allocated_bytes += size;
+    ++g_allocation_count;
+    return ptr;
+}
+
+void CountedAlignedFree(void *ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    g_allocated_bytes -= static_cast<size_t *>(ptr)[-2];
+    std::free(static_cast<void **>(ptr)[-1]);
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+    return CountedAlloc(size);
+}
+
+void *operator new[](size_t size) {
+    return CountedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    CountedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    CountedFree(ptr);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return CountedAlignedAlloc(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return CountedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    CountedAlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    CountedAlignedFree(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    CountedAlignedFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    CountedAlignedFree(ptr);
+}
+
+namespace khiin::engine::bench {
+
+std::vector<std::string> const &AllWordKeys() {
+    static auto const keys = [] {
+        auto ret = std::vector<std::string>();
+        auto db = Database::Connect(kDatabaseFile);
+        db->AllWordsByFreq(ret, InputType::Numeric);
+        return ret;
+    }();
+    return keys;
+}
+
+std::string ContinuousInput(size_t length) {
+    auto const &keys = AllWordKeys();
+    auto ret = std::string();
+    auto rng = std::mt19937(7); // NOLINT
+    auto dist = std::uniform_int_distribution<size_t>(0, keys.empty() ? 0 : keys.size() - 1);
+    while (ret.size() < length && !keys.empty()) {
+        ret += keys[dist(rng)];
+    }
+    ret.resize(std::min(ret.size(), length));
+    return ret;
+}
+
+size_t AllocatedBytes() {
+    return g_allocated_bytes.load();
+}
+
+size_t AllocationCount() {
+    return g_allocation_count.load();
+}
+
+} // namespace khiin::engine::bench
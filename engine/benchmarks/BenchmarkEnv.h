@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace khiin::engine::bench {
+
+// Name of the system database, copied next to the benchmark executable
+// at build time
+constexpr auto kDatabaseFile = "khiin.db";
+
+// Numeric input sequences for all words in |kDatabaseFile|, ordered
+// by frequency. Loaded once and cached for the whole run.
+std::vector<std::string> const &AllWordKeys();
+
+// Unspaced input of |length| bytes made of random dictionary keys, the same
+// for every call with the same |length|
+std::string ContinuousInput(size_t length);
+
+// Total number of bytes currently allocated through global operator new,
+// used to report the heap footprint of a data structure as a counter.
+size_t AllocatedBytes();
+
+// Total number of calls to global operator new so far
+size_t AllocationCount();
+
+} // namespace khiin::engine::bench
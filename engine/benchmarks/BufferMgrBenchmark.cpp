@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include "Engine.h"
+#include "config/Config.h"
+#include "input/BufferMgr.h"
+#include "proto/proto.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+constexpr size_t kSentenceSize = 60;
+
+// Types an unspaced sentence one key at a time in continuous mode, which
+// recomputes the composition and candidates on every keystroke
+void BM_BufferMgrTypeSentence(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto input = ContinuousInput(kSentenceSize);
+
+    for (auto _ : state) {
+        auto buffer = BufferMgr::Create(engine.get());
+        for (auto ch : input) {
+            buffer->Insert(ch);
+        }
+        benchmark::DoNotOptimize(buffer->IsEmpty());
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(input.size()));
+}
+
+// Types the sentence, then erases it one character at a time from the end
+void BM_BufferMgrTypeAndErase(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto input = ContinuousInput(kSentenceSize);
+    int64_t keys = 0;
+
+    for (auto _ : state) {
+        auto buffer = BufferMgr::Create(engine.get());
+        for (auto ch : input) {
+            buffer->Insert(ch);
+            ++keys;
+        }
+        while (!buffer->IsEmpty()) {
+            buffer->Erase(CursorDirection::L);
+            ++keys;
+        }
+    }
+
+    state.SetItemsProcessed(keys);
+}
+
+// Types the sentence and builds the preedit and candidate list after every
+// keystroke, as the engine does for each key event
+void BM_BufferMgrTypeAndShow(benchmark::State &state, proto::InputMode mode) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto config = proto::AppConfig();
+    config.set_input_mode(mode);
+    engine->config()->UpdateAppConfig(config);
+    auto input = ContinuousInput(kSentenceSize);
+    size_t allocations = 0;
+
+    for (auto _ : state) {
+        auto buffer = BufferMgr::Create(engine.get());
+        auto before = AllocationCount();
+        for (auto ch : input) {
+            buffer->Insert(ch);
+            auto preedit = proto::Preedit();
+            auto candidates = proto::CandidateList();
+            buffer->BuildPreedit(&preedit);
+            buffer->GetCandidates(&candidates);
+            benchmark::DoNotOptimize(candidates.candidates_size());
+        }
+        allocations = AllocationCount() - before;
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(input.size()));
+    state.counters["allocs_per_key"] = static_cast<double>(allocations) / static_cast<double>(input.size());
+}
+
+BENCHMARK(BM_BufferMgrTypeSentence)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BufferMgrTypeAndErase)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BufferMgrTypeAndShow, Continuous, proto::IM_CONTINUOUS)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BufferMgrTypeAndShow, Basic, proto::IM_BASIC)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace khiin::engine::bench
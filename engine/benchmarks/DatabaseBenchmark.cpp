@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "Engine.h"
+#include "data/Database.h"
+#include "data/Dictionary.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+// The candidates for the first word of a typical input, as looked up on
+// each keystroke
+std::vector<TaiToken> SampleCandidates(Engine *engine) {
+    auto const &keys = AllWordKeys();
+    auto ret = std::vector<TaiToken>();
+    for (size_t i = 0; i < keys.size() && ret.size() < 20; ++i) { // NOLINT
+        auto tokens = engine->dictionary()->AllWordsFromStart(keys[i]);
+        ret.insert(ret.end(), tokens.begin(), tokens.end());
+    }
+    return ret;
+}
+
+// N-gram counts for a candidate list, looked up in memory
+void BM_DatabaseAddNGramsData(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto tokens = SampleCandidates(engine.get());
+    auto lgram = std::optional<std::string>(tokens.empty() ? "" : std::string(tokens.back().output));
+
+    for (auto _ : state) {
+        engine->database()->AddNGramsData(lgram, tokens);
+        benchmark::DoNotOptimize(tokens.data());
+    }
+
+    state.counters["grams"] = static_cast<double>(tokens.size());
+}
+
+// The same unigram and bigram lookups done in SQL, preparing a statement
+// with one placeholder per gram on every call, as they were before the
+// statements were cached and the counts were kept in memory
+void BM_DatabaseAddNGramsData_Uncached(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto tokens = SampleCandidates(engine.get());
+    auto lgram = tokens.empty() ? std::string() : std::string(tokens.back().output);
+    auto db = SQLite::Database(kDatabaseFile, SQLite::OPEN_READONLY);
+
+    auto qmarks = std::string();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        qmarks += i == 0 ? "?" : ", ?";
+    }
+    auto unigram_sql = "SELECT gram, n FROM unigram_freq WHERE gram in (" + qmarks + ")";
+    auto bigram_sql = "SELECT rgram, n FROM bigram_freq WHERE lgram = ? AND rgram in (" + qmarks + ")";
+
+    for (auto _ : state) {
+        auto unigrams = SQLite::Statement(db, unigram_sql);
+        auto bigrams = SQLite::Statement(db, bigram_sql);
+        bigrams.bind(1, lgram);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            unigrams.bind(static_cast<int>(i + 1), std::string(tokens[i].output));
+            bigrams.bind(static_cast<int>(i + 2), std::string(tokens[i].output));
+        }
+        while (unigrams.executeStep()) {
+        }
+        while (bigrams.executeStep()) {
+        }
+    }
+
+    state.counters["grams"] = static_cast<double>(tokens.size());
+}
+
+BENCHMARK(BM_DatabaseAddNGramsData);
+BENCHMARK(BM_DatabaseAddNGramsData_Uncached);
+
+} // namespace
+} // namespace khiin::engine::bench
@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+
+#include "Engine.h"
+#include "data/Dictionary.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+// Continuous-mode segmentation, reporting heap allocations per call
+void BM_DictionarySegment(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto *dictionary = engine->dictionary();
+    auto input = ContinuousInput(static_cast<size_t>(state.range(0)));
+    size_t allocations = 0;
+
+    for (auto _ : state) {
+        auto before = AllocationCount();
+        auto result = dictionary->Segment(input, 5); // NOLINT
+        allocations = AllocationCount() - before;
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.counters["bytes"] = static_cast<double>(input.size());
+    state.counters["allocs"] = static_cast<double>(allocations);
+}
+
+// Number of alternative segmentations requested for a 40 byte input
+void BM_DictionarySegmentLimit(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto *dictionary = engine->dictionary();
+    auto input = ContinuousInput(40); // NOLINT
+    auto limit = static_cast<uint32_t>(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dictionary->Segment(input, limit));
+    }
+}
+
+// Conversion lookup for the words at each position of the input, as the
+// candidate finder does while typing
+void BM_DictionaryAllWordsFromStart(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto *dictionary = engine->dictionary();
+    auto input = ContinuousInput(static_cast<size_t>(state.range(0)));
+    auto queries = std::vector<std::string>();
+    for (size_t i = 0; i < input.size(); ++i) {
+        queries.push_back(input.substr(i));
+    }
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            benchmark::DoNotOptimize(dictionary->AllWordsFromStart(query));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+BENCHMARK(BM_DictionarySegment)->Arg(20)->Arg(40)->Arg(64)->Arg(256)->Arg(1024); // NOLINT
+BENCHMARK(BM_DictionarySegmentLimit)->Arg(1)->Arg(5)->Arg(50)->Arg(200);            // NOLINT
+BENCHMARK(BM_DictionaryAllWordsFromStart)->Arg(20)->Arg(64);                       // NOLINT
+
+} // namespace
+} // namespace khiin::engine::bench
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include "Engine.h"
+#include "config/Config.h"
+#include "data/Dictionary.h"
+#include "data/DictionaryImage.h"
+#include "proto/proto.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+namespace fs = std::filesystem;
+
+// Startup without a dictionary image: everything is rebuilt from SQLite
+void BM_EngineCreate_Database(benchmark::State &state) {
+    fs::remove(DictionaryImage::ImageFileFor(kDatabaseFile));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Engine::Create(kDatabaseFile));
+    }
+}
+
+// Startup with a current dictionary image next to the database
+void BM_EngineCreate_Image(benchmark::State &state) {
+    auto image_file = DictionaryImage::ImageFileFor(kDatabaseFile);
+    if (!Engine::Create(kDatabaseFile)->dictionary()->CompileImage(image_file)) {
+        state.SkipWithError("Unable to compile dictionary image");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Engine::Create(kDatabaseFile));
+    }
+
+    fs::remove(image_file);
+}
+
+// Sends every key of a sentence as CMD_SEND_KEY, the way a host does, and
+// counts the heap allocations made per keystroke. Scratch containers come
+// from the engine's command arena here, unlike in BM_BufferMgrTypeAndShow,
+// which drives the buffer manager directly.
+void BM_EngineSendKey(benchmark::State &state, proto::InputMode mode) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto config = proto::AppConfig();
+    config.set_input_mode(mode);
+    engine->config()->UpdateAppConfig(config);
+    auto input = ContinuousInput(60);
+    size_t allocations = 0;
+
+    auto reset = proto::Request();
+    reset.set_type(proto::CMD_RESET);
+    auto key = proto::Request();
+    key.set_type(proto::CMD_SEND_KEY);
+
+    for (auto _ : state) {
+        auto response = proto::Response();
+        engine->SendCommand(&reset, &response);
+
+        auto before = AllocationCount();
+        for (auto ch : input) {
+            key.mutable_key_event()->set_key_code(ch);
+            response.Clear();
+            engine->SendCommand(&key, &response);
+            benchmark::DoNotOptimize(response.candidate_list().candidates_size());
+        }
+        allocations = AllocationCount() - before;
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(input.size()));
+    state.counters["allocs_per_key"] = static_cast<double>(allocations) / static_cast<double>(input.size());
+}
+
+BENCHMARK(BM_EngineCreate_Database)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EngineCreate_Image)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_EngineSendKey, Continuous, proto::IM_CONTINUOUS)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_EngineSendKey, Basic, proto::IM_BASIC)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace khiin::engine::bench
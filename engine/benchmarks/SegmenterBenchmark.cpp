@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "Engine.h"
+#include "input/Segmenter.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+// Segments a composition of |range(0)| bytes, as on the keystroke that
+// brings the buffer to that size
+void BM_SegmentText(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto input = ContinuousInput(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Segmenter::SegmentText(engine.get(), input));
+    }
+
+    state.counters["bytes"] = static_cast<double>(input.size());
+}
+
+// Dictionary keys mixed with letters that do not spell words, so that the
+// buffer falls apart into many segments
+void BM_SegmentTextMixed(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto const &keys = AllWordKeys();
+    auto size = static_cast<size_t>(state.range(0));
+    auto input = std::string();
+    auto rng = std::mt19937(11); // NOLINT
+    auto dist = std::uniform_int_distribution<size_t>(0, keys.empty() ? 0 : keys.size() - 1);
+    while (input.size() < size && !keys.empty()) {
+        input += keys[dist(rng)];
+        input += "xq-"[rng() % 3];
+    }
+    input.resize(std::min(input.size(), size));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Segmenter::SegmentText(engine.get(), input));
+    }
+
+    state.counters["bytes"] = static_cast<double>(input.size());
+}
+
+void BM_LongestSegmentFromStart(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto input = ContinuousInput(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Segmenter::LongestSegmentFromStart(engine.get(), input));
+    }
+}
+
+BENCHMARK(BM_SegmentText)->Arg(10)->Arg(25)->Arg(50)->Arg(100);             // NOLINT
+BENCHMARK(BM_SegmentTextMixed)->Arg(10)->Arg(25)->Arg(50)->Arg(100);        // NOLINT
+BENCHMARK(BM_LongestSegmentFromStart)->Arg(10)->Arg(25)->Arg(50)->Arg(100); // NOLINT
+
+} // namespace
+} // namespace khiin::engine::bench
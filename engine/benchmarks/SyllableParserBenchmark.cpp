@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Engine.h"
+#include "data/Database.h"
+#include "data/Dictionary.h"
+#include "input/Lomaji.h"
+#include "input/LomajiTable.h"
+#include "input/SyllableParser.h"
+#include "input/TaiText.h"
+#include "utils/unicode.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+constexpr size_t kWordCount = 500;
+
+// Aligns the input of the most frequent words with their conversions, as
+// BufferElement::Builder does for every candidate
+void BM_TaiTextFromMatching(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto *parser = engine->syllable_parser();
+    auto matches = std::vector<std::pair<std::string, TaiToken>>();
+
+    for (auto const &key : AllWordKeys()) {
+        if (matches.size() == kWordCount) {
+            break;
+        }
+        for (auto const &token : engine->dictionary()->WordSearch(key)) {
+            matches.emplace_back(key, token);
+        }
+    }
+
+    for (auto _ : state) {
+        for (auto const &[input, token] : matches) {
+            benchmark::DoNotOptimize(TaiText::FromMatching(parser, input, token));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(matches.size()));
+}
+
+// Parses the same few syllables over and over, as typing does
+void BM_ParseRawSyllable(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto *parser = engine->syllable_parser();
+    auto const syllables = std::vector<std::string>{"a2", "lang5", "goa2", "tshit4", "--a", "hoonn5", "siong7"};
+
+    for (auto _ : state) {
+        for (auto const &syl : syllables) {
+            benchmark::DoNotOptimize(TaiText::FromRawSyllable(parser, syl));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(syllables.size()));
+}
+
+// Composes and decomposes every syllable in the database with each tone,
+// with Lomaji (0) or with the precomputed table (1)
+void BM_ComposeAllTones(benchmark::State &state) {
+    auto engine = Engine::Create(kDatabaseFile);
+    auto syllables = std::vector<std::string>();
+    engine->database()->LoadSyllables(syllables);
+    auto const table = LomajiTable(syllables);
+    auto const use_table = state.range(0) == 1;
+    auto const tones = std::vector<Tone>{Tone::NaT, Tone::T2, Tone::T3, Tone::T5, Tone::T7, Tone::T8, Tone::T9};
+
+    for (auto _ : state) {
+        for (auto const &syllable : syllables) {
+            for (auto tone : tones) {
+                auto composed = syllable;
+                if (use_table) {
+                    table.ApplyToneDiacritic(tone, composed);
+                    benchmark::DoNotOptimize(table.RemoveToneDiacritic(composed));
+                } else {
+                    Lomaji::ApplyToneDiacritic(tone, composed);
+                    composed = unicode::to_nfc(composed);
+                    benchmark::DoNotOptimize(Lomaji::RemoveToneDiacritic(composed));
+                }
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(syllables.size() * tones.size()));
+}
+
+BENCHMARK(BM_TaiTextFromMatching)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ParseRawSyllable)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ComposeAllTones)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace khiin::engine::bench
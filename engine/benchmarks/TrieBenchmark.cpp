@@ -0,0 +1,244 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <memory>
+#include <random>
+
+#include "data/Splitter.h"
+#include "data/Trie.h"
+
+#include "BenchmarkEnv.h"
+
+namespace khiin::engine::bench {
+namespace {
+
+using TrieFactory = std::function<std::unique_ptr<Trie>(std::vector<std::string> const &)>;
+
+std::unique_ptr<Trie> MutableTrie(std::vector<std::string> const &keys) {
+    auto trie = Trie::Create();
+    trie->Insert(keys);
+    return trie;
+}
+
+std::unique_ptr<Trie> FrozenTrie(std::vector<std::string> const &keys) {
+    return Trie::CreateFrozen(keys);
+}
+
+// A fixed, reproducible sample of dictionary keys used as queries
+std::vector<std::string> const &SampleKeys() {
+    static auto const sample = [] {
+        auto const &keys = AllWordKeys();
+        auto ret = std::vector<std::string>();
+        auto rng = std::mt19937(42); // NOLINT
+        auto dist = std::uniform_int_distribution<size_t>(0, keys.empty() ? 0 : keys.size() - 1);
+        for (auto i = 0; i < 1000 && !keys.empty(); ++i) { // NOLINT
+            ret.push_back(keys[dist(rng)]);
+        }
+        return ret;
+    }();
+    return sample;
+}
+
+// Unspaced "sentences" made of three random dictionary keys each
+std::vector<std::string> const &SampleSentences() {
+    static auto const sample = [] {
+        auto const &keys = SampleKeys();
+        auto ret = std::vector<std::string>();
+        for (size_t i = 0; i + 2 < keys.size(); i += 3) {
+            ret.push_back(keys[i] + keys[i + 1] + keys[i + 2]);
+        }
+        return ret;
+    }();
+    return sample;
+}
+
+void BM_TrieBuild(benchmark::State &state, TrieFactory const &factory) {
+    auto const &keys = AllWordKeys();
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        auto before = AllocatedBytes();
+        auto trie = factory(keys);
+        bytes = AllocatedBytes() - before;
+        benchmark::DoNotOptimize(trie);
+    }
+
+    state.counters["keys"] = static_cast<double>(keys.size());
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+// Simulates typing each sample key one letter at a time
+void BM_TrieHasKeyOrPrefix(benchmark::State &state, TrieFactory const &factory) {
+    auto trie = factory(AllWordKeys());
+    auto const &queries = SampleKeys();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            for (size_t i = 1; i <= query.size(); ++i) {
+                benchmark::DoNotOptimize(trie->HasKeyOrPrefix(std::string_view(query).substr(0, i)));
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_TrieStartsWithKey(benchmark::State &state, TrieFactory const &factory) {
+    auto trie = factory(AllWordKeys());
+    auto const &queries = SampleSentences();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            benchmark::DoNotOptimize(trie->StartsWithKey(query));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_TrieFindKeys(benchmark::State &state, TrieFactory const &factory) {
+    auto trie = factory(AllWordKeys());
+    auto const &queries = SampleSentences();
+    auto results = std::vector<std::string>();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            trie->FindKeys(query, results);
+            benchmark::DoNotOptimize(results.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Completes the first two letters of each sample key, as the dictionary does
+void BM_TrieAutocomplete(benchmark::State &state, TrieFactory const &factory) {
+    auto trie = factory(AllWordKeys());
+    auto const &queries = SampleKeys();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            benchmark::DoNotOptimize(trie->Autocomplete(query.substr(0, 2), 10, 5)); // NOLINT
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_TrieMultisplit(benchmark::State &state, TrieFactory const &factory) {
+    auto const &keys = AllWordKeys();
+    auto trie = factory(keys);
+    auto splitter = Splitter(keys);
+    auto const &queries = SampleSentences();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            benchmark::DoNotOptimize(trie->Multisplit(query, splitter.costs(), 5)); // NOLINT
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_SplitterCanSplit(benchmark::State &state) {
+    auto splitter = Splitter(AllWordKeys());
+    auto const &queries = SampleSentences();
+    size_t allocations = 0;
+
+    for (auto _ : state) {
+        auto before = AllocationCount();
+        for (auto const &query : queries) {
+            benchmark::DoNotOptimize(splitter.CanSplit(query));
+        }
+        allocations = AllocationCount() - before;
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.counters["allocs"] = static_cast<double>(allocations);
+}
+
+// Checks each sample sentence after every keystroke, as the buffer grows
+void BM_SplitterTypingFull(benchmark::State &state) {
+    auto splitter = Splitter(AllWordKeys());
+    auto const &queries = SampleSentences();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            for (size_t i = 1; i <= query.size(); ++i) {
+                benchmark::DoNotOptimize(splitter.CanSplit(std::string_view(query).substr(0, i)));
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void BM_SplitterTypingState(benchmark::State &state) {
+    auto splitter = Splitter(AllWordKeys());
+    auto split_state = Splitter::State(&splitter);
+    auto const &queries = SampleSentences();
+
+    for (auto _ : state) {
+        for (auto const &query : queries) {
+            split_state.Truncate(split_state.text().size());
+            for (auto ch : query) {
+                split_state.Append(ch);
+                benchmark::DoNotOptimize(split_state.CanSplit());
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+// Every string of 1-4 letters over {a, b} is a key, so the number of
+// segmentations grows exponentially with the input length
+void BM_TrieMultisplitDense(benchmark::State &state) {
+    auto keys = std::vector<std::string>();
+    for (auto len = 1; len <= 4; ++len) {                 // NOLINT
+        for (auto bits = 0; bits < (1 << len); ++bits) { // NOLINT
+            auto key = std::string();
+            for (auto i = 0; i < len; ++i) {
+                key += ((bits >> i) & 1) != 0 ? 'b' : 'a';
+            }
+            keys.push_back(std::move(key));
+        }
+    }
+
+    auto trie = Trie::CreateFrozen(keys);
+    auto costs = std::vector<float>();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        costs.push_back(1.0F + static_cast<float>(i % 7) / 10.0F); // NOLINT
+    }
+
+    auto query = std::string();
+    auto rng = std::mt19937(3); // NOLINT
+    for (auto i = 0; i < state.range(0); ++i) {
+        query += rng() % 2 == 0 ? 'a' : 'b';
+    }
+    auto limit = static_cast<uint32_t>(state.range(1));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(trie->Multisplit(query, costs, limit));
+    }
+}
+
+BENCHMARK_CAPTURE(BM_TrieBuild, Mutable, MutableTrie)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TrieBuild, Frozen, FrozenTrie)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TrieHasKeyOrPrefix, Mutable, MutableTrie);
+BENCHMARK_CAPTURE(BM_TrieHasKeyOrPrefix, Frozen, FrozenTrie);
+BENCHMARK_CAPTURE(BM_TrieStartsWithKey, Mutable, MutableTrie);
+BENCHMARK_CAPTURE(BM_TrieStartsWithKey, Frozen, FrozenTrie);
+BENCHMARK_CAPTURE(BM_TrieFindKeys, Mutable, MutableTrie);
+BENCHMARK_CAPTURE(BM_TrieFindKeys, Frozen, FrozenTrie);
+BENCHMARK_CAPTURE(BM_TrieAutocomplete, Mutable, MutableTrie);
+BENCHMARK_CAPTURE(BM_TrieAutocomplete, Frozen, FrozenTrie);
+BENCHMARK_CAPTURE(BM_TrieMultisplit, Mutable, MutableTrie);
+BENCHMARK_CAPTURE(BM_TrieMultisplit, Frozen, FrozenTrie);
+BENCHMARK(BM_SplitterCanSplit);
+BENCHMARK(BM_SplitterTypingFull);
+BENCHMARK(BM_SplitterTypingState);
+BENCHMARK(BM_TrieMultisplitDense)->ArgsProduct({{40, 200}, {1, 5, 50, 200}}); // NOLINT
+
+} // namespace
+} // namespace khiin::engine::bench
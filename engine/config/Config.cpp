@@ -1,10 +1,17 @@
 #include "config/Config.h"
 
+#include <algorithm>
+#include <cstdint>
+
 #include "proto/proto.h"
 
 namespace khiin::engine {
 namespace {
 
+// Upper bound of the sentence search limits, beyond which continuous mode
+// would no longer keep up with typing
+constexpr uint32_t kMaxSentenceLimit = 64;
+
 class ConfigImpl : public Config {
   public:
     ConfigImpl() {
@@ -60,6 +67,46 @@ class ConfigImpl : public Config {
         return default_telex_enabled;
     }
 
+    bool deferred_candidates() override {
+        if (m_protoconf->has_deferred_candidates()) {
+            return m_protoconf->deferred_candidates().value();
+        }
+
+        return default_deferred_candidates;
+    }
+
+    bool prefetch_candidates() override {
+        if (m_protoconf->has_prefetch_candidates()) {
+            return m_protoconf->prefetch_candidates().value();
+        }
+
+        return default_prefetch_candidates;
+    }
+
+    int prefetch_budget_ms() override {
+        if (m_protoconf->prefetch_budget_ms() != 0) {
+            return static_cast<int>(m_protoconf->prefetch_budget_ms());
+        }
+
+        return default_prefetch_budget_ms;
+    }
+
+    int sentence_beam_width() override {
+        if (m_protoconf->sentence_beam_width() != 0) {
+            return static_cast<int>((std::min)(m_protoconf->sentence_beam_width(), kMaxSentenceLimit));
+        }
+
+        return default_sentence_beam_width;
+    }
+
+    int sentence_max_results() override {
+        if (m_protoconf->sentence_max_results() != 0) {
+            return static_cast<int>((std::min)(m_protoconf->sentence_max_results(), kMaxSentenceLimit));
+        }
+
+        return default_sentence_max_results;
+    }
+
     char telex_t2() override {
         if (m_protoconf->has_key_config()) {
             auto const &keyconf = m_protoconf->key_config();
@@ -211,6 +258,11 @@ class ConfigImpl : public Config {
     bool default_telex_enabled = false;
     bool default_dotted_khin = true;
     bool default_autokhin = true;
+    bool default_deferred_candidates = false;
+    bool default_prefetch_candidates = false;
+    int default_prefetch_budget_ms = 20;
+    int default_sentence_beam_width = 8;
+    int default_sentence_max_results = 5;
     std::string default_nasal = "nn";
     std::string default_dotaboveright = "ou";
     char default_dotsbelow = 'r';
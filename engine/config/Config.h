@@ -44,6 +44,11 @@ class Config {
     virtual bool dotted_khin() = 0;
     virtual bool autokhin() = 0;
     virtual bool telex() = 0;
+    virtual bool deferred_candidates() = 0;
+    virtual bool prefetch_candidates() = 0;
+    virtual int prefetch_budget_ms() = 0;
+    virtual int sentence_beam_width() = 0;
+    virtual int sentence_max_results() = 0;
 
     // Keys
     virtual char telex_t2() = 0;
@@ -72,20 +72,31 @@ class KeyCfgImpl : public KeyConfig, ConfigChangeListener {
     }
 
     bool SetKey(char key, VKey vkey, bool standalone = false) override {
+        auto set = false;
         switch (vkey) {
         case VKey::Nasal:
-            return SetNasal(key, standalone);
+            set = SetNasal(key, standalone);
+            break;
         case VKey::DotAboveRight:
-            return SetDotAboveRight(key, standalone);
+            set = SetDotAboveRight(key, standalone);
+            break;
         case VKey::DotsBelow:
-            return SetDotsBelow(key);
+            set = SetDotsBelow(key);
+            break;
         default:
-            return false;
+            break;
         }
+
+        if (set) {
+            m_conversion_rule_cache.clear();
+            ++m_version;
+        }
+        return set;
     }
 
   private:
     void Reset() {
+        ++m_version;
         m_conversion_rule_cache.clear();
         m_conversion_rule_sets.clear();
         m_key_map.clear();
@@ -167,6 +178,10 @@ class KeyCfgImpl : public KeyConfig, ConfigChangeListener {
         return ret;
     }
 
+    uint64_t version() override {
+        return m_version;
+    }
+
     std::vector<char> GetHyphenKeys() override {
         auto ret = std::vector<char>();
         ret.push_back('-');
@@ -399,6 +414,7 @@ class KeyCfgImpl : public KeyConfig, ConfigChangeListener {
     bool standalone_nasal = false;
     bool standalone_dotaboveright = false;
     bool use_fallback_tone_digits = true;
+    uint64_t m_version = 0;
 };
 
 } // namespace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -62,6 +63,10 @@ class KeyConfig {
     virtual void EnableToneDigitFallback(bool enabled) = 0;
     virtual std::string Convert(std::string const &str) = 0;
     virtual std::string Deconvert(std::string const &str) = 0;
+
+    // Changes whenever a key is set or the keys are reloaded, so that results
+    // computed with the old keys can be told apart
+    virtual uint64_t version() = 0;
 };
 
 } // namespace engine
@@ -0,0 +1,306 @@
+#include "ConversionStore.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace khiin::engine {
+namespace {
+
+struct StoreHeader {
+    uint32_t key_count = 0;
+    uint32_t row_count = 0;
+    uint32_t string_count = 0;
+    uint32_t string_bytes = 0;
+};
+
+// Strings are indices into the string table
+struct ConversionRow {
+    uint32_t order = 0;
+    int32_t input_id = 0;
+    uint32_t input = 0;
+    uint32_t output = 0;
+    uint32_t annotation = 0;
+    int32_t weight = 0;
+    int32_t category = 0;
+};
+
+// Layout, in 4-byte words:
+//   StoreHeader
+//   uint32_t key_rows[key_count + 1]       rows of key i: [key_rows[i], key_rows[i + 1])
+//   uint32_t key_strings[key_count]        string index of each key
+//   ConversionRow rows[row_count]          grouped by key, in given order
+//   uint32_t string_offsets[string_count + 1]
+//   char string_data[string_bytes]
+struct StoreLayout {
+    size_t key_rows = 0;
+    size_t key_strings = 0;
+    size_t rows = 0;
+    size_t string_offsets = 0;
+    size_t string_data = 0;
+    size_t end = 0;
+
+    explicit StoreLayout(StoreHeader const &header) {
+        key_rows = sizeof(StoreHeader);
+        key_strings = key_rows + (size_t(header.key_count) + 1) * sizeof(uint32_t);
+        rows = key_strings + size_t(header.key_count) * sizeof(uint32_t);
+        string_offsets = rows + size_t(header.row_count) * sizeof(ConversionRow);
+        string_data = string_offsets + (size_t(header.string_count) + 1) * sizeof(uint32_t);
+        end = string_data + header.string_bytes;
+    }
+};
+
+class StringTableBuilder {
+  public:
+    StringTableBuilder() : m_offsets{0} {}
+
+    uint32_t Add(std::string_view str) {
+        auto key = std::string(str);
+        if (auto it = m_index.find(key); it != m_index.end()) {
+            return it->second;
+        }
+
+        auto index = static_cast<uint32_t>(m_offsets.size() - 1);
+        m_data.append(str);
+        m_offsets.push_back(static_cast<uint32_t>(m_data.size()));
+        m_index.emplace(std::move(key), index);
+        return index;
+    }
+
+    std::vector<uint32_t> const &offsets() const {
+        return m_offsets;
+    }
+
+    std::string const &data() const {
+        return m_data;
+    }
+
+  private:
+    std::unordered_map<std::string, uint32_t> m_index;
+    std::vector<uint32_t> m_offsets;
+    std::string m_data;
+};
+
+class ConversionStoreImpl : public ConversionStore {
+  public:
+    ConversionStoreImpl(std::string_view data, std::vector<uint32_t> storage) : m_storage(std::move(storage)) {
+        std::memcpy(&m_header, data.data(), sizeof(StoreHeader));
+        auto layout = StoreLayout(m_header);
+        auto const *base = data.data();
+        m_key_rows = reinterpret_cast<uint32_t const *>(base + layout.key_rows);
+        m_key_strings = reinterpret_cast<uint32_t const *>(base + layout.key_strings);
+        m_rows = reinterpret_cast<ConversionRow const *>(base + layout.rows);
+        m_string_offsets = reinterpret_cast<uint32_t const *>(base + layout.string_offsets);
+        m_string_data = base + layout.string_data;
+    }
+
+    void Load(int key_id, std::vector<TaiToken> &output) const override {
+        if (!HasKey(key_id)) {
+            return;
+        }
+
+        for (auto row = m_key_rows[key_id]; row < m_key_rows[key_id + 1]; ++row) {
+            output.push_back(Token(key_id, m_rows[row]));
+        }
+    }
+
+    void Load(std::vector<int> const &key_ids, std::vector<TaiToken> &output) const override {
+        if (key_ids.size() == 1) {
+            Load(key_ids[0], output);
+            return;
+        }
+
+        auto rows = std::vector<std::pair<uint32_t, int>>();
+        for (auto key_id : key_ids) {
+            if (!HasKey(key_id)) {
+                continue;
+            }
+
+            for (auto row = m_key_rows[key_id]; row < m_key_rows[key_id + 1]; ++row) {
+                rows.emplace_back(row, key_id);
+            }
+        }
+
+        std::sort(rows.begin(), rows.end(), [this](auto const &a, auto const &b) {
+            return m_rows[a.first].order < m_rows[b.first].order;
+        });
+
+        output.reserve(output.size() + rows.size());
+        for (auto const &[row, key_id] : rows) {
+            output.push_back(Token(key_id, m_rows[row]));
+        }
+    }
+
+    size_t key_count() const override {
+        return m_header.key_count;
+    }
+
+    size_t size() const override {
+        return m_header.row_count;
+    }
+
+    // Checks that every index in the store is in bounds
+    bool Validate() const {
+        if (m_key_rows[m_header.key_count] != m_header.row_count ||
+            m_string_offsets[m_header.string_count] != m_header.string_bytes) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < m_header.key_count; ++i) {
+            if (m_key_rows[i] > m_key_rows[i + 1] || m_key_strings[i] >= m_header.string_count) {
+                return false;
+            }
+        }
+
+        for (uint32_t i = 0; i < m_header.string_count; ++i) {
+            if (m_string_offsets[i] > m_string_offsets[i + 1]) {
+                return false;
+            }
+        }
+
+        return std::all_of(m_rows, m_rows + m_header.row_count, [this](ConversionRow const &row) {
+            return row.input < m_header.string_count && row.output < m_header.string_count &&
+                   row.annotation < m_header.string_count;
+        });
+    }
+
+    // Interns every string up front, so that Load only reads and may be
+    // called from several threads at once. Requires a valid store.
+    void InternStrings() {
+        m_interned.reserve(m_header.string_count);
+        for (uint32_t i = 0; i < m_header.string_count; ++i) {
+            m_interned.emplace_back(String(i));
+        }
+    }
+
+  private:
+    bool HasKey(int key_id) const {
+        return key_id >= 0 && static_cast<uint32_t>(key_id) < m_header.key_count;
+    }
+
+    std::string_view String(uint32_t index) const {
+        return std::string_view(m_string_data + m_string_offsets[index],
+                                m_string_offsets[index + 1] - m_string_offsets[index]);
+    }
+
+    TaiToken Token(int key_id, ConversionRow const &row) const {
+        auto token = TaiToken();
+        token.input_id = row.input_id;
+        token.key_sequence = m_interned[m_key_strings[key_id]];
+        token.input = m_interned[row.input];
+        token.output = m_interned[row.output];
+        token.annotation = m_interned[row.annotation];
+        token.category = row.category;
+        token.weight = row.weight;
+        return token;
+    }
+
+    std::vector<uint32_t> m_storage;
+    StoreHeader m_header;
+    uint32_t const *m_key_rows = nullptr;
+    uint32_t const *m_key_strings = nullptr;
+    ConversionRow const *m_rows = nullptr;
+    uint32_t const *m_string_offsets = nullptr;
+    char const *m_string_data = nullptr;
+    std::vector<InternedString> m_interned;
+};
+
+template <typename T>
+void Append(std::string &buffer, std::vector<T> const &data) {
+    buffer.append(reinterpret_cast<char const *>(data.data()), data.size() * sizeof(T));
+}
+
+std::unique_ptr<ConversionStoreImpl> MapImpl(std::string_view data, std::vector<uint32_t> storage) {
+    if (data.size() < sizeof(StoreHeader) || reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0) {
+        return nullptr;
+    }
+
+    auto header = StoreHeader();
+    std::memcpy(&header, data.data(), sizeof(StoreHeader));
+    if (StoreLayout(header).end != data.size()) {
+        return nullptr;
+    }
+
+    auto ret = std::make_unique<ConversionStoreImpl>(data, std::move(storage));
+    if (!ret->Validate()) {
+        return nullptr;
+    }
+
+    ret->InternStrings();
+    return ret;
+}
+
+} // namespace
+
+std::string ConversionStore::Compile(std::vector<std::string> const &word_keys,
+                                     std::vector<TaiToken> const &conversions) {
+    auto key_ids = std::unordered_map<std::string_view, uint32_t>();
+    key_ids.reserve(word_keys.size());
+    for (uint32_t i = 0; i < word_keys.size(); ++i) {
+        key_ids.emplace(word_keys[i], i);
+    }
+
+    auto strings = StringTableBuilder();
+    auto key_strings = std::vector<uint32_t>();
+    key_strings.reserve(word_keys.size());
+    for (auto const &key : word_keys) {
+        key_strings.push_back(strings.Add(key));
+    }
+
+    // Group the rows by key id, keeping their given order within each key
+    auto grouped = std::vector<std::vector<ConversionRow>>(word_keys.size());
+    for (uint32_t i = 0; i < conversions.size(); ++i) {
+        auto const &token = conversions[i];
+        auto key_id = key_ids.find(token.key_sequence);
+        if (key_id == key_ids.end()) {
+            continue;
+        }
+
+        auto row = ConversionRow();
+        row.order = i;
+        row.input_id = token.input_id;
+        row.input = strings.Add(token.input);
+        row.output = strings.Add(token.output);
+        row.annotation = strings.Add(token.annotation);
+        row.weight = token.weight;
+        row.category = token.category;
+        grouped[key_id->second].push_back(row);
+    }
+
+    auto key_rows = std::vector<uint32_t>{0};
+    auto rows = std::vector<ConversionRow>();
+    for (auto const &group : grouped) {
+        rows.insert(rows.end(), group.begin(), group.end());
+        key_rows.push_back(static_cast<uint32_t>(rows.size()));
+    }
+
+    auto header = StoreHeader();
+    header.key_count = static_cast<uint32_t>(word_keys.size());
+    header.row_count = static_cast<uint32_t>(rows.size());
+    header.string_count = static_cast<uint32_t>(strings.offsets().size() - 1);
+    header.string_bytes = static_cast<uint32_t>(strings.data().size());
+
+    auto ret = std::string(reinterpret_cast<char const *>(&header), sizeof(StoreHeader));
+    Append(ret, key_rows);
+    Append(ret, key_strings);
+    Append(ret, rows);
+    Append(ret, strings.offsets());
+    ret.append(strings.data());
+    return ret;
+}
+
+std::unique_ptr<ConversionStore> ConversionStore::Create(std::vector<std::string> const &word_keys,
+                                                         std::vector<TaiToken> const &conversions) {
+    auto data = Compile(word_keys, conversions);
+    auto storage = std::vector<uint32_t>((data.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    std::memcpy(storage.data(), data.data(), data.size());
+    auto view = std::string_view(reinterpret_cast<char const *>(storage.data()), data.size());
+    return MapImpl(view, std::move(storage));
+}
+
+std::unique_ptr<ConversionStore> ConversionStore::Map(std::string_view data) {
+    return MapImpl(data, std::vector<uint32_t>());
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "data/Models.h"
+
+namespace khiin::engine {
+
+// The conversions of every dictionary word, held in flat arrays indexed by
+// the word's key id in the word trie, so that candidates can be looked up
+// while typing without going to the database.
+//
+// Conversions keep the order in which they were given, which is the order
+// of the database lookup view (by input frequency, then by weight). Like
+// the frozen trie, a store can be compiled into a byte array and mapped in
+// place from a dictionary image.
+class ConversionStore {
+  public:
+    ConversionStore() = default;
+    ConversionStore(ConversionStore const &) = delete;
+    ConversionStore &operator=(ConversionStore const &) = delete;
+    virtual ~ConversionStore() = default;
+
+    // |word_keys| are the words of the trie in key id order. Conversions
+    // whose key_sequence is not one of |word_keys| are left out.
+    static std::unique_ptr<ConversionStore> Create(std::vector<std::string> const &word_keys,
+                                                   std::vector<TaiToken> const &conversions);
+
+    // Serializes the store into a flat byte array that can be written to
+    // disk and later wrapped in place by Map.
+    static std::string Compile(std::vector<std::string> const &word_keys, std::vector<TaiToken> const &conversions);
+
+    // Wraps |data| produced by Compile without copying it. |data| must be
+    // 4-byte aligned and outlive the returned store. Returns nullptr if
+    // |data| is malformed.
+    static std::unique_ptr<ConversionStore> Map(std::string_view data);
+
+    // Appends the conversions of the word with |key_id| to |output|
+    virtual void Load(int key_id, std::vector<TaiToken> &output) const = 0;
+
+    // Appends the conversions of all of |key_ids| to |output|, in the
+    // order they were given to the store
+    virtual void Load(std::vector<int> const &key_ids, std::vector<TaiToken> &output) const = 0;
+
+    virtual size_t key_count() const = 0;
+    virtual size_t size() const = 0;
+};
+
+} // namespace khiin::engine
@@ -1,10 +1,15 @@
 #include "data/Database.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <mutex>
 #include <regex>
 #include <thread>
 #include <unordered_set>
 
+#include "NGramCounts.h"
+#include "NGramRecorder.h"
 #include "SQL.h"
 
 namespace khiin::engine {
@@ -12,10 +17,59 @@ namespace {
 using namespace db_tables;
 
 constexpr size_t kReservedSyllables = 1500;
+constexpr auto kNGramFlushInterval = std::chrono::seconds(2);
+constexpr size_t kNGramBatchSize = 256;
+
+// Statements run while typing, which are prepared once per connection
+enum class CachedQuery {
+    SelectConversionsNumeric,
+    SelectConversionsTelex,
+    IncrementUnigrams,
+    IncrementBigrams,
+    Count,
+};
+
+class StatementCache {
+  public:
+    explicit StatementCache(SQLite::Database *db) : m_db(db) {}
+
+    // Returns the prepared statement for |query|, reset and with no bindings
+    SQLite::Statement &Get(CachedQuery query) {
+        auto &statement = m_statements[static_cast<size_t>(query)];
+
+        if (!statement) {
+            statement = std::make_unique<SQLite::Statement>(Prepare(query));
+        } else {
+            statement->reset();
+            statement->clearBindings();
+        }
+
+        return *statement;
+    }
+
+  private:
+    SQLite::Statement Prepare(CachedQuery query) {
+        switch (query) {
+        case CachedQuery::SelectConversionsNumeric:
+            return SQL::SelectConversions(*m_db, InputType::Numeric);
+        case CachedQuery::SelectConversionsTelex:
+            return SQL::SelectConversions(*m_db, InputType::Telex);
+        case CachedQuery::IncrementUnigrams:
+            return SQL::IncrementUnigrams(*m_db);
+        default:
+            return SQL::IncrementBigrams(*m_db);
+        }
+    }
+
+    SQLite::Database *m_db = nullptr;
+    std::array<std::unique_ptr<SQLite::Statement>, static_cast<size_t>(CachedQuery::Count)> m_statements;
+};
 
 class DatabaseImpl : public Database {
   public:
-    explicit DatabaseImpl(std::unique_ptr<SQLite::Database> &&handle) : db_handle(std::move(handle)) {}
+    // Without a |recorder|, n-grams are written as they are recorded
+    explicit DatabaseImpl(std::unique_ptr<SQLite::Database> &&handle, std::unique_ptr<NGramRecorder> recorder = nullptr)
+        : db_handle(std::move(handle)), statements(db_handle.get()), recorder(std::move(recorder)) {}
 
   private:
     std::string CurrentConnection() override {
@@ -25,6 +79,17 @@ class DatabaseImpl : public Database {
         return std::string();
     }
 
+    std::string DictionaryFingerprint() override {
+        try {
+            auto query = SQL::SelectDictionaryFingerprint(*db_handle);
+            if (query.executeStep()) {
+                return query.getColumn(0).getString();
+            }
+        } catch (...) {
+        }
+        return std::string();
+    }
+
     void AllWordsByFreq(std::vector<std::string>& output, InputType inputType) override {
         auto query = SQL::SelectAllKeySequences(*db_handle, inputType);
         while (query.executeStep()) {
@@ -42,8 +107,16 @@ class DatabaseImpl : public Database {
     }
 
     void ClearNGramsData() override {
+        if (recorder) {
+            recorder->Flush();
+        }
         SQL::DeleteBigrams(*db_handle).exec();
         SQL::DeleteUnigrams(*db_handle).exec();
+        ngrams.Clear();
+
+        for (auto *listener : ngram_listeners) {
+            listener->OnNGramsCleared();
+        }
     }
 
     void RecordUnigrams(std::vector<std::string> const &grams) override {
@@ -51,7 +124,20 @@ class DatabaseImpl : public Database {
             return;
         }
 
-        SQL::IncrementUnigrams(*db_handle, grams).exec();
+        auto &counts = NGrams();
+        for (auto const &gram : grams) {
+            counts.AddUnigram(gram, 1);
+        }
+        NotifyNGramsChanged(grams);
+
+        if (recorder) {
+            recorder->Record(grams, {});
+            return;
+        }
+
+        auto &query = statements.Get(CachedQuery::IncrementUnigrams);
+        query.bind(1, SQL::JsonArray(grams));
+        query.exec();
     }
 
     void RecordBigrams(std::vector<Bigram> const &grams) override {
@@ -59,70 +145,99 @@ class DatabaseImpl : public Database {
             return;
         }
 
-        SQL::IncrementBigrams(*db_handle, grams).exec();
+        auto &counts = NGrams();
+        auto rgrams = std::vector<std::string>();
+        rgrams.reserve(grams.size());
+        for (auto const &gram : grams) {
+            counts.AddBigram(gram.first, gram.second, 1);
+            rgrams.push_back(gram.second);
+        }
+        NotifyNGramsChanged(rgrams);
+
+        if (recorder) {
+            recorder->Record({}, grams);
+            return;
+        }
+
+        auto &query = statements.Get(CachedQuery::IncrementBigrams);
+        query.bind(1, SQL::JsonArray(grams));
+        query.exec();
     }
 
-    void AddUnigramData(std::vector<std::string *> const &grams, std::vector<TaiToken> &tokens) {
-        auto query = SQL::SelectUnigrams(*db_handle, grams);
+    // Counts are read from the database on first use, and afterwards kept
+    // up to date as n-grams are recorded
+    NGramCounts &NGrams() {
+        if (ngrams_loaded) {
+            return ngrams;
+        }
 
-        while (query.executeStep()) {
-            auto gram = query.getColumn(unigram_freq::gram).getString();
-            auto found = std::find_if(tokens.begin(), tokens.end(), [&gram](TaiToken const &token) {
-                return gram == token.output;
-            });
-            if (found != tokens.end()) {
-                found->unigram_count = query.getColumn(unigram_freq::count).getInt();
-            }
+        auto unigrams = SQL::SelectAllUnigrams(*db_handle);
+        while (unigrams.executeStep()) {
+            ngrams.AddUnigram(unigrams.getColumn(unigram_freq::gram).getString(),
+                              unigrams.getColumn(unigram_freq::count).getInt());
         }
-    }
 
-    void AddBigramData(std::string const &lgram, std::vector<std::string *> const &rgrams,
-                       std::vector<TaiToken> &tokens) {
-        auto query = SQL::SelectBigrams(*db_handle, lgram, rgrams);
-        while (query.executeStep()) {
-            auto gram = query.getColumn(bigram_freq::rgram).getString();
-            auto found = std::find_if(tokens.begin(), tokens.end(), [&gram](TaiToken const &token) {
-                return gram == token.output;
-            });
-            if (found != tokens.end()) {
-                found->bigram_count = query.getColumn(bigram_freq::count).getInt();
-            }
+        auto bigrams = SQL::SelectAllBigrams(*db_handle);
+        while (bigrams.executeStep()) {
+            ngrams.AddBigram(bigrams.getColumn(bigram_freq::lgram).getString(),
+                             bigrams.getColumn(bigram_freq::rgram).getString(),
+                             bigrams.getColumn(bigram_freq::count).getInt());
         }
+
+        ngrams_loaded = true;
+        return ngrams;
     }
 
     void AddNGramsData(std::optional<std::string> const &lgram, std::vector<TaiToken> &tokens) override {
-        if (tokens.empty()) {
-            return;
-        }
+        NGrams().Lookup(lgram, tokens);
+    }
 
-        auto rgrams = std::vector<std::string *>{};
-        for (auto it = tokens.begin(); it != tokens.end(); ++it) {
-            rgrams.push_back(&it->output);
-        }
+    void RegisterNGramChangeListener(NGramChangeListener *listener) override {
+        ngram_listeners.push_back(listener);
+    }
 
-        AddUnigramData(rgrams, tokens);
-        if (lgram) {
-            AddBigramData(lgram.value(), rgrams, tokens);
+    void UnregisterNGramChangeListener(NGramChangeListener *listener) override {
+        ngram_listeners.erase(std::remove(ngram_listeners.begin(), ngram_listeners.end(), listener),
+                              ngram_listeners.end());
+    }
+
+    void NotifyNGramsChanged(std::vector<std::string> const &grams) {
+        for (auto *listener : ngram_listeners) {
+            listener->OnNGramsChanged(grams);
         }
     }
 
     void LoadConversions(std::vector<std::string> &inputs, InputType inputType,
                          std::vector<TaiToken> &outputs) override {
-        auto query = SQL::SelectConversions(*db_handle, inputs, inputType);
+        auto &query = statements.Get(inputType == InputType::Telex ? CachedQuery::SelectConversionsTelex
+                                                                   : CachedQuery::SelectConversionsNumeric);
+        query.bind(1, SQL::JsonArray(inputs));
 
         while (query.executeStep()) {
-            auto token = TaiToken();
-            token.input_id = query.getColumn(conversions::input_id).getInt();
-            token.key_sequence = query.getColumn("key_sequence").getString();
-            token.input = query.getColumn(frequencies::input).getString();
-            token.output = query.getColumn(conversions::output).getString();
-            token.annotation = query.getColumn(conversions::annotation).getString();
-            token.category = query.getColumn(conversions::category).getInt();
-            token.weight = query.getColumn(conversions::weight).getInt();
-            outputs.emplace_back(token);
+            outputs.push_back(ConversionFromRow(query));
         }
     }
 
+    void AllConversions(std::vector<TaiToken> &output, InputType inputType) override {
+        auto query = SQL::SelectAllConversions(*db_handle, inputType);
+
+        while (query.executeStep()) {
+            output.push_back(ConversionFromRow(query));
+        }
+    }
+
+    static TaiToken ConversionFromRow(SQLite::Statement &query) {
+        auto token = TaiToken();
+        token.input_id = query.getColumn(conversions::input_id).getInt();
+        token.key_sequence = query.getColumn("key_sequence").getString();
+        token.input = query.getColumn(frequencies::input).getString();
+        token.output = query.getColumn(conversions::output).getString();
+        token.annotation = query.getColumn(conversions::annotation).getString();
+        token.category = query.getColumn(conversions::category).getInt();
+        token.weight = query.getColumn(conversions::weight).getInt();
+        return token;
+    }
+
     //void ConversionsByInputId(int input_id, std::vector<TaiToken> &conversions) override {
     //    auto query = SQL::SelectConversions(*db_handle, input_id);
 
@@ -164,6 +279,11 @@ class DatabaseImpl : public Database {
     }
 
     std::unique_ptr<SQLite::Database> db_handle;
+    StatementCache statements;
+    NGramCounts ngrams;
+    bool ngrams_loaded = false;
+    std::vector<NGramChangeListener *> ngram_listeners;
+    std::unique_ptr<NGramRecorder> recorder;
 };
 
 } // namespace
@@ -180,7 +300,12 @@ std::unique_ptr<Database> Database::TestDb() {
 std::unique_ptr<Database> Database::Connect(std::string const &db_filename) {
     try {
         auto handle = std::make_unique<SQLite::Database>(db_filename, SQLite::OPEN_READWRITE);
-        return std::make_unique<DatabaseImpl>(std::move(handle));
+        auto recorder = std::unique_ptr<NGramRecorder>();
+        try {
+            recorder = std::make_unique<NGramRecorder>(db_filename, kNGramFlushInterval, kNGramBatchSize);
+        } catch (...) {
+        }
+        return std::make_unique<DatabaseImpl>(std::move(handle), std::move(recorder));
     } catch (...) {
         return TestDb();
     }
@@ -16,6 +16,16 @@
 
 namespace khiin::engine {
 
+// Told when recorded n-gram counts change, so that anything ranked with
+// the old counts can be dropped
+class NGramChangeListener {
+  public:
+    // |grams| are the outputs whose unigram count, or bigram count following
+    // any left gram, has changed
+    virtual void OnNGramsChanged(std::vector<std::string> const &grams) = 0;
+    virtual void OnNGramsCleared() = 0;
+};
+
 class Database {
   public:
     using Bigram = std::pair<std::string, std::string>;
@@ -31,6 +41,11 @@ class Database {
 
     virtual std::string CurrentConnection() = 0;
 
+    // Identifies the current contents of the (read-only) dictionary tables,
+    // used to tell whether a compiled dictionary image is out of date.
+    // Empty if it cannot be determined.
+    virtual std::string DictionaryFingerprint() = 0;
+
     virtual void ClearNGramsData() = 0;
 
     virtual void RecordUnigrams(std::vector<std::string> const &grams) = 0;
@@ -39,6 +54,9 @@ class Database {
 
     virtual void AddNGramsData(std::optional<std::string> const &lgram, std::vector<TaiToken> &tokens) = 0;
 
+    virtual void RegisterNGramChangeListener(NGramChangeListener *listener) = 0;
+    virtual void UnregisterNGramChangeListener(NGramChangeListener *listener) = 0;
+
     virtual void LoadSyllables(std::vector<std::string> &syllables) = 0;
 
     virtual void AllWordsByFreq(std::vector<std::string> &output, InputType inputType) = 0;
@@ -46,6 +64,9 @@ class Database {
     virtual void LoadConversions(std::vector<std::string> &inputs, InputType inputType,
                                  std::vector<TaiToken> &outputs) = 0;
 
+    // Every conversion of every key sequence, in lookup order
+    virtual void AllConversions(std::vector<TaiToken> &output, InputType inputType) = 0;
+
     // virtual void ConversionsByInputId(int input_id, std::vector<TaiToken> &conversions) = 0;
 
     virtual void LoadPunctuation(std::vector<Punctuation> &output) = 0;
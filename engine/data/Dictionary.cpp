@@ -7,7 +7,9 @@
 #include "input/Lomaji.h"
 #include "input/SyllableParser.h"
 
+#include "ConversionStore.h"
 #include "Database.h"
+#include "DictionaryImage.h"
 #include "Engine.h"
 #include "Splitter.h"
 #include "Trie.h"
@@ -30,23 +32,30 @@ class DictionaryImpl : public Dictionary {
 
   private:
     void Initialize() override {
-        LoadKeySequences();
-        BuildWordTrie();
+        if (!LoadImage()) {
+            BuildWordTables();
+        }
         BuildSyllableTrie();
+        m_word_cursor = Trie::Cursor(m_word_trie.get());
         BuildWordSplitter();
         LoadPunctuation();
         m_engine->RegisterConfigChangedListener(this);
     }
 
     void Uninitialize() override {
+        m_word_cursor = Trie::Cursor();
+        m_syllable_cursor = Trie::Cursor();
         m_word_trie.reset(nullptr);
+        m_conversions.reset(nullptr);
         m_word_splitter.reset(nullptr);
         m_syllable_trie.reset(nullptr);
+        m_image.reset(nullptr);
         m_input_ids.clear();
         m_user_inputs.clear();
         m_token_cache.clear();
         m_input_id_token_cache.clear();
-        m_key_sequences.clear();
+        m_word_count = 0;
+        m_syllable_keys_version = 0;
         m_punctuation.clear();
     }
 
@@ -69,11 +78,25 @@ class DictionaryImpl : public Dictionary {
             query = query.substr(0, query.size() - 1);
         }
 
-        return m_syllable_trie->HasKeyOrPrefix(query);
+        m_syllable_cursor.Seek(query);
+        return m_syllable_cursor.IsKeyOrPrefix();
+    }
+
+    size_t LongestSyllablePrefix(std::string_view query) const override {
+        m_syllable_cursor.Seek(query);
+        auto ret = m_syllable_cursor.matched_size();
+
+        // A trailing tone key is not part of the syllable input
+        if (ret < query.size() && Lomaji::NeedsToneDiacritic(m_engine->keyconfig()->CheckToneKey(query[ret]))) {
+            ++ret;
+        }
+
+        return ret;
     }
 
     bool IsWordPrefix(std::string_view query) const override {
-        return m_word_trie->HasKeyOrPrefix(query);
+        m_word_cursor.Seek(query);
+        return m_word_cursor.IsKeyOrPrefix();
     }
 
     bool IsWord(std::string_view query) const override {
@@ -82,25 +105,35 @@ class DictionaryImpl : public Dictionary {
 
     std::vector<TaiToken> WordSearch(std::string const &query) override {
         auto ret = std::vector<TaiToken>();
-        auto words = std::vector<std::string>();
-        words.push_back(query);
-        m_engine->database()->LoadConversions(words, InputType::Numeric, ret);
+        m_conversions->Load(m_word_trie->KeyId(query), ret);
         return ret;
     }
 
     std::vector<TaiToken> Autocomplete(std::string const &query) override {
         auto ret = std::vector<TaiToken>();
         auto words = m_word_trie->Autocomplete(query, 10, 5); // NOLINT
-        m_engine->database()->LoadConversions(words, InputType::Numeric, ret);
+        auto key_ids = std::vector<int>();
+        key_ids.reserve(words.size());
+        for (auto const &word : words) {
+            key_ids.push_back(m_word_trie->KeyId(word));
+        }
+        m_conversions->Load(key_ids, ret);
         return ret;
     }
 
     std::vector<TaiToken> AllWordsFromStart(std::string const &query) override {
         auto ret = std::vector<TaiToken>();
-        auto words = std::vector<std::string>();
-        auto input_size = unicode::u8_size(query);
-        m_word_trie->FindKeys(query, words);
-        m_engine->database()->LoadConversions(words, InputType::Numeric, ret);
+        auto key_ids = std::vector<int>();
+        m_word_cursor.Seek(std::string_view());
+        for (auto ch : query) {
+            if (!m_word_cursor.Advance(ch)) {
+                break;
+            }
+            if (auto key_id = m_word_cursor.KeyId(); key_id >= 0) {
+                key_ids.push_back(key_id);
+            }
+        }
+        m_conversions->Load(key_ids, ret);
         AddUserDictionaryCandidates(query, ret);
         for (auto &token : ret) {
             token.input_size = unicode::u8_size(token.key_sequence);
@@ -127,17 +160,20 @@ class DictionaryImpl : public Dictionary {
 
     std::vector<std::vector<std::string>> Segment(std::string_view query, uint32_t limit) override {
         auto ret = std::vector<std::vector<std::string>>();
-        auto query_lc = unicode::copy_str_tolower(query);
-        auto segmentations = m_word_trie->Multisplit(query_lc, m_word_splitter->cost_map(), limit);
+        m_segment_query.assign(query);
+        unicode::str_tolower(m_segment_query);
+        auto segmentations = m_word_trie->Multisplit(m_segment_query, m_word_splitter->costs(), limit);
+        ret.reserve(segmentations.size());
         for (auto &seg : segmentations) {
             auto vec = std::vector<std::string>();
+            vec.reserve(seg.size());
             auto start = query.begin();
             for (auto idx : seg) {
                 auto end = query.begin() + idx;
                 vec.push_back(std::string(start, end));
                 start = end;
             }
-            ret.push_back(vec);
+            ret.push_back(std::move(vec));
         }
         return ret;
     }
@@ -160,39 +196,86 @@ class DictionaryImpl : public Dictionary {
         return m_word_trie.get();
     };
 
+    Trie *syllable_trie() override {
+        return m_syllable_trie.get();
+    };
+
     void OnConfigChanged(Config *config) override {
-        // Reload with new KeyConfig
+        if (m_engine->keyconfig()->version() != m_syllable_keys_version) {
+            BuildSyllableTrie();
+        }
     }
 
-    void LoadKeySequences() {
-        m_key_sequences.clear();
-        m_engine->database()->AllWordsByFreq(m_key_sequences, InputType::Numeric);
+    bool CompileImage(std::string const &image_file) override {
+        auto *db = m_engine->database();
+        auto key_sequences = std::vector<std::string>();
+        auto conversions = std::vector<TaiToken>();
+        db->AllWordsByFreq(key_sequences, InputType::Numeric);
+        db->AllConversions(conversions, InputType::Numeric);
+        return DictionaryImage::Write(image_file, db->DictionaryFingerprint(), key_sequences, conversions);
     }
 
-    void BuildWordTrie() {
-        m_word_trie = Trie::Create();
+    bool LoadImage() {
+        auto *db = m_engine->database();
+        auto image_file = DictionaryImage::ImageFileFor(db->CurrentConnection());
+        m_image = DictionaryImage::Open(image_file, db->DictionaryFingerprint());
+
+        if (m_image) {
+            m_word_trie = m_image->WordTrie();
+            m_conversions = m_image->Conversions();
+            m_word_count = m_image->WordCount();
+        }
 
-        for (auto &word : m_key_sequences) {
-            m_word_trie->Insert(word);
+        if (!m_word_trie || !m_conversions) {
+            m_word_trie.reset(nullptr);
+            m_conversions.reset(nullptr);
+            m_image.reset(nullptr);
+            m_word_count = 0;
+            return false;
         }
+
+        return true;
+    }
+
+    // The key sequences are only needed to build the trie and conversion
+    // store, which then stand in for them
+    void BuildWordTables() {
+        auto *db = m_engine->database();
+        auto key_sequences = std::vector<std::string>();
+        auto conversions = std::vector<TaiToken>();
+        db->AllWordsByFreq(key_sequences, InputType::Numeric);
+        db->AllConversions(conversions, InputType::Numeric);
+        m_word_trie = Trie::CreateFrozen(key_sequences);
+        m_conversions = ConversionStore::Create(key_sequences, conversions);
+        m_word_count = key_sequences.size();
     }
 
+    // The syllable inputs depend on the KeyConfig, so the syllable trie is
+    // not kept in the image and is rebuilt when the keys change
     void BuildSyllableTrie() {
-        m_syllable_trie = std::unique_ptr<Trie>(Trie::Create());
+        m_syllable_keys_version = m_engine->keyconfig()->version();
+        m_syllable_trie = Trie::CreateFrozen(SyllableInputs());
+        m_syllable_cursor = Trie::Cursor(m_syllable_trie.get());
+    }
+
+    std::vector<std::string> SyllableInputs() {
         auto syllables = std::vector<std::string>();
         auto *parser = m_engine->syllable_parser();
         m_engine->database()->LoadSyllables(syllables);
 
+        auto inputs = std::vector<std::string>();
         for (auto &syl : syllables) {
             auto keys = parser->AsInputSequences(syl);
             for (auto &key : keys) {
-                m_syllable_trie->Insert(key.input);
+                inputs.push_back(std::move(key.input));
             }
         }
+
+        return inputs;
     }
 
     void BuildWordSplitter() {
-        m_word_splitter = std::make_unique<Splitter>(m_key_sequences);
+        m_word_splitter = std::make_unique<Splitter>(m_word_trie.get(), m_word_count);
     }
 
     void LoadPunctuation() {
@@ -237,9 +320,25 @@ class DictionaryImpl : public Dictionary {
     }
 
     Engine *m_engine = nullptr;
+    // Must outlive the tries, which may be mapped from it
+    std::unique_ptr<DictionaryImage> m_image = nullptr;
     std::unique_ptr<Trie> m_word_trie = nullptr;
+    // Number of words the word trie was built from; its key ids are below this
+    size_t m_word_count = 0;
+    // Conversions of each word, by its key id in the word trie
+    std::unique_ptr<ConversionStore> m_conversions = nullptr;
     std::unique_ptr<Splitter> m_word_splitter = nullptr;
     std::unique_ptr<Trie> m_syllable_trie = nullptr;
+    // KeyConfig::version the syllable trie was built with
+    uint64_t m_syllable_keys_version = 0;
+
+    // Reused by Segment to avoid allocating on every keystroke
+    std::string m_segment_query;
+
+    // Kept between calls, so that a query which extends the previous one
+    // only walks the new letters
+    mutable Trie::Cursor m_word_cursor;
+    mutable Trie::Cursor m_syllable_cursor;
 
     // Calculated; depend on KeyConfig
     std::unordered_map<std::string, std::vector<int>> m_input_ids;
@@ -248,7 +347,6 @@ class DictionaryImpl : public Dictionary {
     // From the database
     std::unordered_map<int, TaiToken> m_token_cache;
     std::unordered_map<int, std::vector<TaiToken *>> m_input_id_token_cache;
-    std::vector<std::string> m_key_sequences;
     std::vector<Punctuation> m_punctuation;
 };
 
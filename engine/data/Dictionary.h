@@ -40,14 +40,22 @@ class Dictionary : public ConfigChangeListener {
     virtual bool StartsWithSyllable(std::string_view query) const = 0;
     virtual bool IsWordPrefix(std::string_view query) const = 0;
     virtual bool IsSyllablePrefix(std::string_view query) const = 0;
+    // Length of the longest prefix of |query| such that it and all shorter
+    // prefixes are syllable prefixes
+    virtual size_t LongestSyllablePrefix(std::string_view query) const = 0;
     virtual bool IsWord(std::string_view query) const = 0;
 
     virtual std::vector<Punctuation> SearchPunctuation(std::string const& query) = 0;
 
     virtual void RecordNGrams(Buffer const& buffer) = 0;
 
+    // Writes a DictionaryImage of the current database to |image_file|, which
+    // is used in place of the database on the next Initialize
+    virtual bool CompileImage(std::string const& image_file) = 0;
+
     virtual Splitter* word_splitter() = 0;
     virtual Trie* word_trie() = 0;
+    virtual Trie* syllable_trie() = 0;
 
     // Inherited via ConfigChangeListener
     void OnConfigChanged(Config* config) override = 0;
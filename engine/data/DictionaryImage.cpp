@@ -0,0 +1,216 @@
+#include "DictionaryImage.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "utils/MappedFile.h"
+
+#include "ConversionStore.h"
+#include "Trie.h"
+
+namespace khiin::engine {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr std::array<char, 8> kMagic = {'K', 'H', 'I', 'I', 'N', 'D', 'I', 'C'};
+constexpr uint32_t kFormatVersion = 4;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kSectionAlignment = 8;
+constexpr auto kImageExtension = ".dict";
+
+enum Section : uint32_t {
+    kFingerprint,
+    kWordTrie,
+    kWordKeyOffsets, // uint32_t[n + 1], offsets into kWordKeyData
+    kWordKeyData,
+    kConversions,
+    kSectionCount,
+};
+
+struct SectionEntry {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+struct ImageHeader {
+    std::array<char, 8> magic = kMagic;
+    uint32_t version = kFormatVersion;
+    uint32_t byte_order = kByteOrderMark;
+    std::array<SectionEntry, kSectionCount> sections;
+};
+
+class ImageWriter {
+  public:
+    ImageWriter() : m_buffer(sizeof(ImageHeader), '\0') {}
+
+    void AddSection(Section section, std::string_view data) {
+        m_buffer.resize((m_buffer.size() + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment, '\0');
+        m_header.sections[section] = SectionEntry{m_buffer.size(), data.size()};
+        m_buffer.append(data);
+    }
+
+    template <typename T>
+    void AddSection(Section section, std::vector<T> const &data) {
+        AddSection(section, std::string_view(reinterpret_cast<char const *>(data.data()), data.size() * sizeof(T)));
+    }
+
+    bool Save(std::string const &file) {
+        std::memcpy(m_buffer.data(), &m_header, sizeof(ImageHeader));
+
+        // Write to a temporary file first so that a running engine never
+        // maps a half-written image
+        auto path = fs::u8path(file);
+        auto tmp_path = path;
+        tmp_path += ".tmp";
+
+        {
+            auto out = std::ofstream(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()))) {
+                return false;
+            }
+        }
+
+        auto ec = std::error_code();
+        fs::rename(tmp_path, path, ec);
+        if (ec) {
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+  private:
+    ImageHeader m_header;
+    std::string m_buffer;
+};
+
+class DictionaryImageImpl : public DictionaryImage {
+  public:
+    explicit DictionaryImageImpl(std::unique_ptr<MappedFile> file) : m_file(std::move(file)) {}
+
+    bool Validate(std::string const &fingerprint) {
+        auto data = m_file->data();
+
+        if (data.size() < sizeof(ImageHeader)) {
+            return false;
+        }
+
+        std::memcpy(&m_header, data.data(), sizeof(ImageHeader));
+
+        if (m_header.magic != kMagic || m_header.version != kFormatVersion ||
+            m_header.byte_order != kByteOrderMark) {
+            return false;
+        }
+
+        for (auto const &section : m_header.sections) {
+            if (section.offset % kSectionAlignment != 0 || section.offset > data.size() ||
+                section.size > data.size() - section.offset) {
+                return false;
+            }
+        }
+
+        return !fingerprint.empty() && SectionData(kFingerprint) == fingerprint;
+    }
+
+    std::unique_ptr<Trie> WordTrie() const override {
+        return Trie::MapFrozen(SectionData(kWordTrie));
+    }
+
+    std::unique_ptr<ConversionStore> Conversions() const override {
+        return ConversionStore::Map(SectionData(kConversions));
+    }
+
+    void LoadKeySequences(std::vector<std::string> &output) const override {
+        output.clear();
+
+        auto offsets = SectionData(kWordKeyOffsets);
+        auto data = SectionData(kWordKeyData);
+        auto n_offsets = offsets.size() / sizeof(uint32_t);
+
+        if (n_offsets < 2) {
+            return;
+        }
+
+        output.reserve(n_offsets - 1);
+        auto const *offset = reinterpret_cast<uint32_t const *>(offsets.data());
+        for (size_t i = 0; i + 1 < n_offsets; ++i) {
+            if (offset[i] > offset[i + 1] || offset[i + 1] > data.size()) {
+                output.clear();
+                return;
+            }
+            output.emplace_back(data.substr(offset[i], offset[i + 1] - offset[i]));
+        }
+    }
+
+    size_t WordCount() const override {
+        auto n_offsets = SectionData(kWordKeyOffsets).size() / sizeof(uint32_t);
+        return n_offsets < 2 ? 0 : n_offsets - 1;
+    }
+
+  private:
+    std::string_view SectionData(Section section) const {
+        auto const &entry = m_header.sections[section];
+        return m_file->data().substr(entry.offset, entry.size);
+    }
+
+    std::unique_ptr<MappedFile> m_file;
+    ImageHeader m_header;
+};
+
+} // namespace
+
+std::string DictionaryImage::ImageFileFor(std::string const &db_file) {
+    if (db_file.empty()) {
+        return std::string();
+    }
+
+    return fs::u8path(db_file).replace_extension(kImageExtension).u8string();
+}
+
+bool DictionaryImage::Write(std::string const &image_file, std::string const &fingerprint,
+                            std::vector<std::string> const &word_keys, std::vector<TaiToken> const &conversions) {
+    if (image_file.empty() || fingerprint.empty()) {
+        return false;
+    }
+
+    auto key_offsets = std::vector<uint32_t>();
+    auto key_data = std::string();
+    key_offsets.reserve(word_keys.size() + 1);
+    key_offsets.push_back(0);
+    for (auto const &key : word_keys) {
+        key_data.append(key);
+        key_offsets.push_back(static_cast<uint32_t>(key_data.size()));
+    }
+
+    auto writer = ImageWriter();
+    writer.AddSection(kFingerprint, fingerprint);
+    writer.AddSection(kWordTrie, Trie::CompileFrozen(word_keys));
+    writer.AddSection(kWordKeyOffsets, key_offsets);
+    writer.AddSection(kWordKeyData, key_data);
+    writer.AddSection(kConversions, ConversionStore::Compile(word_keys, conversions));
+    return writer.Save(image_file);
+}
+
+std::unique_ptr<DictionaryImage> DictionaryImage::Open(std::string const &image_file, std::string const &fingerprint) {
+    if (image_file.empty()) {
+        return nullptr;
+    }
+
+    auto file = MappedFile::Open(image_file);
+    if (!file) {
+        return nullptr;
+    }
+
+    auto ret = std::make_unique<DictionaryImageImpl>(std::move(file));
+    if (!ret->Validate(fingerprint)) {
+        return nullptr;
+    }
+
+    return ret;
+}
+
+} // namespace khiin::engine
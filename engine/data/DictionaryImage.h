@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "data/Models.h"
+
+namespace khiin::engine {
+
+class ConversionStore;
+class Trie;
+
+// A precompiled, versioned snapshot of the system dictionary tables. The
+// image is memory-mapped at startup and its tries are used in place, so the
+// dictionary does not need to re-read and rebuild everything from SQLite.
+//
+// Layout: a fixed header (magic, format version, byte order, section table)
+// followed by 8-byte aligned sections. The database fingerprint is stored
+// in the image; an image whose fingerprint or format version does not match
+// is treated as stale and ignored.
+class DictionaryImage {
+  public:
+    DictionaryImage() = default;
+    DictionaryImage(DictionaryImage const &) = delete;
+    DictionaryImage &operator=(DictionaryImage const &) = delete;
+    virtual ~DictionaryImage() = default;
+
+    // Default image location for a database file, e.g. khiin.db -> khiin.dict
+    static std::string ImageFileFor(std::string const &db_file);
+
+    // |word_keys| must be ordered by frequency, and |conversions| are those
+    // of the words in lookup order. Returns false if the image could not be
+    // written.
+    static bool Write(std::string const &image_file, std::string const &fingerprint,
+                      std::vector<std::string> const &word_keys, std::vector<TaiToken> const &conversions);
+
+    // Returns nullptr if |image_file| is missing, malformed, built by a
+    // different format version, or does not match |fingerprint|.
+    static std::unique_ptr<DictionaryImage> Open(std::string const &image_file, std::string const &fingerprint);
+
+    // The returned tries and store read directly from the mapped image, and
+    // must not outlive it.
+    virtual std::unique_ptr<Trie> WordTrie() const = 0;
+    virtual std::unique_ptr<ConversionStore> Conversions() const = 0;
+
+    // Word key sequences in frequency order
+    virtual void LoadKeySequences(std::vector<std::string> &output) const = 0;
+    virtual size_t WordCount() const = 0;
+};
+
+} // namespace khiin::engine
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
+
+#include "StringPool.h"
 
 namespace khiin::engine {
 
@@ -9,21 +12,25 @@ struct InputByFreq {
     std::string input;
 };
 
+// Tokens are copied into every candidate and buffer element that uses them,
+// so their strings are interned and a token is trivially copyable
 struct TaiToken {
     bool custom = false;
     int chhan_id = 0;
     int input_id = 0;
-    std::string key_sequence;
-    std::string input;
-    std::string output;
+    InternedString key_sequence;
+    InternedString input;
+    InternedString output;
     int weight = 0;
     int category = 0;
-    std::string annotation;
+    InternedString annotation;
     size_t input_size = 0;
     size_t bigram_count = 0;
     size_t unigram_count = 0;
 };
 
+static_assert(std::is_trivially_copyable_v<TaiToken>);
+
 struct Gram {
     std::string value;
     int count = 0;
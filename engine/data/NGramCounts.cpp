@@ -0,0 +1,87 @@
+#include "NGramCounts.h"
+
+#include <algorithm>
+
+namespace khiin::engine {
+
+void NGramCounts::AddUnigram(std::string const &gram, int count) {
+    m_unigrams[Intern(gram)] += count;
+}
+
+void NGramCounts::AddBigram(std::string const &lgram, std::string const &rgram, int count) {
+    m_bigrams[BigramKey(Intern(lgram), Intern(rgram))] += count;
+}
+
+int NGramCounts::UnigramCount(std::string const &gram) const {
+    auto id = Find(gram);
+    return id == kNotFound ? 0 : m_unigrams[id];
+}
+
+int NGramCounts::BigramCount(std::string const &lgram, std::string const &rgram) const {
+    auto lid = Find(lgram);
+    auto rid = Find(rgram);
+    if (lid == kNotFound || rid == kNotFound) {
+        return 0;
+    }
+
+    auto it = m_bigrams.find(BigramKey(lid, rid));
+    return it == m_bigrams.end() ? 0 : it->second;
+}
+
+void NGramCounts::Lookup(std::optional<std::string> const &lgram, std::vector<TaiToken> &tokens) const {
+    auto lid = lgram ? Find(lgram.value()) : kNotFound;
+    auto counted = std::vector<uint32_t>();
+
+    for (auto &token : tokens) {
+        auto id = Find(token.output.view());
+        if (id != kNotFound) {
+            if (std::find(counted.begin(), counted.end(), id) != counted.end()) {
+                id = kNotFound;
+            } else {
+                counted.push_back(id);
+            }
+        }
+
+        token.unigram_count = id == kNotFound ? 0 : m_unigrams[id];
+
+        if (!lgram) {
+            continue;
+        }
+
+        token.bigram_count = 0;
+        if (lid != kNotFound && id != kNotFound) {
+            if (auto it = m_bigrams.find(BigramKey(lid, id)); it != m_bigrams.end()) {
+                token.bigram_count = it->second;
+            }
+        }
+    }
+}
+
+void NGramCounts::Clear() {
+    m_ids.clear();
+    m_grams.clear();
+    m_unigrams.clear();
+    m_bigrams.clear();
+}
+
+uint32_t NGramCounts::Intern(std::string_view gram) {
+    if (auto it = m_ids.find(gram); it != m_ids.end()) {
+        return it->second;
+    }
+
+    auto id = static_cast<uint32_t>(m_grams.size());
+    m_ids.emplace(m_grams.emplace_back(gram), id);
+    m_unigrams.push_back(0);
+    return id;
+}
+
+uint32_t NGramCounts::Find(std::string_view gram) const {
+    auto it = m_ids.find(gram);
+    return it == m_ids.end() ? kNotFound : it->second;
+}
+
+uint64_t NGramCounts::BigramKey(uint32_t lgram, uint32_t rgram) {
+    return (static_cast<uint64_t>(lgram) << 32) | rgram; // NOLINT
+}
+
+} // namespace khiin::engine
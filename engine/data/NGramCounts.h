@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "data/Models.h"
+
+namespace khiin::engine {
+
+// Unigram and bigram counts held in memory, so that ranking candidates
+// does not query the database. Grams are numbered in the order they are
+// added: unigram counts are stored by number, and bigram counts by the pair
+// of numbers. The text of each gram is owned by the table rather than
+// interned, since grams come from what the user typed and the StringPool
+// never frees its strings.
+class NGramCounts {
+  public:
+    void AddUnigram(std::string const &gram, int count);
+    void AddBigram(std::string const &lgram, std::string const &rgram, int count);
+
+    int UnigramCount(std::string const &gram) const;
+    int BigramCount(std::string const &lgram, std::string const &rgram) const;
+
+    // Sets the unigram count of each token, and its bigram count following
+    // |lgram| if there is one. Of several tokens with the same output, only
+    // the first gets the counts and the others get zero, as with the
+    // database lookup that this replaces, so recording one conversion of a
+    // homograph does not raise the others.
+    void Lookup(std::optional<std::string> const &lgram, std::vector<TaiToken> &tokens) const;
+
+    void Clear();
+
+  private:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    uint32_t Intern(std::string_view gram);
+    uint32_t Find(std::string_view gram) const;
+    static uint64_t BigramKey(uint32_t lgram, uint32_t rgram);
+
+    // Text of each gram by number. A deque never moves its elements, so
+    // the keys of |m_ids| can refer to them.
+    std::deque<std::string> m_grams;
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+    std::vector<int> m_unigrams;
+    std::unordered_map<uint64_t, int> m_bigrams;
+};
+
+} // namespace khiin::engine
@@ -0,0 +1,119 @@
+#include "NGramRecorder.h"
+
+#include "SQL.h"
+
+namespace khiin::engine {
+
+size_t NGramRecorder::Counts::size() const {
+    return unigrams.size() + bigrams.size();
+}
+
+bool NGramRecorder::Counts::empty() const {
+    return unigrams.empty() && bigrams.empty();
+}
+
+NGramRecorder::NGramRecorder(std::string const &db_file, std::chrono::milliseconds interval, size_t batch_size)
+    : m_db(std::make_unique<SQLite::Database>(db_file, SQLite::OPEN_READWRITE)), m_interval(interval),
+      m_batch_size(batch_size) {
+    // WAL commits do not fsync, and readers on other connections see the
+    // last committed state instead of waiting for the writer
+    m_db->exec("PRAGMA journal_mode = WAL");
+    m_db->exec("PRAGMA synchronous = NORMAL");
+    m_db->exec("PRAGMA busy_timeout = 1000");
+    m_add_unigram = std::make_unique<SQLite::Statement>(SQL::AddUnigramCount(*m_db));
+    m_add_bigram = std::make_unique<SQLite::Statement>(SQL::AddBigramCount(*m_db));
+    m_thread = std::thread(&NGramRecorder::Run, this);
+}
+
+NGramRecorder::~NGramRecorder() {
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void NGramRecorder::Record(std::vector<std::string> const &unigrams, std::vector<Bigram> const &bigrams) {
+    if (unigrams.empty() && bigrams.empty()) {
+        return;
+    }
+
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    for (auto const &gram : unigrams) {
+        ++m_pending.unigrams[gram];
+    }
+    for (auto const &gram : bigrams) {
+        ++m_pending.bigrams[gram];
+    }
+
+    if (m_pending.size() >= m_batch_size) {
+        m_wake.notify_one();
+    }
+}
+
+void NGramRecorder::Flush() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_flush_requested = true;
+    m_wake.notify_one();
+    m_written.wait(lock, [this] {
+        return m_pending.empty() && !m_writing;
+    });
+}
+
+void NGramRecorder::Run() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+
+    while (true) {
+        m_wake.wait_for(lock, m_interval, [this] {
+            return m_stopping || m_flush_requested || m_pending.size() >= m_batch_size;
+        });
+
+        if (!m_pending.empty()) {
+            auto batch = Counts();
+            std::swap(batch, m_pending);
+            m_writing = true;
+            lock.unlock();
+            WriteBatch(batch);
+            lock.lock();
+            m_writing = false;
+            m_written.notify_all();
+            continue;
+        }
+
+        m_flush_requested = false;
+        m_written.notify_all();
+
+        if (m_stopping) {
+            return;
+        }
+    }
+}
+
+// Increments are learning data, so a batch that cannot be written is
+// dropped rather than retried
+void NGramRecorder::WriteBatch(Counts const &batch) {
+    try {
+        auto transaction = SQLite::Transaction(*m_db);
+
+        for (auto const &[gram, count] : batch.unigrams) {
+            m_add_unigram->reset();
+            m_add_unigram->bind(1, gram);
+            m_add_unigram->bind(2, count);
+            m_add_unigram->exec();
+        }
+
+        for (auto const &[gram, count] : batch.bigrams) {
+            m_add_bigram->reset();
+            m_add_bigram->bind(1, gram.first);
+            m_add_bigram->bind(2, gram.second);
+            m_add_bigram->bind(3, count);
+            m_add_bigram->exec();
+        }
+
+        transaction.commit();
+    } catch (...) {
+    }
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace SQLite {
+class Database;
+class Statement;
+} // namespace SQLite
+
+namespace khiin::engine {
+
+// Writes n-gram increments to the database on a background thread, so
+// that committing a composition does not wait on disk I/O.
+//
+// Increments are merged in memory and written in a single transaction when
+// enough have been recorded, when |interval| has passed, or when the
+// recorder is destroyed.
+class NGramRecorder {
+  public:
+    using Bigram = std::pair<std::string, std::string>;
+
+    // Opens a separate connection to |db_file| for writing, and switches the
+    // database to WAL mode so that reads are not blocked by a write
+    NGramRecorder(std::string const &db_file, std::chrono::milliseconds interval, size_t batch_size);
+    NGramRecorder(NGramRecorder const &) = delete;
+    NGramRecorder &operator=(NGramRecorder const &) = delete;
+    ~NGramRecorder();
+
+    void Record(std::vector<std::string> const &unigrams, std::vector<Bigram> const &bigrams);
+
+    // Blocks until everything recorded so far has been written
+    void Flush();
+
+  private:
+    struct Counts {
+        std::unordered_map<std::string, int> unigrams;
+        std::map<Bigram, int> bigrams;
+
+        size_t size() const;
+        bool empty() const;
+    };
+
+    void Run();
+    void WriteBatch(Counts const &batch);
+
+    std::unique_ptr<SQLite::Database> m_db;
+    std::unique_ptr<SQLite::Statement> m_add_unigram;
+    std::unique_ptr<SQLite::Statement> m_add_bigram;
+    std::chrono::milliseconds m_interval;
+    size_t m_batch_size = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_written;
+    // Recorded but not yet picked up by the writer
+    Counts m_pending;
+    bool m_writing = false;
+    bool m_flush_requested = false;
+    bool m_stopping = false;
+
+    std::thread m_thread;
+};
+
+} // namespace khiin::engine
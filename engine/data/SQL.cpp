@@ -7,36 +7,37 @@ namespace {
 using namespace SQLite;
 using namespace khiin::engine::utils;
 
-std::string sql_binder(size_t n, std::string &&sep) {
-    std::string res;
-
-    if (n == 0) {
-        return res;
-    }
-
-    res += sep;
-
-    for (size_t i = 0; i < n - 1; i++) {
-        res += ", " + sep;
+void AppendJsonString(std::string &out, std::string_view str) {
+    static constexpr auto kHex = "0123456789abcdef";
+
+    out.push_back('"');
+    for (auto ch : str) {
+        auto byte = static_cast<unsigned char>(ch);
+        if (ch == '"' || ch == '\\') {
+            out.push_back('\\');
+            out.push_back(ch);
+        } else if (byte < 0x20) { // NOLINT
+            out.append("\\u00");
+            out.push_back(kHex[byte >> 4]);    // NOLINT
+            out.push_back(kHex[byte & 0x0f]); // NOLINT
+        } else {
+            out.push_back(ch);
+        }
     }
-
-    return res;
-}
-
-std::string qmarks(size_t n) {
-    return sql_binder(n, "?");
+    out.push_back('"');
 }
 
-std::string qmark_pairs(size_t n) {
-    return sql_binder(n, "(?, ?)");
-}
-
-std::string gram_pair(size_t n) {
-    return sql_binder(n, "(?, 1)");
-}
-
-std::string gram_triple(size_t n) {
-    return sql_binder(n, "(?, ?, 1)");
+template <typename Container, typename F>
+std::string JsonArrayOf(Container const &values, F &&append_value) {
+    auto ret = std::string("[");
+    for (auto const &value : values) {
+        if (ret.size() > 1) {
+            ret.push_back(',');
+        }
+        append_value(ret, value);
+    }
+    ret.push_back(']');
+    return ret;
 }
 
 } // namespace
@@ -50,10 +51,32 @@ Statement SQL::SelectAllKeySequences(DbHandle &db, InputType inputType) {
     }
 }
 
+Statement SQL::SelectAllConversions(DbHandle &db, InputType inputType) {
+    switch (inputType) {
+    case InputType::Telex:
+        return Statement(db, "SELECT * FROM lookup_telex");
+    default:
+        return Statement(db, "SELECT * FROM lookup_numeric");
+    }
+}
+
 Statement SQL::SelectSyllables(DbHandle &db) {
     return Statement(db, "SELECT input FROM syllables");
 }
 
+// Changes whenever the dictionary tables are regenerated, but not when
+// n-gram counts are recorded
+Statement SQL::SelectDictionaryFingerprint(DbHandle &db) {
+    static constexpr auto sql = R"(
+        SELECT
+            (SELECT count(*) FROM frequency) || ':' || (SELECT ifnull(max(id), 0) FROM frequency) || ':' ||
+            (SELECT count(*) FROM conversions) || ':' || (SELECT ifnull(max(id), 0) FROM conversions) || ':' ||
+            (SELECT count(*) FROM syllables) || ':' || (SELECT ifnull(max(id), 0) FROM syllables) || ':' ||
+            (SELECT ifnull(group_concat(key || '=' || value, ','), '') FROM version)
+    )";
+    return Statement(db, sql);
+}
+
 SQLite::Statement SQL::SelectSymbols(DbHandle &db) {
     return Statement(db, "SELECT * FROM symbols");
 }
@@ -83,115 +106,97 @@ SQLite::Statement SQL::SelectConversions(DbHandle &db, int input_id) {
     return ret;
 }
 
-SQLite::Statement SQL::SelectConversions(DbHandle &db, std::vector<std::string> const &inputs, const InputType input_type) {
+// Lists of values are bound to a single parameter as a JSON array, so
+// that each statement has one fixed text and can be prepared once
+std::string SQL::JsonArray(std::vector<std::string> const &values) {
+    return JsonArrayOf(values, [](std::string &out, std::string const &value) {
+        AppendJsonString(out, value);
+    });
+}
+
+std::string SQL::JsonArray(std::vector<std::pair<std::string, std::string>> const &pairs) {
+    return JsonArrayOf(pairs, [](std::string &out, std::pair<std::string, std::string> const &pair) {
+        out.push_back('[');
+        AppendJsonString(out, pair.first);
+        out.push_back(',');
+        AppendJsonString(out, pair.second);
+        out.push_back(']');
+    });
+}
+
+SQLite::Statement SQL::SelectConversions(DbHandle &db, const InputType input_type) {
     static constexpr auto sql_numeric = R"(
         SELECT *
         FROM lookup_numeric
-        WHERE key_sequence IN (%s)
+        WHERE key_sequence IN (SELECT value FROM json_each(?))
     )";
 
     static constexpr auto sql_telex = R"(
         SELECT *
         FROM lookup_telex
-        WHERE key_sequence IN (%s)
+        WHERE key_sequence IN (SELECT value FROM json_each(?))
     )";
 
-    auto ret = Statement(db, "");
-
     switch (input_type) {
-    case InputType::Numeric:
-        ret = Statement(db, format(sql_numeric, qmarks(inputs.size())));
-        break;
     case InputType::Telex:
-        ret = Statement(db, format(sql_telex, qmarks(inputs.size())));
-        break;
+        return Statement(db, sql_telex);
+    default:
+        return Statement(db, sql_numeric);
     }
+}
 
-    auto i = 1;
-    for (const auto &input : inputs) {
-        ret.bind(i, input);
-        ++i;
-    }
-    return ret;
+SQLite::Statement SQL::SelectAllUnigrams(DbHandle &db) {
+    return Statement(db, "SELECT gram, n FROM unigram_freq");
 }
 
-SQLite::Statement SQL::SelectUnigrams(DbHandle &db, std::vector<std::string *> const &grams) {
+SQLite::Statement SQL::SelectAllBigrams(DbHandle &db) {
+    return Statement(db, "SELECT lgram, rgram, n FROM bigram_freq");
+}
+
+// "WHERE true" resolves the parsing ambiguity between the SELECT and the
+// upsert clause
+SQLite::Statement SQL::IncrementUnigrams(DbHandle &db) {
     static constexpr auto sql = R"(
-        SELECT gram, n
-        FROM unigram_freq
-        WHERE gram in (%s)
+        INSERT INTO unigram_freq (gram, n)
+            SELECT value, 1 FROM json_each(?) WHERE true
+        ON CONFLICT DO UPDATE
+            SET n = n + 1
     )";
 
-    auto ret = Statement(db, format(sql, qmarks(grams.size())));
-    auto i = 1;
-    for (auto *gram : grams) {
-        ret.bind(i, *gram);
-        ++i;
-    }
-    return ret;
+    return Statement(db, sql);
 }
 
-SQLite::Statement SQL::SelectBigrams(DbHandle &db, std::string const &lgram, std::vector<std::string *> const &rgrams) {
+SQLite::Statement SQL::IncrementBigrams(DbHandle &db) {
     static constexpr auto sql = R"(
-        SELECT rgram, n
-        FROM bigram_freq
-        WHERE lgram = ?
-        AND rgram in (%s)
+        INSERT INTO bigram_freq (lgram, rgram, n)
+            SELECT json_extract(value, '$[0]'), json_extract(value, '$[1]'), 1 FROM json_each(?) WHERE true
+        ON CONFLICT DO UPDATE
+            SET n = n + 1
     )";
 
-    auto ret = Statement(db, format(sql, qmarks(rgrams.size())));
-    ret.bind(1, lgram);
-    auto i = 2;
-    for (auto *gram : rgrams) {
-        ret.bind(i, *gram);
-        ++i;
-    }
-    return ret;
+    return Statement(db, sql);
 }
 
-SQLite::Statement SQL::IncrementUnigrams(DbHandle &db, std::vector<std::string> const &grams) {
+SQLite::Statement SQL::AddUnigramCount(DbHandle &db) {
     static constexpr auto sql = R"(
         INSERT INTO unigram_freq (gram, n)
-            VALUES %s
+            VALUES (?, ?)
         ON CONFLICT DO UPDATE
-            SET n = n + 1
-        WHERE gram IN (%s)
+            SET n = n + excluded.n
     )";
 
-    auto size = grams.size();
-    auto ret = Statement(db, format(sql, gram_pair(size), qmarks(size)));
-
-    auto i = 1;
-    for (auto const &gram : grams) {
-        ret.bind(i, gram);
-        ret.bind(i + static_cast<int>(size), gram);
-        ++i;
-    }
-
-    return ret;
+    return Statement(db, sql);
 }
 
-SQLite::Statement SQL::IncrementBigrams(DbHandle &db, std::vector<std::pair<std::string, std::string>> const &bigrams) {
+SQLite::Statement SQL::AddBigramCount(DbHandle &db) {
     static constexpr auto sql = R"(
         INSERT INTO bigram_freq (lgram, rgram, n)
-            VALUES %s
+            VALUES (?, ?, ?)
         ON CONFLICT DO UPDATE
-            SET n = n + 1
-        WHERE (lgram, rgram) IN (VALUES %s )
+            SET n = n + excluded.n
     )";
 
-    auto size = bigrams.size();
-    auto ret = Statement(db, format(sql, gram_triple(size), qmark_pairs(size)));
-    auto i = 1;
-    for (auto const &bigram : bigrams) {
-        ret.bind(i, bigram.first);
-        ret.bind(i + static_cast<int>(size) * 2, bigram.first);
-        ++i;
-        ret.bind(i, bigram.second);
-        ret.bind(i + static_cast<int>(size) * 2, bigram.second);
-        ++i;
-    }
-    return ret;
+    return Statement(db, sql);
 }
 
 SQLite::Statement SQL::DeleteUnigrams(DbHandle &db) {
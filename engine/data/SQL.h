@@ -62,24 +62,29 @@ class SQL {
     using Statement = SQLite::Statement;
     using DbHandle = SQLite::Database;
     static Statement SelectAllKeySequences(DbHandle &db, InputType inputType);
+    static Statement SelectAllConversions(DbHandle &db, InputType inputType);
     static Statement SelectSyllables(DbHandle &db);
+    static Statement SelectDictionaryFingerprint(DbHandle &db);
     static Statement SelectConversions(DbHandle &db, int input_id);
-    static Statement SelectConversions(DbHandle &db, std::vector<std::string> const &inputs,
-                                       InputType input_type);
+    static Statement SelectConversions(DbHandle &db, InputType input_type);
 
     static Statement SelectSymbols(DbHandle &db);
     static Statement SelectEmojis(DbHandle &db);
 
-    // Ngrams
-    static Statement SelectUnigrams(DbHandle &db, std::vector<std::string *> const &grams);
-    static Statement SelectBigrams(DbHandle &db, std::string const &lgram,
-                                           std::vector<std::string *> const &rgrams);
-    static Statement IncrementUnigrams(DbHandle &db, std::vector<std::string> const &grams);
-    static Statement IncrementBigrams(DbHandle &db,
-                                              std::vector<std::pair<std::string, std::string>> const &bigrams);
+    // Ngrams. The grams are bound to a single parameter as a JsonArray.
+    static Statement SelectAllUnigrams(DbHandle &db);
+    static Statement SelectAllBigrams(DbHandle &db);
+    static Statement IncrementUnigrams(DbHandle &db);
+    static Statement IncrementBigrams(DbHandle &db);
+    // Add a merged count to a single gram
+    static Statement AddUnigramCount(DbHandle &db);
+    static Statement AddBigramCount(DbHandle &db);
     static Statement DeleteUnigrams(DbHandle &db);
     static Statement DeleteBigrams(DbHandle &db);
 
+    static std::string JsonArray(std::vector<std::string> const &values);
+    static std::string JsonArray(std::vector<std::pair<std::string, std::string>> const &pairs);
+
     // DummyDb
     static int CreateDummyDb(DbHandle &db);
 };
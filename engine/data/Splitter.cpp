@@ -11,8 +11,6 @@ using namespace std::string_literals;
 
 namespace khiin::engine {
 namespace {
-using WordSet = std::unordered_set<std::string>;
-
 constexpr float kBigNumber = 9e9F;
 
 inline auto isDigit(std::string const &str) {
@@ -23,59 +21,68 @@ inline auto isDigit(std::string const &str) {
     return (s >> d) ? !(s >> c) : false;
 }
 
-struct SplitCheckResult {
-    std::vector<bool> splits_at;
-    std::vector<int> split_indices;
-};
+} // namespace
 
-SplitCheckResult CheckSplittable(WordSet const &words, std::set<size_t> const &invalid_indices,
-                                 std::string_view query) {
-    auto const size = static_cast<int>(query.size());
-    std::vector<bool> splits_at(size + 1, false);
-    std::vector<int> split_indices;
-    split_indices.push_back(-1);
+Splitter::Splitter() {}
 
-    for (int i = 0; i < size; ++i) {
-        if (invalid_indices.count(i) > 0) {
-            continue;
-        }
+Splitter::Splitter(std::vector<std::string> const &words_by_frequency)
+    : m_own_trie(Trie::CreateFrozen(words_by_frequency)), m_trie(m_own_trie.get()), m_cursor(m_trie) {
+    BuildCosts(words_by_frequency.size());
+}
 
-        auto n_splits = static_cast<int>(split_indices.size());
+Splitter::Splitter(Trie const *word_trie, size_t word_count) : m_trie(word_trie), m_cursor(word_trie) {
+    BuildCosts(word_count);
+}
 
-        for (int j = n_splits - 1; j >= 0; j--) {
-            auto substrv =
-                query.substr(static_cast<size_t>(split_indices[j] + 1), static_cast<size_t>(i - split_indices[j]));
+void Splitter::BuildCosts(size_t word_count) {
+    auto log_size = static_cast<float>(std::log(word_count));
 
-            if (words.find(std::string(substrv.begin(), substrv.end())) != words.end()) {
-                splits_at[i] = true;
-                split_indices.push_back(i);
-                break;
-            }
-        }
+    m_costs.reserve(word_count);
+    for (size_t idx = 0; idx < word_count; ++idx) {
+        m_costs.push_back(std::log(static_cast<float>(idx + 1) * log_size));
     }
-
-    return SplitCheckResult{std::move(splits_at), std::move(split_indices)};
 }
 
-} // namespace
+template <typename F>
+void Splitter::ForEachWord(std::string_view input, size_t start, F &&fn) const {
+    m_cursor.Rewind(m_cursor.text().size());
 
-Splitter::Splitter() {}
+    for (auto i = start; i < input.size() && m_cursor.Advance(input[i]); ++i) {
+        if (auto key_id = m_cursor.KeyId(); key_id >= 0 && static_cast<size_t>(key_id) < m_costs.size()) {
+            fn(i + 1, key_id);
+        }
+    }
+}
 
-Splitter::Splitter(std::vector<std::string> const &words_by_frequency) {
-    std::copy(words_by_frequency.cbegin(), words_by_frequency.cend(), std::inserter(m_word_set, m_word_set.begin()));
+size_t Splitter::FindSplits(std::string_view input, std::set<size_t> const *invalid_indices) const {
+    m_reachable.assign(input.size() + 1, 0);
+    m_reachable[0] = 1;
+    size_t last = 0;
 
-    auto log_size = static_cast<float>(std::log(words_by_frequency.size()));
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (m_reachable[i] == 0) {
+            continue;
+        }
 
-    auto idx = 0;
-    for (auto const &it : words_by_frequency) {
-        m_cost_map[it] = std::log(static_cast<float>(idx + 1) * log_size);
-        m_max_word_length = std::max(m_max_word_length, (int)it.size());
-        ++idx;
+        ForEachWord(input, i, [&](size_t end, int) {
+            if (invalid_indices != nullptr && invalid_indices->count(end - 1) > 0) {
+                return;
+            }
+
+            m_reachable[end] = 1;
+            last = std::max(last, end);
+        });
     }
+
+    return last;
 }
 
 size_t Splitter::MaxSplitSize(std::string_view input) const {
-    return MaxSplitSize(input, std::set<size_t>());
+    if (input.empty()) {
+        return 0;
+    }
+
+    return FindSplits(input, nullptr);
 }
 
 size_t Splitter::MaxSplitSize(std::string_view input, std::set<size_t> const &invalid_indices) const {
@@ -83,8 +90,7 @@ size_t Splitter::MaxSplitSize(std::string_view input, std::set<size_t> const &in
         return 0;
     }
 
-    auto result = CheckSplittable(m_word_set, invalid_indices, input);
-    return static_cast<size_t>(result.split_indices.back() + 1);
+    return FindSplits(input, &invalid_indices);
 }
 
 bool Splitter::CanSplit(std::string_view input) const {
@@ -92,8 +98,8 @@ bool Splitter::CanSplit(std::string_view input) const {
         return true;
     }
 
-    auto result = CheckSplittable(m_word_set, std::set<size_t>(), input);
-    return result.splits_at[input.size() - 1];
+    FindSplits(input, nullptr);
+    return m_reachable[input.size()] != 0;
 }
 
 void Splitter::Split(std::string const &input, std::vector<std::string> &result) const {
@@ -102,39 +108,41 @@ void Splitter::Split(std::string const &input, std::vector<std::string> &result)
         return;
     }
 
-    auto const len = static_cast<int>(input.size());
-
-    std::vector<std::pair<float, int>> cost;
-    cost.reserve(len + 1);
-    cost.push_back(std::make_pair(0.0F, -1));
-    auto curr_cost = 0.0F;
-
-    for (auto i = 1; i < len + 1; i++) {
-        auto min_cost = cost[i - 1].first + kBigNumber;
-        auto min_cost_idx = i - 1;
-
-        for (auto j = i - m_max_word_length > 0 ? i - m_max_word_length : 0; j < i; j++) {
-
-            auto chunk = input.substr(j, i - j);
+    auto const len = input.size();
+
+    // |m_best[i]| is the cost of the best split of input[0, i) and the
+    // start of its last piece, or -1 until a word ending at |i| is found.
+    // Words are relaxed from their start, so all words ending at |i| are
+    // known when |i| is reached. A single letter that is not a word is the
+    // fallback, and loses ties.
+    auto settle = [&](size_t i) {
+        auto fallback = m_best[i - 1].first + kBigNumber;
+        if (m_best[i].second == -1 || fallback < m_best[i].first) {
+            m_best[i] = std::make_pair(fallback, static_cast<int>(i - 1));
+        }
+    };
 
-            if (m_cost_map.find(chunk) == m_cost_map.end()) {
-                continue;
-            }
+    m_best.assign(len + 1, std::make_pair(0.0F, -1));
 
-            curr_cost = cost[j].first + m_cost_map.at(chunk);
-            if (curr_cost <= min_cost) {
-                min_cost = curr_cost;
-                min_cost_idx = j;
-            }
+    for (size_t i = 0; i < len; ++i) {
+        if (i != 0) {
+            settle(i);
         }
 
-        cost.push_back(std::make_pair(min_cost, min_cost_idx));
+        ForEachWord(input, i, [&](size_t end, int key_id) {
+            auto cost = m_best[i].first + m_costs[key_id];
+            if (m_best[end].second == -1 || cost <= m_best[end].first) {
+                m_best[end] = std::make_pair(cost, static_cast<int>(i));
+            }
+        });
     }
 
+    settle(len);
+
     size_t n = len;
 
     while (n > 0) {
-        size_t preIndex = cost[n].second;
+        size_t preIndex = m_best[n].second;
         auto insertStr = input.substr(preIndex, n - preIndex);
 
         if (!result.empty() && isDigit(insertStr + result[0])) {
@@ -146,8 +154,115 @@ void Splitter::Split(std::string const &input, std::vector<std::string> &result)
     }
 }
 
-WordCostMap const &Splitter::cost_map() const {
-    return m_cost_map;
+std::vector<float> const &Splitter::costs() const {
+    return m_costs;
+}
+
+//+---------------------------------------------------------------------------
+//
+// Splitter::State
+//
+//----------------------------------------------------------------------------
+
+Splitter::State::State() : State(nullptr) {}
+
+Splitter::State::State(Splitter const *splitter) : m_splitter(splitter), m_reachable{1}, m_max_split{0} {
+    m_words.emplace_back(m_splitter != nullptr ? m_splitter->m_trie : nullptr);
+    m_open.push_back(0);
+}
+
+void Splitter::State::Append(char ch) {
+    m_text.push_back(ch);
+    auto const end = m_text.size();
+    auto reachable = false;
+
+    auto open_end = m_open.begin();
+    for (auto start : m_open) {
+        auto &word = m_words[start];
+        if (!word.Advance(ch)) {
+            continue;
+        }
+
+        if (auto key_id = word.KeyId(); key_id >= 0 && static_cast<size_t>(key_id) < m_splitter->m_costs.size()) {
+            reachable = true;
+        }
+        *open_end++ = start;
+    }
+    m_open.erase(open_end, m_open.end());
+
+    m_reachable.push_back(reachable ? 1 : 0);
+    m_max_split.push_back(reachable ? end : m_max_split.back());
+
+    if (!reachable) {
+        return;
+    }
+
+    if (m_words.size() <= end) {
+        m_words.resize(end + 1, Trie::Cursor(m_splitter->m_trie));
+    }
+    m_words[end].Rewind(m_words[end].text().size());
+    m_open.push_back(end);
+}
+
+void Splitter::State::Append(std::string_view letters) {
+    for (auto ch : letters) {
+        Append(ch);
+    }
+}
+
+void Splitter::State::Truncate(size_t n) {
+    if (n == 0) {
+        return;
+    }
+
+    n = std::min(n, m_text.size());
+    m_text.resize(m_text.size() - n);
+    m_reachable.resize(m_text.size() + 1);
+    m_max_split.resize(m_text.size() + 1);
+    ReopenWords();
+}
+
+void Splitter::State::Seek(std::string_view input) {
+    auto mismatch = std::mismatch(m_text.begin(), m_text.end(), input.begin(), input.end());
+    auto common = static_cast<size_t>(std::distance(m_text.begin(), mismatch.first));
+    Truncate(m_text.size() - common);
+    Append(input.substr(common));
+}
+
+void Splitter::State::ReopenWords() {
+    auto const end = m_text.size();
+    m_open.clear();
+
+    for (size_t start = 0; start <= end; ++start) {
+        if (m_reachable[start] == 0) {
+            continue;
+        }
+
+        auto &word = m_words[start];
+        if (auto size = word.text().size(); size > end - start) {
+            word.Rewind(size - (end - start));
+        }
+
+        if (word.valid()) {
+            m_open.push_back(start);
+        }
+    }
+}
+
+Splitter const *Splitter::State::splitter() const {
+    return m_splitter;
+}
+
+std::string_view Splitter::State::text() const {
+    return m_text;
+}
+
+bool Splitter::State::CanSplit() const {
+    return m_reachable.back() != 0;
+}
+
+size_t Splitter::State::MaxSplitSize() const {
+    return m_max_split.back();
 }
 
 } // namespace khiin::engine
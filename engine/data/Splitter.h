@@ -2,32 +2,109 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
-#include <unordered_map>
 
 #include "utils/common.h"
 #include "utils/errors.h"
 
+#include "Trie.h"
+
 namespace khiin::engine {
-using WordCostMap = std::unordered_map<std::string, float>;
 
 // Can determine whether a string may be split by the words contained in it,
 // and can attempt to perform the best split (when the imported word list is
 // sorted by frequency)
+//
+// Words are looked up by walking a trie, so queries do not allocate once
+// the splitter's scratch buffers have grown to the input size. A splitter
+// is not safe to use from several threads at once.
 class Splitter {
   public:
+    /**
+     * The split table of an input that grows or shrinks by a few letters at
+     * a time, as the composition does while typing. Appending a letter only
+     * advances the words that are still open at the end of the input, and
+     * erasing truncates the table, so neither walks the input from the
+     * start again.
+     *
+     * A state must not outlive the splitter it was created from.
+     */
+    class State {
+      public:
+        State();
+        explicit State(Splitter const *splitter);
+
+        void Append(char ch);
+        void Append(std::string_view letters);
+
+        // Removes the last |n| letters, or all of them
+        void Truncate(size_t n);
+
+        // Moves to |input|, keeping the table for the part it shares with
+        // the current input
+        void Seek(std::string_view input);
+
+        Splitter const *splitter() const;
+        std::string_view text() const;
+
+        // Same as Splitter::CanSplit and Splitter::MaxSplitSize for text()
+        bool CanSplit() const;
+        size_t MaxSplitSize() const;
+
+      private:
+        // Rebuilds |m_open| after truncating
+        void ReopenWords();
+
+        Splitter const *m_splitter = nullptr;
+        std::string m_text;
+        // Per prefix length: whether it splits, and its longest split
+        std::vector<uint8_t> m_reachable;
+        std::vector<size_t> m_max_split;
+        // Word being read from each split position; kept when truncated so
+        // that their buffers are reused
+        std::vector<Trie::Cursor> m_words;
+        // Split positions whose word may still continue at the end
+        std::vector<size_t> m_open;
+    };
+
     Splitter();
     explicit Splitter(std::vector<std::string> const &words);
+
+    // Uses |word_trie|, which must be built from a list of |word_count|
+    // words sorted by frequency and outlive the splitter, instead of
+    // building another trie
+    Splitter(Trie const *word_trie, size_t word_count);
+
     size_t MaxSplitSize(std::string_view input) const;
     size_t MaxSplitSize(std::string_view input, std::set<size_t> const &invalid_indices) const;
     bool CanSplit(std::string_view input) const;
     void Split(std::string const &input, std::vector<std::string> &result) const;
-    WordCostMap const &cost_map() const;
+
+    // Cost of each word, indexed by its position in the word list. Tries
+    // built from the same list use these positions as key ids.
+    std::vector<float> const &costs() const;
 
   private:
-    std::unordered_set<std::string> m_word_set;
-    WordCostMap m_cost_map;
-    int m_max_word_length = 0;
+    void BuildCosts(size_t word_count);
+
+    // Marks in |m_reachable| every position that |input| can be split at
+    // from the start, leaving out splits at |invalid_indices| (the index of
+    // the last letter before the split). Returns the last such position.
+    size_t FindSplits(std::string_view input, std::set<size_t> const *invalid_indices) const;
+
+    // Calls fn(end, key_id) for each word input[start, end)
+    template <typename F>
+    void ForEachWord(std::string_view input, size_t start, F &&fn) const;
+
+    std::unique_ptr<Trie> m_own_trie;
+    Trie const *m_trie = nullptr;
+    std::vector<float> m_costs;
+
+    // Scratch space reused between queries
+    mutable Trie::Cursor m_cursor;
+    mutable std::vector<uint8_t> m_reachable;
+    mutable std::vector<std::pair<float, int>> m_best;
 };
 
 } // namespace khiin::engine
@@ -0,0 +1,138 @@
+#include "StringPool.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace khiin::engine {
+namespace {
+
+// Ids index a table of fixed-size blocks, which are never moved once
+// published, so that resolving an id needs no lock
+constexpr size_t kBlockBits = 12;
+constexpr size_t kBlockSize = size_t(1) << kBlockBits;
+constexpr size_t kMaxBlocks = 4096;
+constexpr size_t kArenaChunkSize = 64 * 1024;
+
+class Pool {
+  public:
+    Pool() {
+        auto lock = std::unique_lock<std::shared_mutex>(m_mutex);
+        Add(std::string_view());
+    }
+
+    uint32_t Intern(std::string_view str) {
+        if (str.empty()) {
+            return 0;
+        }
+
+        {
+            auto lock = std::shared_lock<std::shared_mutex>(m_mutex);
+            if (auto it = m_ids.find(str); it != m_ids.end()) {
+                return it->second;
+            }
+        }
+
+        auto lock = std::unique_lock<std::shared_mutex>(m_mutex);
+        if (auto it = m_ids.find(str); it != m_ids.end()) {
+            return it->second;
+        }
+        return Add(str);
+    }
+
+    std::string_view Resolve(uint32_t id) const {
+        auto *block = m_blocks[id >> kBlockBits].load(std::memory_order_acquire);
+        return block[id & (kBlockSize - 1)];
+    }
+
+    size_t size() {
+        auto lock = std::shared_lock<std::shared_mutex>(m_mutex);
+        return m_size;
+    }
+
+  private:
+    // Requires the unique lock
+    uint32_t Add(std::string_view str) {
+        if (m_size == kBlockSize * kMaxBlocks) {
+            throw std::length_error("StringPool is full");
+        }
+
+        auto id = static_cast<uint32_t>(m_size);
+        auto block_index = id >> kBlockBits;
+        auto *block = m_blocks[block_index].load(std::memory_order_relaxed);
+
+        if (block == nullptr) {
+            block = new std::string_view[kBlockSize];
+            m_blocks[block_index].store(block, std::memory_order_release);
+        }
+
+        auto stored = Store(str);
+        block[id & (kBlockSize - 1)] = stored;
+        m_ids.emplace(stored, id);
+        ++m_size;
+        return id;
+    }
+
+    // Copies |str| into the arena, which is never moved or freed
+    std::string_view Store(std::string_view str) {
+        if (str.size() > kArenaChunkSize / 4) {
+            auto &chunk = m_large.emplace_back(std::make_unique<char[]>(str.size()));
+            std::copy(str.begin(), str.end(), chunk.get());
+            return std::string_view(chunk.get(), str.size());
+        }
+
+        if (m_chunks.empty() || kArenaChunkSize - m_chunk_used < str.size()) {
+            m_chunks.push_back(std::make_unique<char[]>(kArenaChunkSize));
+            m_chunk_used = 0;
+        }
+
+        auto *dest = m_chunks.back().get() + m_chunk_used;
+        std::copy(str.begin(), str.end(), dest);
+        m_chunk_used += str.size();
+        return std::string_view(dest, str.size());
+    }
+
+    std::shared_mutex m_mutex;
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+    std::array<std::atomic<std::string_view *>, kMaxBlocks> m_blocks = {};
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    std::vector<std::unique_ptr<char[]>> m_large;
+    size_t m_chunk_used = 0;
+    size_t m_size = 0;
+};
+
+// Never destroyed, so that interned strings stay valid in static destructors
+Pool &Instance() {
+    static auto *pool = new Pool();
+    return *pool;
+}
+
+} // namespace
+
+uint32_t StringPool::Intern(std::string_view str) {
+    return Instance().Intern(str);
+}
+
+std::string_view StringPool::Resolve(uint32_t id) {
+    return Instance().Resolve(id);
+}
+
+size_t StringPool::size() {
+    return Instance().size();
+}
+
+std::ostream &operator<<(std::ostream &os, InternedString const &str) {
+    return os << str.view();
+}
+
+std::string operator+(std::string lhs, InternedString rhs) {
+    return lhs.append(rhs.view());
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace khiin::engine {
+
+// A string kept in the process-wide StringPool, referred to by its id. Equal
+// strings have equal ids, so copying and comparing is as cheap as for an int,
+// and the text is only looked up when it is read. Interned strings are never
+// freed, so only strings from a bounded set such as the dictionary should
+// be interned.
+class InternedString {
+  public:
+    using const_iterator = std::string_view::const_iterator;
+
+    InternedString() = default;
+    InternedString(std::string_view str);
+    InternedString(std::string const &str);
+    InternedString(char const *str);
+
+    std::string_view view() const;
+    operator std::string_view() const {
+        return view();
+    }
+
+    uint32_t id() const {
+        return m_id;
+    }
+
+    bool empty() const {
+        return m_id == 0;
+    }
+
+    size_t size() const {
+        return view().size();
+    }
+
+    char const *data() const {
+        return view().data();
+    }
+
+    const_iterator begin() const {
+        return view().begin();
+    }
+
+    const_iterator end() const {
+        return view().end();
+    }
+
+    const_iterator cbegin() const {
+        return view().cbegin();
+    }
+
+    const_iterator cend() const {
+        return view().cend();
+    }
+
+    friend bool operator==(InternedString lhs, InternedString rhs) {
+        return lhs.m_id == rhs.m_id;
+    }
+
+    friend bool operator!=(InternedString lhs, InternedString rhs) {
+        return lhs.m_id != rhs.m_id;
+    }
+
+    // By text, not by id
+    friend bool operator<(InternedString lhs, InternedString rhs) {
+        return lhs.view() < rhs.view();
+    }
+
+    friend bool operator==(InternedString lhs, std::string_view rhs) {
+        return lhs.view() == rhs;
+    }
+
+    friend bool operator==(InternedString lhs, std::string const &rhs) {
+        return lhs.view() == rhs;
+    }
+
+    friend bool operator==(InternedString lhs, char const *rhs) {
+        return lhs.view() == rhs;
+    }
+
+    template <typename StrT>
+    friend bool operator==(StrT const &lhs, InternedString rhs) {
+        return rhs == lhs;
+    }
+
+    template <typename StrT>
+    friend bool operator!=(InternedString lhs, StrT const &rhs) {
+        return !(lhs == rhs);
+    }
+
+    template <typename StrT>
+    friend bool operator!=(StrT const &lhs, InternedString rhs) {
+        return !(rhs == lhs);
+    }
+
+  private:
+    uint32_t m_id = 0;
+};
+
+std::ostream &operator<<(std::ostream &os, InternedString const &str);
+std::string operator+(std::string lhs, InternedString rhs);
+
+// Append-only table of the strings behind InternedString. Interning looks
+// the string up in a hash table; reading an interned string takes no lock.
+class StringPool {
+  public:
+    // Id of |str|, adding it if it is not in the pool yet. The empty string
+    // has id 0. Throws std::length_error if |str| is new and the pool
+    // already holds as many strings as it can address.
+    static uint32_t Intern(std::string_view str);
+
+    // |id| must have been returned by Intern
+    static std::string_view Resolve(uint32_t id);
+
+    // Number of strings in the pool, including the empty string
+    static size_t size();
+};
+
+inline InternedString::InternedString(std::string_view str) : m_id(StringPool::Intern(str)) {}
+
+inline InternedString::InternedString(std::string const &str) : m_id(StringPool::Intern(str)) {}
+
+inline InternedString::InternedString(char const *str) : m_id(StringPool::Intern(str)) {}
+
+inline std::string_view InternedString::view() const {
+    return StringPool::Resolve(m_id);
+}
+
+} // namespace khiin::engine
+
+template <>
+struct std::hash<khiin::engine::InternedString> {
+    size_t operator()(khiin::engine::InternedString const &str) const noexcept {
+        return std::hash<uint32_t>()(str.id());
+    }
+};
@@ -5,10 +5,10 @@
 #include <algorithm>
 #include <array>
 #include <assert.h>
-#include <bitset>
 #include <deque>
+#include <functional>
 #include <iterator>
-#include <queue>
+#include <type_traits>
 #include <unordered_map>
 
 #include "Splitter.h"
@@ -17,118 +17,208 @@ namespace khiin::engine {
 
 namespace {
 
-struct SplitCost {
-    bool operator<(SplitCost const &rhs) const {
-        return cost < rhs.cost;
-    }
-    uint64_t split = 0;
+constexpr uint32_t kMaxReservedSplits = 64;
+
+/**
+ * A key spanning the query from row |from| to the row it is linked into.
+ * |next| is the next edge into the same row, or -1.
+ */
+struct LatticeEdge {
+    int32_t from = -1;
     float cost = 0.0F;
+    int32_t next = -1;
 };
 
 /**
- * |vec| is sorted by cost from low to high.
- * If size of |vec| is under the limit, push back directly.
- * Otherwise, check cost against the last element (highest cost), and
- * replace/re-sort only if it is cheaper.
+ * A segmentation of the query up to some row: the |prev_rank|-th best
+ * segmentation of the row that |edge| starts from, followed by |edge|.
+ * The empty segmentation at row 0 has no edge.
  */
-void SaveIfCheaper(std::vector<SplitCost> &vec, int limit, uint64_t split, float cost) {
-    if (static_cast<int>(vec.size()) < limit) {
-        vec.push_back(SplitCost{split, cost});
-        std::sort(vec.begin(), vec.end());
-    } else {
-        if (cost < vec.back().cost) {
-            vec.back().split = split;
-            vec.back().cost = cost;
-            std::sort(vec.begin(), vec.end());
-        }
+struct LatticePath {
+    bool operator>(LatticePath const &rhs) const {
+        return cost > rhs.cost;
     }
-}
 
-struct Node {
-    using ChildrenType = std::unordered_map<char, std::unique_ptr<Node>>;
-    ChildrenType children;
-    bool end_of_word = false;
+    float cost = 0.0F;
+    int32_t edge = -1;
+    int32_t prev_rank = -1;
+};
 
-    inline bool HasChild(char ch) {
-        return children.find(ch) != children.end();
+struct LatticeRow {
+    int32_t first_edge = -1;
+    bool reachable = false;
+    // Whether |candidates| has been seeded with the row's incoming edges.
+    // |more_paths| and |candidates| are left over from a previous query
+    // until then.
+    bool expanded = false;
+    LatticePath best;
+    // Second best segmentation onwards, from cheapest
+    std::vector<LatticePath> more_paths;
+    // Min-heap of candidates for the next entry of |more_paths|
+    std::vector<LatticePath> candidates;
+
+    size_t PathCount() const {
+        return !reachable ? 0 : expanded ? more_paths.size() + 1 : 1;
+    }
+
+    LatticePath const &Path(size_t rank) const {
+        return rank == 0 ? best : more_paths[rank - 1];
     }
 };
 
-class TrieImpl : public Trie {
+/**
+ * Segmentation lattice with one row per query index, searched for the
+ * k best segmentations with the recursive enumeration algorithm
+ * (Jiménez & Marzal, 1999):
+ *
+ * - Edges must be added in order of their source row. Each new edge is
+ *   relaxed against the best path of its target row (Viterbi), so every
+ *   row knows its best path by the time edges leave it.
+ * - The (k+1)-th best path of a row is only computed on request: the source
+ *   row of its k-th path is asked for its next path, which becomes a new
+ *   candidate, and the cheapest candidate is taken. A row's candidate heap
+ *   is only seeded with its other incoming edges when its second path is
+ *   first requested.
+ *
+ * Asking for k paths of the last row therefore only touches the rows those
+ * paths pass through. The rows and edges are kept between calls, so a warm
+ * lattice does not allocate.
+ */
+class SplitLattice {
   public:
-    TrieImpl() = default;
-    ~TrieImpl() override = default;
+    void Reset(size_t n_rows) {
+        if (m_rows.size() < n_rows) {
+            m_rows.resize(n_rows);
+        }
 
-    void Insert(std::vector<std::string> const &words) override {
-        for (auto const &word : words) {
-            Insert(std::string_view(word));
+        for (size_t i = 0; i < n_rows; ++i) {
+            m_rows[i].first_edge = -1;
+            m_rows[i].reachable = false;
+            m_rows[i].expanded = false;
         }
+
+        m_edges.clear();
+        m_rows[0].reachable = true;
+        m_rows[0].best = LatticePath();
     }
 
-    void Insert(std::string_view key) override {
-        auto *curr = &root;
+    bool Reachable(size_t row) const {
+        return m_rows[row].reachable;
+    }
 
-        for (auto ch : key) {
-            if (curr->children.find(ch) == curr->children.end()) {
-                curr->children.try_emplace(ch, std::make_unique<Node>());
-                //curr->children[ch] = std::make_unique<Node>();
-            }
+    void AddEdge(size_t from, size_t to, float cost) {
+        auto &r = m_rows[to];
+        auto e = static_cast<int32_t>(m_edges.size());
+        m_edges.push_back(LatticeEdge{static_cast<int32_t>(from), cost, r.first_edge});
+        r.first_edge = e;
 
-            curr = curr->children[ch].get();
+        auto path_cost = m_rows[from].best.cost + cost;
+        if (!r.reachable || path_cost < r.best.cost) {
+            r.best = LatticePath{path_cost, e, 0};
+            r.reachable = true;
         }
-
-        curr->end_of_word = true;
     }
 
-    bool Remove(std::string_view key) override {
-        auto onlyChildNodes = std::vector<std::tuple<char, Node *, bool>>();
-        auto *curr = &root;
+    // Ensures the |rank|-th best path of |row| is known. Returns false if
+    // there are not that many segmentations.
+    bool FindPath(size_t row, size_t rank) {
+        auto &r = m_rows[row];
 
-        for (auto it = key.begin(); it != key.end(); it++) {
-            auto found = curr->children.find(*it);
+        if (r.PathCount() > rank) {
+            return true;
+        }
 
-            if (found == curr->children.end()) {
-                return false; // Key not in Trie
+        if (!r.expanded) {
+            Expand(r);
+        }
+
+        while (r.PathCount() <= rank) {
+            auto const last = r.Path(r.PathCount() - 1);
+
+            if (last.edge == -1) {
+                return false; // Row 0 only has the empty path
             }
 
-            curr = curr->children[*it].get();
+            auto const &edge = m_edges[last.edge];
+            auto next_rank = static_cast<size_t>(last.prev_rank) + 1;
 
-            if (std::next(it) == key.end() && curr->end_of_word) {
-                curr->end_of_word = false;
+            if (FindPath(edge.from, next_rank)) {
+                r.candidates.push_back(LatticePath{m_rows[edge.from].Path(next_rank).cost + edge.cost, last.edge,
+                                                   static_cast<int32_t>(next_rank)});
+                std::push_heap(r.candidates.begin(), r.candidates.end(), std::greater<>());
             }
 
-            if (curr->children.size() > 1) {
-                onlyChildNodes.push_back(std::make_tuple(*it, curr, false));
-            } else {
-                onlyChildNodes.push_back(std::make_tuple(*it, curr, true));
+            if (r.candidates.empty()) {
+                return false;
             }
+
+            std::pop_heap(r.candidates.begin(), r.candidates.end(), std::greater<>());
+            r.more_paths.push_back(r.candidates.back());
+            r.candidates.pop_back();
         }
 
-        for (auto it = onlyChildNodes.rbegin(); it != onlyChildNodes.rend(); it++) {
-            if (it == onlyChildNodes.rbegin()) {
-                continue;
-            }
+        return true;
+    }
 
-            auto &onlyChild = std::get<2>(*it);
-            auto &prevOnlyChild = std::get<2>(*std::prev(it));
+    // Split positions of the |rank|-th best path of |row|, in ascending order
+    std::vector<int> Splits(size_t row, size_t rank) const {
+        auto n_splits = size_t(0);
+        for (auto const *path = &m_rows[row].Path(rank); path->edge != -1;
+             path = &m_rows[m_edges[path->edge].from].Path(path->prev_rank)) {
+            ++n_splits;
+        }
 
-            if ((!onlyChild && prevOnlyChild) || std::next(it) == onlyChildNodes.rend()) {
-                auto &chr = std::get<0>(*it);
-                auto &node = std::get<1>(*it);
+        auto ret = std::vector<int>(n_splits);
+        auto const *path = &m_rows[row].Path(rank);
+        while (n_splits != 0) {
+            ret[--n_splits] = static_cast<int>(row);
+            row = m_edges[path->edge].from;
+            path = &m_rows[row].Path(path->prev_rank);
+        }
 
-                // does smart pointer need reset?
-                // node->children[chr].reset();
-                node->children.erase(chr);
-                return true;
+        return ret;
+    }
+
+  private:
+    // Seeds the candidates with the best path through each incoming edge,
+    // except the edge of the row's best path
+    void Expand(LatticeRow &r) {
+        r.expanded = true;
+        r.more_paths.clear();
+        r.candidates.clear();
+
+        for (auto e = r.first_edge; e != -1; e = m_edges[e].next) {
+            if (e != r.best.edge) {
+                auto const &edge = m_edges[e];
+                r.candidates.push_back(LatticePath{m_rows[edge.from].best.cost + edge.cost, e, 0});
             }
         }
 
-        return false;
+        std::make_heap(r.candidates.begin(), r.candidates.end(), std::greater<>());
     }
 
+    std::vector<LatticeRow> m_rows;
+    std::vector<LatticeEdge> m_edges;
+};
+
+/**
+ * Read-only queries shared by the mutable and the frozen tries. |Impl| only
+ * needs to provide a handful of node primitives:
+ *
+ *   NodeRef Root() const;
+ *   bool Next(NodeRef &node, char ch) const;   // Advance to child |ch|
+ *   bool IsKey(NodeRef node) const;
+ *   int KeyId(NodeRef node) const;            // Only valid if IsKey(node)
+ *   int BestKeyId(NodeRef node) const;        // Smallest key id below node, or -1
+ *   bool HasChildren(NodeRef node) const;
+ *   void ForEachChild(NodeRef node, F &&fn) const; // fn(char, NodeRef)
+ */
+template <typename Impl>
+class TrieBase : public Trie {
+  public:
     bool HasKey(std::string_view query) override {
-        auto found = Find(query);
-        return found != nullptr && found->end_of_word;
+        auto node = impl().Root();
+        return Find(query, node) && impl().IsKey(node);
     }
 
     bool StartsWithKey(std::string_view query) override {
@@ -136,22 +226,25 @@ class TrieImpl : public Trie {
             return false;
         }
 
-        auto *curr = &root;
+        auto node = impl().Root();
         for (auto it = query.begin(); it != query.end(); ++it) {
-            if (curr->end_of_word) {
+            if (impl().IsKey(node)) {
                 return true;
-            } else if (curr->children.find(*it) == curr->children.end()) {
+            } else if (!impl().Next(node, *it)) {
                 return false;
             }
-
-            curr = curr->children[*it].get();
         }
-        return curr->end_of_word;
+        return impl().IsKey(node);
     }
 
     bool HasKeyOrPrefix(std::string_view query) override {
-        auto *found = Find(query);
-        return found != nullptr && (found->end_of_word || !found->children.empty());
+        auto node = impl().Root();
+        return Find(query, node) && (impl().IsKey(node) || impl().HasChildren(node));
+    }
+
+    int KeyId(std::string_view query) override {
+        auto node = impl().Root();
+        return Find(query, node) && impl().IsKey(node) ? impl().KeyId(node) : -1;
     }
 
     size_t LongestKeyOf(std::string_view query) override {
@@ -162,41 +255,60 @@ class TrieImpl : public Trie {
         }
 
         auto it = query.begin();
-        auto *curr = &root;
+        auto node = impl().Root();
         for (; it != query.end(); ++it) {
-            if (curr->end_of_word) {
+            if (impl().IsKey(node)) {
                 ret = std::distance(query.begin(), it);
             }
 
-            if (curr->children.find(*it) == curr->children.end()) {
+            if (!impl().Next(node, *it)) {
                 return ret;
             }
-
-            curr = curr->children[*it].get();
         }
 
-        if (curr->end_of_word) {
+        if (impl().IsKey(node)) {
             ret = std::distance(query.begin(), it);
         }
 
         return ret;
     }
 
-    std::vector<std::string> Autocomplete(std::string const &query, int limit, int maxDepth) override {
+    std::vector<std::string> Autocomplete(std::string const &query, int limit, int max_depth) override {
         auto ret = std::vector<std::string>();
-        auto *found = Find(query);
+        auto found = impl().Root();
 
-        if (found == nullptr) {
+        if (!Find(query, found)) {
             return ret;
         }
 
-        if (found->end_of_word && found->children.empty() && limit == 1) {
-            ret.push_back(query);
-            return ret;
+        BestFirstSearch(found, query, ret, limit, max_depth);
+
+        return ret;
+    }
+
+    std::string NextLetters(std::string_view query, size_t limit) override {
+        auto found = impl().Root();
+
+        if (!Find(query, found)) {
+            return std::string();
         }
 
-        BreadthFirstSearch(found, query, ret, limit);
-        // DepthFirstSearch(found, query, "", ret, limit, maxDepth);
+        auto children = std::vector<std::pair<int, char>>();
+        impl().ForEachChild(found, [&](char ch, auto child) {
+            auto best = impl().BestKeyId(child);
+            if (ch != 0 && best >= 0) {
+                children.emplace_back(best, ch);
+            }
+        });
+        std::sort(children.begin(), children.end());
+
+        auto ret = std::string();
+        for (auto const &[best, ch] : children) {
+            if (limit != 0 && ret.size() >= limit) {
+                break;
+            }
+            ret.push_back(ch);
+        }
 
         return ret;
     }
@@ -208,168 +320,844 @@ class TrieImpl : public Trie {
             return;
         }
 
-        auto curr = &root;
+        auto node = impl().Root();
         auto it = query.begin();
         while (it != query.end()) {
-            if (curr->children.find(*it) == curr->children.end()) {
+            if (!impl().Next(node, *it)) {
                 return;
             }
 
-            curr = curr->children[*it].get();
             ++it;
-            if (curr->end_of_word) {
+            if (impl().IsKey(node)) {
                 results.push_back(std::string(query.begin(), it));
             }
         }
     }
 
-    std::vector<std::vector<int>> Multisplit(std::string_view query, WordCostMap const &cost_map,
+    std::vector<std::vector<int>> Multisplit(std::string_view query, std::vector<float> const &key_costs,
                                              uint32_t limit) override {
-        query = query.substr(0, 63);
-        // auto query_size = query.size();
+        auto ret = std::vector<std::vector<int>>();
+
+        if (limit == 0) {
+            return ret;
+        }
 
         /**
-         * The table contains one row for each index in the query string, up to max of 64
-         * Each row contains a result vector, which will reach a max size of |limit|
-         * Each result contains a uint64_t called |split| representing a bitfield,
-         * where the position of each set bit represents a split in the query string,
-         * plus the total cost associated with that split pattern.
+         * The lattice contains one row for each index in the query string.
+         * An edge from row |i| to row |j| means query[i, j) is a key.
          */
-        auto table = std::vector<std::vector<SplitCost>>(query.size() + 1, std::vector<SplitCost>());
-        table[0].push_back(SplitCost());
+        m_lattice.Reset(query.size() + 1);
         auto qbegin = query.begin();
         auto qend = query.end();
 
         /**
          * |start| is a pointer to the letter one past the end of the current split index
-         * e.g., each result in the table at index |start_idx| has a split at that position
+         * e.g., every segmentation in row |start_idx| has a split at that position.
+         * All edges into row |start_idx| have been added by the time it is reached,
+         * so its best path is final.
          */
         for (auto start = qbegin; start != qend; ++start) {
             auto start_idx = std::distance(qbegin, start);
-            auto *node = &root;
+            auto node = impl().Root();
 
-            if (table[start_idx].empty()) {
+            if (!m_lattice.Reachable(start_idx)) {
                 continue;
             }
 
             /**
              * Iterate through the remainder of the query string with pointer |it|.
-             * When query[start, it] is a word, check if the cost is cheaper than
-             * the most expensive result currently stored in table[it_idx]. If so,
-             * replace the most expensive one with the cheaper one.
+             * This walk ends at the longest key starting at |start|, so the total
+             * work is linear in the query length.
              */
             for (auto it = start; it != qend; ++it) {
-                auto it_idx = std::distance(qbegin, it) + 1;
-
-                if (node->children.find(*it) == node->children.end()) {
+                if (!impl().Next(node, *it)) {
                     break;
                 }
 
-                node = node->children[*it].get();
-
-                if (node->end_of_word) {
-                    if (auto found = cost_map.find(std::string(start, it + 1)); found != cost_map.end()) {
-                        for (auto &result : table[start_idx]) {
-                            auto bits = std::bitset<64>(result.split);
-                            bits.set(it_idx, true);
-                            auto split = bits.to_ullong();
-                            auto cost = result.cost + found->second;
-                            SaveIfCheaper(table[it_idx], limit, split, cost);
-                        }
-                    }
+                if (!impl().IsKey(node)) {
+                    continue;
                 }
+
+                auto key_id = impl().KeyId(node);
+                if (key_id < 0 || static_cast<size_t>(key_id) >= key_costs.size()) {
+                    continue;
+                }
+
+                m_lattice.AddEdge(start_idx, std::distance(qbegin, it) + 1, key_costs[key_id]);
             }
         }
 
-        auto ret = std::vector<std::vector<int>>();
-        auto last_row = table.end() - 1;
-        while (last_row != table.begin() && last_row->empty()) {
+        auto last_row = query.size();
+        while (last_row != 0 && !m_lattice.Reachable(last_row)) {
             --last_row;
         }
 
-        for (auto &result : *last_row) {
-            ret.push_back(utils::bitpositions(result.split));
+        ret.reserve(std::min(limit, kMaxReservedSplits));
+        for (size_t rank = 0; rank < limit && m_lattice.FindPath(last_row, rank); ++rank) {
+            ret.push_back(m_lattice.Splits(last_row, rank));
+        }
+
+        return ret;
+    }
+
+  protected:
+    uintptr_t CursorRoot() const override {
+        return ToHandle(impl().Root());
+    }
+
+    bool CursorNext(uintptr_t &node, char ch) const override {
+        auto ref = FromHandle(node);
+        if (!impl().Next(ref, ch)) {
+            return false;
+        }
+        node = ToHandle(ref);
+        return true;
+    }
+
+    bool CursorIsKey(uintptr_t node) const override {
+        return impl().IsKey(FromHandle(node));
+    }
+
+    int CursorKeyId(uintptr_t node) const override {
+        return impl().KeyId(FromHandle(node));
+    }
+
+    bool CursorHasChildren(uintptr_t node) const override {
+        return impl().HasChildren(FromHandle(node));
+    }
+
+    template <typename NodeRef>
+    bool Find(std::string_view query, NodeRef &node) const {
+        for (auto ch : query) {
+            if (!impl().Next(node, ch)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+  private:
+    Impl const &impl() const {
+        return static_cast<Impl const &>(*this);
+    }
+
+    template <typename NodeRef>
+    static uintptr_t ToHandle(NodeRef node) {
+        if constexpr (std::is_pointer_v<NodeRef>) {
+            return reinterpret_cast<uintptr_t>(node);
+        } else {
+            return static_cast<uintptr_t>(node);
+        }
+    }
+
+    auto FromHandle(uintptr_t node) const {
+        using NodeRef = decltype(impl().Root());
+        if constexpr (std::is_pointer_v<NodeRef>) {
+            return reinterpret_cast<NodeRef>(node);
+        } else {
+            return static_cast<NodeRef>(node);
+        }
+    }
+
+    SplitLattice m_lattice;
+
+    /**
+     * Emits the keys below |start| in key id order, i.e. in frequency order
+     * for a dictionary trie. Every node knows the smallest key id in its
+     * subtree, so the queue always expands the subtree holding the next
+     * result. Keys are queued as separate entries once their node has been
+     * expanded, since a child subtree may still hold a smaller id.
+     *
+     * Queued nodes only refer to a step in |steps| (parent step and label),
+     * and a key is spelled out by following those back to |start| when it
+     * is emitted.
+     */
+    template <typename NodeRef>
+    void BestFirstSearch(NodeRef start, std::string const &prefix, std::vector<std::string> &result, int limit,
+                         int max_depth) {
+        struct Step {
+            int32_t prev = -1;
+            int32_t depth = 0;
+            char label = 0;
+        };
+
+        struct Entry {
+            bool operator>(Entry const &rhs) const {
+                return key_id > rhs.key_id;
+            }
+
+            int key_id = -1;
+            int32_t step = -1;
+            NodeRef node;
+            bool is_key = false;
+        };
+
+        if (impl().BestKeyId(start) < 0) {
+            return;
+        }
+
+        auto steps = std::vector<Step>();
+        auto queue = std::vector<Entry>();
+        queue.push_back(Entry{impl().BestKeyId(start), -1, start, false});
+
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+            auto entry = queue.back();
+            queue.pop_back();
+
+            // A key that is the best of its own subtree is next in line
+            if (entry.is_key || (impl().IsKey(entry.node) && impl().KeyId(entry.node) == entry.key_id)) {
+                result.push_back(Spell(prefix, steps, entry.step));
+
+                if (limit != 0 && static_cast<int>(result.size()) >= limit) {
+                    return;
+                }
+            } else if (impl().IsKey(entry.node)) {
+                queue.push_back(Entry{impl().KeyId(entry.node), entry.step, entry.node, true});
+                std::push_heap(queue.begin(), queue.end(), std::greater<>());
+            }
+
+            if (entry.is_key) {
+                continue;
+            }
 
-            if (ret.size() >= limit) {
-                last_row = table.begin();
+            auto depth = entry.step == -1 ? 0 : steps[entry.step].depth;
+            if (max_depth != 0 && depth >= max_depth) {
+                continue;
             }
+
+            impl().ForEachChild(entry.node, [&](char ch, NodeRef child) {
+                auto best = impl().BestKeyId(child);
+                if (best < 0) {
+                    return;
+                }
+
+                steps.push_back(Step{entry.step, depth + 1, ch});
+                queue.push_back(Entry{best, static_cast<int32_t>(steps.size() - 1), child, false});
+                std::push_heap(queue.begin(), queue.end(), std::greater<>());
+            });
+        }
+    }
+
+    template <typename Step>
+    static std::string Spell(std::string const &prefix, std::vector<Step> const &steps, int32_t step) {
+        auto ret = prefix;
+        ret.resize(prefix.size() + (step == -1 ? 0 : steps[step].depth));
+
+        for (auto i = ret.size(); step != -1; step = steps[step].prev) {
+            ret[--i] = steps[step].label;
         }
 
         return ret;
     }
+};
+
+//+---------------------------------------------------------------------------
+//
+// Mutable trie
+//
+//----------------------------------------------------------------------------
+
+struct Node {
+    using ChildrenType = std::unordered_map<char, std::unique_ptr<Node>>;
+    ChildrenType children;
+    bool end_of_word = false;
+    int key_id = -1;
+    // Smallest key id in this subtree, including this node
+    int best_key_id = -1;
+
+    inline bool HasChild(char ch) {
+        return children.find(ch) != children.end();
+    }
+};
+
+class TrieImpl : public TrieBase<TrieImpl> {
+  public:
+    using NodeRef = Node const *;
+
+    TrieImpl() = default;
+    ~TrieImpl() override = default;
+
+    // Ids follow the position in |words|, as in a frozen trie built from them
+    void Insert(std::vector<std::string> const &words) override {
+        auto first_id = m_next_key_id;
+        for (size_t i = 0; i < words.size(); ++i) {
+            InsertWithId(words[i], first_id + static_cast<int>(i));
+        }
+        m_next_key_id = first_id + static_cast<int>(words.size());
+    }
+
+    void Insert(std::string_view key) override {
+        InsertWithId(key, m_next_key_id++);
+    }
+
+    void InsertWithId(std::string_view key, int key_id) {
+        auto *curr = &root;
+
+        for (auto ch : key) {
+            if (curr->children.find(ch) == curr->children.end()) {
+                curr->children.try_emplace(ch, std::make_unique<Node>());
+                //curr->children[ch] = std::make_unique<Node>();
+            }
+
+            curr = curr->children[ch].get();
+        }
+
+        if (curr->end_of_word) {
+            return;
+        }
+
+        curr->end_of_word = true;
+        curr->key_id = key_id;
+
+        curr = &root;
+        for (auto ch : key) {
+            if (curr->best_key_id == -1 || key_id < curr->best_key_id) {
+                curr->best_key_id = key_id;
+            }
+            curr = curr->children[ch].get();
+        }
+        if (curr->best_key_id == -1 || key_id < curr->best_key_id) {
+            curr->best_key_id = key_id;
+        }
+    }
+
+    bool Remove(std::string_view key) override {
+        auto removed = RemoveKey(key);
+        UpdateBestKeyIds(key);
+        return removed;
+    }
+
+
+    NodeRef Root() const {
+        return &root;
+    }
+
+    bool Next(NodeRef &node, char ch) const {
+        auto found = node->children.find(ch);
+
+        if (found == node->children.end()) {
+            return false;
+        }
+
+        node = found->second.get();
+        return true;
+    }
+
+    bool IsKey(NodeRef node) const {
+        return node->end_of_word;
+    }
+
+    int KeyId(NodeRef node) const {
+        return node->key_id;
+    }
+
+    int BestKeyId(NodeRef node) const {
+        return node->best_key_id;
+    }
+
+    bool HasChildren(NodeRef node) const {
+        return !node->children.empty();
+    }
+
+    template <typename F>
+    void ForEachChild(NodeRef node, F &&fn) const {
+        for (auto const &c : node->children) {
+            fn(c.first, static_cast<NodeRef>(c.second.get()));
+        }
+    }
 
   private:
-    auto Find(std::string_view query) -> Node * {
-        auto curr = &root;
+    bool RemoveKey(std::string_view key) {
+        auto onlyChildNodes = std::vector<std::tuple<char, Node *, bool>>();
+        auto *curr = &root;
 
-        for (auto it = query.begin(); it < query.end(); it++) {
-            if (curr->children.find(*it) == curr->children.end()) {
-                return nullptr;
+        for (auto it = key.begin(); it != key.end(); it++) {
+            auto found = curr->children.find(*it);
+
+            if (found == curr->children.end()) {
+                return false; // Key not in Trie
             }
 
             curr = curr->children[*it].get();
+
+            if (std::next(it) == key.end() && curr->end_of_word) {
+                curr->end_of_word = false;
+                curr->key_id = -1;
+            }
+
+            if (curr->children.size() > 1) {
+                onlyChildNodes.push_back(std::make_tuple(*it, curr, false));
+            } else {
+                onlyChildNodes.push_back(std::make_tuple(*it, curr, true));
+            }
+        }
+
+        for (auto it = onlyChildNodes.rbegin(); it != onlyChildNodes.rend(); it++) {
+            if (it == onlyChildNodes.rbegin()) {
+                continue;
+            }
+
+            auto &onlyChild = std::get<2>(*it);
+            auto &prevOnlyChild = std::get<2>(*std::prev(it));
+
+            if ((!onlyChild && prevOnlyChild) || std::next(it) == onlyChildNodes.rend()) {
+                auto &chr = std::get<0>(*it);
+                auto &node = std::get<1>(*it);
+
+                // does smart pointer need reset?
+                // node->children[chr].reset();
+                node->children.erase(chr);
+                return true;
+            }
         }
 
-        return curr;
+        return false;
     }
 
-    void BreadthFirstSearch(Node *start, std::string const &prefix, std::vector<std::string> &result, int limit) {
-        auto queue = std::queue<std::pair<std::string, Node *>>();
+    // Recomputes the subtree minimums along |key| after a removal
+    void UpdateBestKeyIds(std::string_view key) {
+        auto path = std::vector<Node *>{&root};
+        for (auto ch : key) {
+            auto found = path.back()->children.find(ch);
+            if (found == path.back()->children.end()) {
+                break;
+            }
+            path.push_back(found->second.get());
+        }
 
-        if (start->end_of_word) {
-            result.push_back(prefix);
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            auto *node = *it;
+            node->best_key_id = node->end_of_word ? node->key_id : -1;
+            for (auto const &c : node->children) {
+                auto best = c.second->best_key_id;
+                if (best != -1 && (node->best_key_id == -1 || best < node->best_key_id)) {
+                    node->best_key_id = best;
+                }
+            }
         }
+    }
+
+    Node root;
+    int m_next_key_id = 0;
+};
+
+//+---------------------------------------------------------------------------
+//
+// Frozen (double-array) trie
+//
+//----------------------------------------------------------------------------
+
+/**
+ * One cell of the double array. The children of node |s| live at
+ * |base(s) + label| and are identified by |check == s|. A key ending at
+ * |s| is marked by a terminal child with label 0, whose |base| holds the
+ * key's insertion index. Each node also keeps its first non-terminal child
+ * label, and each child its next sibling label, so that children can be
+ * enumerated without probing all 256 labels. |best_key_id| is the smallest
+ * key id in the node's subtree, or -1 if there is none.
+ */
+struct DoubleArrayUnit {
+    static constexpr uint8_t kIsKey = 1;
+    static constexpr uint8_t kHasChildren = 2;
+    static constexpr uint8_t kHasSibling = 4;
+
+    int32_t base = 0;
+    int32_t check = -1;
+    int32_t best_key_id = -1;
+    uint8_t child = 0;
+    uint8_t sibling = 0;
+    uint8_t flags = 0;
+};
+
+// Units are written to and mapped from dictionary images as-is
+static_assert(std::is_standard_layout_v<DoubleArrayUnit> && sizeof(DoubleArrayUnit) == 16);
+
+class DoubleArrayBuilder {
+    using KeyIndex = std::pair<std::string_view, int32_t>;
 
-        for (auto &c : start->children) {
-            queue.push(std::make_pair(std::string(1, c.first), c.second.get()));
+  public:
+    explicit DoubleArrayBuilder(std::vector<std::string> const &keys) {
+        m_keys.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            m_keys.emplace_back(keys[i], static_cast<int32_t>(i));
         }
 
-        while (!queue.empty()) {
-            auto [suffix, node] = std::move(queue.front());
-            queue.pop();
+        // Sort as unsigned bytes, keeping the first index of duplicate keys
+        std::stable_sort(m_keys.begin(), m_keys.end(), [](KeyIndex const &a, KeyIndex const &b) {
+            return std::lexicographical_compare(
+                a.first.begin(), a.first.end(), b.first.begin(), b.first.end(), [](char l, char r) {
+                    return static_cast<uint8_t>(l) < static_cast<uint8_t>(r);
+                });
+        });
+        m_keys.erase(std::unique(m_keys.begin(), m_keys.end(),
+                                 [](KeyIndex const &a, KeyIndex const &b) {
+                                     return a.first == b.first;
+                                 }),
+                     m_keys.end());
+        m_keys.erase(std::remove_if(m_keys.begin(), m_keys.end(),
+                                    [](KeyIndex const &k) {
+                                        return k.first.find('\0') != std::string_view::npos;
+                                    }),
+                     m_keys.end());
+    }
 
-            if (node->end_of_word) {
-                result.push_back(prefix + suffix);
+    std::vector<DoubleArrayUnit> Build() {
+        m_units.clear();
+        Grow(kBlockSize);
+        Occupy(0);
+        m_units[0].check = 0;
 
-                if (limit != 0 && static_cast<int>(result.size()) >= limit) {
-                    return;
-                }
+        if (!m_keys.empty()) {
+            BuildNode(0, 0, 0, m_keys.size());
+        }
+
+        while (!m_units.empty() && m_units.back().check == -1) {
+            m_units.pop_back();
+        }
+
+        m_units.shrink_to_fit();
+        m_next_free.clear();
+        m_prev_free.clear();
+        return std::move(m_units);
+    }
+
+  private:
+    static constexpr int32_t kBlockSize = 1024;
+
+    // Returns the smallest key id in the subtree of |node|
+    int32_t BuildNode(int32_t node, size_t depth, size_t lo, size_t hi) {
+        auto labels = std::array<uint8_t, 257>();
+        size_t n_labels = 0;
+        auto key_id = -1;
+
+        if (m_keys[lo].first.size() == depth) {
+            key_id = m_keys[lo].second;
+            labels[n_labels++] = 0;
+            ++lo;
+        }
+
+        for (auto i = lo; i < hi; ++i) {
+            auto label = static_cast<uint8_t>(m_keys[i].first[depth]);
+            if (n_labels == 0 || labels[n_labels - 1] != label) {
+                labels[n_labels++] = label;
+            }
+        }
+
+        auto base = FindBase(labels.data(), n_labels);
+        m_units[node].base = base;
+
+        for (size_t i = 0; i < n_labels; ++i) {
+            auto pos = base + labels[i];
+            Occupy(pos);
+            m_units[pos].check = node;
+        }
+
+        auto first_child = size_t(0);
+
+        if (key_id >= 0) {
+            m_units[base].base = key_id;
+            m_units[node].flags |= DoubleArrayUnit::kIsKey;
+            first_child = 1;
+        }
+
+        if (first_child < n_labels) {
+            m_units[node].flags |= DoubleArrayUnit::kHasChildren;
+            m_units[node].child = labels[first_child];
+        }
+
+        for (auto i = first_child; i + 1 < n_labels; ++i) {
+            auto &unit = m_units[base + labels[i]];
+            unit.flags |= DoubleArrayUnit::kHasSibling;
+            unit.sibling = labels[i + 1];
+        }
+
+        auto best_key_id = key_id;
+        auto start = lo;
+        for (auto i = first_child; i < n_labels; ++i) {
+            auto end = start;
+            while (end < hi && static_cast<uint8_t>(m_keys[end].first[depth]) == labels[i]) {
+                ++end;
             }
+            auto child_best = BuildNode(base + labels[i], depth + 1, start, end);
+            if (best_key_id == -1 || child_best < best_key_id) {
+                best_key_id = child_best;
+            }
+            start = end;
+        }
+
+        m_units[node].best_key_id = best_key_id;
+        return best_key_id;
+    }
+
+    int32_t FindBase(uint8_t const *labels, size_t n_labels) {
+        auto pos = m_next_free[0];
 
-            for (auto &c : node->children) {
-                queue.push(std::make_pair(suffix + c.first, c.second.get()));
+        while (true) {
+            if (pos == 0) {
+                // Free list exhausted, append a new block
+                pos = static_cast<int32_t>(m_units.size());
+                Grow(kBlockSize);
             }
+
+            auto base = pos - labels[0];
+
+            if (base > 0) {
+                auto fits = true;
+
+                for (size_t i = 1; i < n_labels; ++i) {
+                    auto slot = base + labels[i];
+
+                    while (slot >= static_cast<int32_t>(m_units.size())) {
+                        Grow(kBlockSize);
+                    }
+
+                    if (m_units[slot].check != -1) {
+                        fits = false;
+                        break;
+                    }
+                }
+
+                if (fits) {
+                    return base;
+                }
+            }
+
+            pos = m_next_free[pos];
         }
     }
 
-    void DepthFirstSearch(Node *node, std::string const &prefix, std::string const &suffix,
-                          std::vector<std::string> &results, size_t limit, size_t max_depth) {
-        if (node->end_of_word) {
-            results.push_back(prefix + suffix);
+    // Free cells are kept in a circular doubly-linked list anchored at cell 0
+    void Grow(int32_t n) {
+        auto old_size = static_cast<int32_t>(m_units.size());
+        auto new_size = old_size + n;
+        m_units.resize(new_size);
+        m_next_free.resize(new_size);
+        m_prev_free.resize(new_size);
+
+        if (old_size == 0) {
+            m_next_free[0] = 0;
+            m_prev_free[0] = 0;
+            old_size = 1;
         }
 
-        if (limit != 0 && results.size() >= limit) {
+        for (auto i = old_size; i < new_size; ++i) {
+            auto last = m_prev_free[0];
+            m_next_free[last] = i;
+            m_prev_free[i] = last;
+            m_next_free[i] = 0;
+            m_prev_free[0] = i;
+        }
+    }
+
+    void Occupy(int32_t pos) {
+        if (pos == 0) {
             return;
         }
 
-        if (node->children.empty() || --max_depth == 0) {
+        auto prev = m_prev_free[pos];
+        auto next = m_next_free[pos];
+        m_next_free[prev] = next;
+        m_prev_free[next] = prev;
+    }
+
+    std::vector<KeyIndex> m_keys;
+    std::vector<DoubleArrayUnit> m_units;
+    std::vector<int32_t> m_next_free;
+    std::vector<int32_t> m_prev_free;
+};
+
+class FrozenTrieImpl : public TrieBase<FrozenTrieImpl> {
+  public:
+    using NodeRef = int32_t;
+
+    explicit FrozenTrieImpl(std::vector<DoubleArrayUnit> units) : m_storage(std::move(units)) {
+        m_units = m_storage.data();
+        m_size = static_cast<int32_t>(m_storage.size());
+    }
+
+    FrozenTrieImpl(DoubleArrayUnit const *units, size_t size) : m_units(units), m_size(static_cast<int32_t>(size)) {}
+
+    void Insert(std::vector<std::string> const &) override {}
+
+    void Insert(std::string_view) override {}
+
+    bool Remove(std::string_view) override {
+        return false;
+    }
+
+    NodeRef Root() const {
+        return 0;
+    }
+
+    bool Next(NodeRef &node, char ch) const {
+        if (ch == '\0' || (m_units[node].flags & DoubleArrayUnit::kHasChildren) == 0) {
+            return false;
+        }
+
+        auto pos = m_units[node].base + static_cast<uint8_t>(ch);
+
+        if (pos <= 0 || pos >= m_size || m_units[pos].check != node) {
+            return false;
+        }
+
+        node = pos;
+        return true;
+    }
+
+    bool IsKey(NodeRef node) const {
+        return (m_units[node].flags & DoubleArrayUnit::kIsKey) != 0;
+    }
+
+    // The terminal child (label 0) stores the key id in its base
+    int KeyId(NodeRef node) const {
+        return m_units[m_units[node].base].base;
+    }
+
+    int BestKeyId(NodeRef node) const {
+        return m_units[node].best_key_id;
+    }
+
+    bool HasChildren(NodeRef node) const {
+        return (m_units[node].flags & DoubleArrayUnit::kHasChildren) != 0;
+    }
+
+    template <typename F>
+    void ForEachChild(NodeRef node, F &&fn) const {
+        auto const &unit = m_units[node];
+
+        if ((unit.flags & DoubleArrayUnit::kHasChildren) == 0) {
             return;
         }
 
-        for (const auto &it : node->children) {
-            DepthFirstSearch(it.second.get(), prefix, suffix + it.first, results, limit, max_depth);
+        auto label = unit.child;
+        while (true) {
+            auto pos = unit.base + label;
+            fn(static_cast<char>(label), pos);
+
+            if ((m_units[pos].flags & DoubleArrayUnit::kHasSibling) == 0) {
+                break;
+            }
+
+            label = m_units[pos].sibling;
         }
     }
 
-    Node root;
+  private:
+    std::vector<DoubleArrayUnit> m_storage;
+    DoubleArrayUnit const *m_units = nullptr;
+    int32_t m_size = 0;
 };
 
 } // namespace
 
+//+---------------------------------------------------------------------------
+//
+// Trie::Cursor
+//
+//----------------------------------------------------------------------------
+
+Trie::Cursor::Cursor(Trie const *trie, std::pmr::memory_resource *resource)
+    : m_trie(trie), m_text(resource), m_path(resource) {
+    if (m_trie != nullptr) {
+        m_path.push_back(m_trie->CursorRoot());
+    }
+}
+
+bool Trie::Cursor::Advance(char ch) {
+    auto alive = valid();
+    m_text.push_back(ch);
+
+    if (!alive || m_path.empty()) {
+        return false;
+    }
+
+    auto node = m_path.back();
+    if (!m_trie->CursorNext(node, ch)) {
+        return false;
+    }
+
+    m_path.push_back(node);
+    return true;
+}
+
+bool Trie::Cursor::Advance(std::string_view letters) {
+    for (auto ch : letters) {
+        Advance(ch);
+    }
+
+    return valid();
+}
+
+void Trie::Cursor::Rewind(size_t n) {
+    n = std::min(n, m_text.size());
+    m_text.resize(m_text.size() - n);
+
+    if (m_path.size() > m_text.size() + 1) {
+        m_path.resize(m_text.size() + 1);
+    }
+}
+
+bool Trie::Cursor::Seek(std::string_view text) {
+    auto mismatch = std::mismatch(m_text.begin(), m_text.end(), text.begin(), text.end());
+    auto common = static_cast<size_t>(std::distance(m_text.begin(), mismatch.first));
+    Rewind(m_text.size() - common);
+    return Advance(text.substr(common));
+}
+
+Trie::Cursor Trie::Cursor::Fork() const {
+    return *this;
+}
+
+bool Trie::Cursor::valid() const {
+    return !m_path.empty() && m_path.size() == m_text.size() + 1;
+}
+
+bool Trie::Cursor::IsKey() const {
+    return valid() && m_trie->CursorIsKey(m_path.back());
+}
+
+bool Trie::Cursor::IsKeyOrPrefix() const {
+    return valid() && (m_trie->CursorIsKey(m_path.back()) || m_trie->CursorHasChildren(m_path.back()));
+}
+
+int Trie::Cursor::KeyId() const {
+    return IsKey() ? m_trie->CursorKeyId(m_path.back()) : -1;
+}
+
+std::string_view Trie::Cursor::text() const {
+    return m_text;
+}
+
+size_t Trie::Cursor::matched_size() const {
+    return m_path.empty() ? 0 : m_path.size() - 1;
+}
+
 std::unique_ptr<Trie> Trie::Create() {
     return std::make_unique<TrieImpl>();
 }
 
+std::unique_ptr<Trie> Trie::CreateFrozen(std::vector<std::string> const &keys) {
+    return std::make_unique<FrozenTrieImpl>(DoubleArrayBuilder(keys).Build());
+}
+
+std::string Trie::CompileFrozen(std::vector<std::string> const &keys) {
+    auto units = DoubleArrayBuilder(keys).Build();
+    auto const *bytes = reinterpret_cast<char const *>(units.data());
+    return std::string(bytes, bytes + units.size() * sizeof(DoubleArrayUnit));
+}
+
+std::unique_ptr<Trie> Trie::MapFrozen(std::string_view data) {
+    if (data.empty() || data.size() % sizeof(DoubleArrayUnit) != 0 ||
+        reinterpret_cast<uintptr_t>(data.data()) % alignof(DoubleArrayUnit) != 0) {
+        return nullptr;
+    }
+
+    auto const *units = reinterpret_cast<DoubleArrayUnit const *>(data.data());
+    return std::make_unique<FrozenTrieImpl>(units, data.size() / sizeof(DoubleArrayUnit));
+}
+
 std::unique_ptr<Trie> Create(std::vector<std::string> const &words) {
     auto trie = std::make_unique<TrieImpl>();
     trie->Insert(words);
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <unordered_map>
 
 #include "utils/common.h"
@@ -10,11 +14,75 @@ namespace khiin::engine {
 
 class Trie {
   public:
+    /**
+     * A position in the trie that is moved one letter at a time, so that a
+     * query which grows by a letter per keystroke does not have to be
+     * walked again from the root. A cursor remembers the letters it has
+     * consumed and the node reached after each of them, so it can also be
+     * rewound, and copied to fork the search.
+     *
+     * Letters that lead off the trie are still consumed, and the cursor is
+     * no longer valid until they are rewound. A cursor is invalidated by
+     * Remove on the trie it walks.
+     */
+    class Cursor {
+      public:
+        Cursor() = default;
+        // A cursor that allocates from |resource| must not outlive it.
+        // Copies use the default resource.
+        explicit Cursor(Trie const *trie,
+                        std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+        // Returns false if the consumed letters no longer lead to a node
+        bool Advance(char ch);
+        bool Advance(std::string_view letters);
+
+        // Un-consumes the last |n| letters, or all of them
+        void Rewind(size_t n);
+
+        // Moves to |text|, keeping the part it shares with the current text
+        bool Seek(std::string_view text);
+
+        Cursor Fork() const;
+
+        // If the consumed letters are a key or a key prefix
+        bool valid() const;
+        bool IsKey() const;
+        bool IsKeyOrPrefix() const;
+        // Id of the key at the cursor, or -1
+        int KeyId() const;
+
+        std::string_view text() const;
+        // Number of leading letters of text() that lead to a node
+        size_t matched_size() const;
+
+      private:
+        Trie const *m_trie = nullptr;
+        std::pmr::string m_text;
+        // Node after each matched letter, starting with the root
+        std::pmr::vector<uintptr_t> m_path;
+    };
+
     //Trie() = default;
     virtual ~Trie() = default;
     // Trie(const string_vector &keys);
     static std::unique_ptr<Trie> Create();
 
+    // Builds a read-only double-array trie containing |keys|. Lookups walk
+    // flat arrays instead of hash maps, and the whole structure is a small
+    // fraction of the size of the mutable trie. Insert and Remove have no
+    // effect on a frozen trie.
+    static std::unique_ptr<Trie> CreateFrozen(std::vector<std::string> const &keys);
+
+    // Serializes the frozen trie of |keys| into a flat byte array that can be
+    // written to disk and later wrapped in place by MapFrozen.
+    static std::string CompileFrozen(std::vector<std::string> const &keys);
+
+    // Wraps |data| produced by CompileFrozen without copying it. |data| must
+    // be 4-byte aligned and outlive the returned trie. Returns nullptr if
+    // |data| cannot hold a frozen trie.
+    static std::unique_ptr<Trie> MapFrozen(std::string_view data);
+
     virtual void Insert(std::vector<std::string> const &words) = 0;
     virtual void Insert(std::string_view key) = 0;
     virtual bool Remove(std::string_view key) = 0;
@@ -22,8 +90,11 @@ class Trie {
     // If query matches any key from the start
     virtual bool StartsWithKey(std::string_view query) = 0;
 
-    virtual std::vector<std::vector<int>>
-    Multisplit(std::string_view query, std::unordered_map<std::string, float> const &cost_map, uint32_t limit) = 0;
+    // Returns up to |limit| of the cheapest ways to split |query| into keys,
+    // as lists of split positions. The cost of each key is looked up by its
+    // KeyId in |key_costs|; keys without a cost are not used.
+    virtual std::vector<std::vector<int>> Multisplit(std::string_view query, std::vector<float> const &key_costs,
+                                                     uint32_t limit) = 0;
 
     // If query is a key
     virtual bool HasKey(std::string_view query) = 0;
@@ -33,9 +104,29 @@ class Trie {
 
     virtual size_t LongestKeyOf(std::string_view query) = 0;
 
+    // Id of |query| if it is a key, otherwise -1. A frozen trie uses the
+    // index of the key in the list it was built from; the mutable trie
+    // numbers keys in insertion order.
+    virtual int KeyId(std::string_view query) = 0;
+
+    // Keys starting with |query|, in ascending KeyId order, which is the
+    // order of frequency for a dictionary trie. At most |limit| keys are
+    // returned and at most |max_depth| letters are added to |query|; 0
+    // means no limit.
     virtual std::vector<std::string> Autocomplete(std::string const &query, int limit = 0, int max_depth = 0) = 0;
+    // Letters that follow |query| in some key, ordered by the most frequent
+    // key below each. At most |limit| letters are returned; 0 means no limit.
+    virtual std::string NextLetters(std::string_view query, size_t limit = 0) = 0;
     // virtual void FindKeys(std::string_view query, bool fuzzy, string_vector &results) = 0;
     virtual void FindKeys(std::string_view query, std::vector<std::string> &results) = 0;
+
+  protected:
+    // Type-erased node primitives for Cursor
+    virtual uintptr_t CursorRoot() const = 0;
+    virtual bool CursorNext(uintptr_t &node, char ch) const = 0;
+    virtual bool CursorIsKey(uintptr_t node) const = 0;
+    virtual int CursorKeyId(uintptr_t node) const = 0;
+    virtual bool CursorHasChildren(uintptr_t node) const = 0;
 };
 
 } // namespace khiin::engine
@@ -4,13 +4,17 @@
 
 #include "Buffer.h"
 #include "BufferElement.h"
+#include "Candidate.h"
 #include "CandidateFinder.h"
+#include "CandidatePrefetcher.h"
 #include "Engine.h"
 #include "KhinHandler.h"
 #include "Lomaji.h"
 #include "config/Config.h"
 #include "config/KeyConfig.h"
 #include "data/Dictionary.h"
+#include "data/Splitter.h"
+#include "data/Trie.h"
 #include "proto/proto.h"
 #include "utils/unicode.h"
 
@@ -133,6 +137,13 @@ class BufferMgrImpl : public BufferMgr {
         m_nav_mode = NavMode::ByCharacter;
         m_focused_candidate = 0;
         m_focused_element = 0;
+        m_split_state = Splitter::State();
+        if (m_continuous_matcher) {
+            m_continuous_matcher->Clear();
+        }
+        if (m_prefetch_matcher) {
+            m_prefetch_matcher->Clear();
+        }
     }
 
     void Commit() override {
@@ -180,21 +191,40 @@ class BufferMgrImpl : public BufferMgr {
     }
 
     void Insert(char ch) override {
+        Insert(std::string_view(&ch, 1));
+    }
+
+    void Insert(std::string_view keys) override {
+        Insert(keys, nullptr);
+    }
+
+    bool Insert(std::string_view keys,
+                std::function<bool()> const &interrupted) override {
+        if (keys.empty()) {
+            return true;
+        }
+
+        auto edit_state = m_edit_state;
         m_edit_state = EditState::Composing;
 
         switch (input_mode()) {
             case InputMode::Continuous:
-                InsertContinuous(ch);
+                if (!InsertContinuous(keys, interrupted)) {
+                    m_edit_state = edit_state;
+                    return false;
+                }
                 break;
             case InputMode::Basic:
-                InsertBasic(ch);
+                InsertBasic(keys);
                 break;
             case InputMode::Manual:
-                InsertManual(ch);
+                InsertManual(keys);
                 break;
             default:
                 break;
         }
+
+        return true;
     }
 
     void Erase(CursorDirection direction) override {
@@ -287,6 +317,53 @@ class BufferMgrImpl : public BufferMgr {
         SelectCandidate_(index);
     }
 
+    bool PrefetchNextKey(std::function<bool()> const &stop) override {
+        auto *prefetcher = m_engine->candidate_prefetcher();
+        auto mode = input_mode();
+
+        // Only an unconverted composition is inserted into without first
+        // being split, so only then is the next query known in advance
+        if (prefetcher == nullptr || mode == InputMode::Manual ||
+            m_edit_state != EditState::Composing || !m_precomp.Empty() ||
+            !m_postcomp.Empty() || !m_composition.AllComposing()) {
+            return false;
+        }
+
+        auto raw_composition = m_composition.RawText();
+        auto raw_caret = m_composition.RawCaretFrom(m_caret);
+        auto caret_it = raw_composition.begin();
+        u8u::advance(caret_it, raw_caret);
+        auto raw_before = std::string(raw_composition.begin(), caret_it);
+        auto lgram = FocusLGram();
+
+        for (auto ch : LikelyNextKeys(raw_before, prefetcher->max_keys())) {
+            auto query = raw_composition;
+            query.insert(raw_before.size(), 1, ch);
+            auto key = PrefetchKey(mode, lgram, query);
+
+            if (prefetcher->Contains(key)) {
+                continue;
+            }
+
+            if (mode != InputMode::Continuous) {
+                prefetcher->Insert(
+                    std::move(key),
+                    CandidateFinder::MultiMatch(m_engine, lgram, query));
+                return true;
+            }
+
+            auto candidates = PrefetchMatch().MultiMatch(lgram, query, stop);
+            if (!candidates) {
+                return false;
+            }
+
+            prefetcher->Insert(std::move(key), std::move(candidates.value()));
+            return true;
+        }
+
+        return false;
+    }
+
     //+---------------------------------------------------------------------------
     //
     // BufferMgr private methods
@@ -431,14 +508,14 @@ class BufferMgrImpl : public BufferMgr {
         AdjustThenUpdateCaretAndFocus(raw_caret, focus_raw_caret);
     }
 
-    std::pair<std::string, size_t> BeginInsertion(char ch) {
+    std::pair<std::string, size_t> BeginInsertion(std::string_view keys) {
         SplitBufferForComposition();
         auto raw_composition = m_composition.RawText();
         auto raw_caret = m_composition.RawCaretFrom(m_caret);
         auto it = raw_composition.begin();
         u8u::advance(it, raw_caret);
-        raw_composition.insert(it, 1, ch);
-        ++raw_caret;
+        raw_composition.insert(it, keys.begin(), keys.end());
+        raw_caret += keys.size();
 
         return std::make_pair(raw_composition, raw_caret);
     }
@@ -449,21 +526,33 @@ class BufferMgrImpl : public BufferMgr {
         JoinBufferUpdateCaretAndFocus(raw_caret);
     }
 
-    void SetCompositionAndCandidatesContinuous(
-        std::string const &raw_composition) {
-        m_candidates = CandidateFinder::ContinuousMultiMatch(
-            m_engine, FocusLGram(), raw_composition);
-        m_composition = m_candidates[0];
+    // Returns false, leaving the candidates as they were, if the search
+    // was interrupted
+    bool SetCompositionAndCandidatesContinuous(
+        std::string const &raw_composition,
+        std::function<bool()> const &interrupted) {
+        if (!TakePrefetched(raw_composition)) {
+            auto candidates = ContinuousMatch().MultiMatch(
+                FocusLGram(), raw_composition, interrupted);
+            if (!candidates) {
+                return false;
+            }
+            m_candidates = std::move(candidates.value());
+        }
+        m_composition = m_candidates[0].Get(m_engine->syllable_parser());
         m_composition.SetConverted(false);
         assert(m_composition.RawText() == raw_composition);
+        return true;
     }
 
     void SetCompositionAndCandidatesBasic(std::string const &raw_composition) {
-        m_candidates = CandidateFinder::MultiMatch(
-            m_engine, FocusLGram(), raw_composition);
+        if (!TakePrefetched(raw_composition)) {
+            m_candidates = CandidateFinder::MultiMatch(
+                m_engine, FocusLGram(), raw_composition);
+        }
 
         if (!m_candidates.empty()) {
-            m_composition = m_candidates[0];
+            m_composition = m_candidates[0].Get(m_engine->syllable_parser());
             m_composition.SetConverted(false);
 
             auto raw_comp_size = u8_size(raw_composition);
@@ -490,20 +579,37 @@ class BufferMgrImpl : public BufferMgr {
         assert(m_composition.RawText() == raw_composition);
     }
 
-    void InsertContinuous(char ch) {
-        auto [raw_composition, raw_caret] = BeginInsertion(ch);
-        SetCompositionAndCandidatesContinuous(raw_composition);
+    bool InsertContinuous(std::string_view keys,
+                          std::function<bool()> const &interrupted) {
+        // BeginInsertion splits the buffer, which is undone if the search
+        // is interrupted
+        auto saved = interrupted ? std::make_optional(SavedBuffers{
+                                       m_composition, m_precomp,
+                                       m_postcomp, m_caret})
+                                 : std::nullopt;
+        auto [raw_composition, raw_caret] = BeginInsertion(keys);
+
+        if (!SetCompositionAndCandidatesContinuous(raw_composition,
+                                                   interrupted)) {
+            m_composition = std::move(saved->composition);
+            m_precomp = std::move(saved->precomp);
+            m_postcomp = std::move(saved->postcomp);
+            m_caret = saved->caret;
+            return false;
+        }
+
         FinalizeInsertion(raw_caret);
+        return true;
     }
 
-    void InsertBasic(char ch) {
-        auto [raw_composition, raw_caret] = BeginInsertion(ch);
+    void InsertBasic(std::string_view keys) {
+        auto [raw_composition, raw_caret] = BeginInsertion(keys);
         SetCompositionAndCandidatesBasic(raw_composition);
         FinalizeInsertion(raw_caret);
     }
 
-    void InsertManual(char ch) {
-        auto [raw_composition, raw_caret] = BeginInsertion(ch);
+    void InsertManual(std::string_view keys) {
+        auto [raw_composition, raw_caret] = BeginInsertion(keys);
         SetCompositionManual(raw_composition);
         FinalizeInsertion(raw_caret);
     }
@@ -573,7 +679,8 @@ class BufferMgrImpl : public BufferMgr {
 
         switch (input_mode()) {
             case InputMode::Continuous:
-                SetCompositionAndCandidatesContinuous(m_composition.RawText());
+                SetCompositionAndCandidatesContinuous(m_composition.RawText(),
+                                                      nullptr);
                 break;
             case InputMode::Basic:
                 SetCompositionAndCandidatesBasic(m_composition.RawText());
@@ -591,7 +698,7 @@ class BufferMgrImpl : public BufferMgr {
 
     size_t FocusCandidate_(size_t index, bool selected) {
         auto raw_caret = m_composition.RawCaretFrom(m_caret);
-        Buffer candidate = m_candidates.at(index);
+        Buffer candidate = m_candidates.at(index).Get(m_engine->syllable_parser());
         candidate.SetSelected(selected);
         auto adjusted_candidate_size = AdjustedSize(candidate);
 
@@ -613,9 +720,10 @@ class BufferMgrImpl : public BufferMgr {
                 raw_text.begin() + static_cast<int>(raw_candidate_size),
                 raw_text.end());
 
+            auto &split_state = SplitState();
             while (it != end) {
-                if (!CandidateFinder::HasExactMatch(m_engine, deconverted) ||
-                    deconverted.empty()) {
+                split_state.Seek(deconverted);
+                if (!split_state.CanSplit() || deconverted.empty()) {
                     deconverted.append(it->raw());
                     ++it;
                 } else {
@@ -685,9 +793,13 @@ class BufferMgrImpl : public BufferMgr {
         auto const &current = m_composition.At(m_focused_element);
 
         for (size_t i = 0; i < m_candidates.size(); ++i) {
-            auto &check = m_candidates.at(i).At(0);
+            auto &cand = m_candidates.at(i);
 
-            if (current == check) {
+            // Elements are equal when their converted text is, which for
+            // a word not yet built is the text of the candidate
+            auto *buffer = cand.buffer();
+            if (buffer != nullptr ? current == buffer->At(0)
+                                  : current.converted() == cand.Text()) {
                 m_focused_candidate = i;
                 return;
             }
@@ -712,9 +824,13 @@ class BufferMgrImpl : public BufferMgr {
         buffer.AdjustVirtualSpacing();
     }
 
-    void AdjustKhinAndSpacing(std::vector<Buffer> &buffers) {
-        for (auto &buffer : buffers) {
-            AdjustKhinAndSpacing(buffer);
+    // A single word is not changed by either, so only candidates that
+    // have been built need adjusting
+    void AdjustKhinAndSpacing(std::vector<Candidate> &candidates) {
+        for (auto &candidate : candidates) {
+            if (auto *buffer = candidate.buffer()) {
+                AdjustKhinAndSpacing(*buffer);
+            }
         }
     }
 
@@ -812,6 +928,96 @@ class BufferMgrImpl : public BufferMgr {
         return m_engine->config()->input_mode();
     }
 
+    //+----------------------------------
+    // Prefetching
+    //
+
+    static std::string PrefetchKey(InputMode mode,
+                                   std::optional<TaiToken> const &lgram,
+                                   std::string const &query) {
+        return CandidatePrefetcher::Key(
+            mode,
+            lgram ? std::make_optional(std::string(lgram->output))
+                  : std::nullopt,
+            query);
+    }
+
+    bool TakePrefetched(std::string const &raw_composition) {
+        auto *prefetcher = m_engine->candidate_prefetcher();
+        return prefetcher != nullptr &&
+               prefetcher->Take(
+                   PrefetchKey(input_mode(), FocusLGram(), raw_composition),
+                   m_candidates);
+    }
+
+    // Letters that continue the longest word prefix ending at the caret,
+    // followed by letters that begin a new word, each by the most frequent
+    // word they lead to
+    std::string LikelyNextKeys(std::string const &raw_before, size_t limit) {
+        auto *trie = m_engine->dictionary()->word_trie();
+        auto ret = std::string();
+
+        auto add_letters = [&](std::string_view prefix) {
+            for (auto ch : trie->NextLetters(prefix)) {
+                if (ret.size() >= limit) {
+                    return;
+                }
+                if (ret.find(ch) == std::string::npos) {
+                    ret.push_back(ch);
+                }
+            }
+        };
+
+        for (size_t start = 0; start < raw_before.size(); ++start) {
+            auto prefix = std::string_view(raw_before).substr(start);
+            if (trie->HasKeyOrPrefix(prefix)) {
+                add_letters(prefix);
+                break;
+            }
+        }
+        add_letters(std::string_view());
+
+        return ret;
+    }
+
+    // Kept apart from the matcher used by Insert, since it is fed the
+    // speculative queries
+    ContinuousMatcher &PrefetchMatch() {
+        auto limits = SearchLimits();
+        if (!m_prefetch_matcher || m_prefetch_matcher->limits() != limits) {
+            m_prefetch_matcher = ContinuousMatcher::Create(m_engine, limits);
+        }
+        return *m_prefetch_matcher;
+    }
+
+    // The split table is kept for the whole composition, so that checking
+    // a string that grew or shrank by a few letters does not start over
+    Splitter::State &SplitState() {
+        auto *splitter = m_engine->dictionary()->word_splitter();
+        if (m_split_state.splitter() != splitter) {
+            m_split_state = Splitter::State(splitter);
+        }
+        return m_split_state;
+    }
+
+    // Kept for the whole composition, so that a keystroke only converts
+    // the part of the composition it changed
+    ContinuousMatcher &ContinuousMatch() {
+        auto limits = SearchLimits();
+        if (!m_continuous_matcher || m_continuous_matcher->limits() != limits) {
+            m_continuous_matcher = ContinuousMatcher::Create(m_engine, limits);
+        }
+        return *m_continuous_matcher;
+    }
+
+    SentenceSearchLimits SearchLimits() {
+        auto *config = m_engine->config();
+        auto ret = SentenceSearchLimits();
+        ret.beam_width = static_cast<size_t>(config->sentence_beam_width());
+        ret.max_results = static_cast<size_t>(config->sentence_max_results());
+        return ret;
+    }
+
     // SyllableParser *parser() {
     //    return m_engine->syllable_parser();
     //}
@@ -821,16 +1027,26 @@ class BufferMgrImpl : public BufferMgr {
         BySegment,
     };
 
+    struct SavedBuffers {
+        Buffer composition;
+        Buffer precomp;
+        Buffer postcomp;
+        utf8_size_t caret = 0;
+    };
+
     Engine *m_engine = nullptr;
     utf8_size_t m_caret = 0;
     Buffer m_composition;  // Elements in the composition
     Buffer m_precomp;      // Converted elements before the composition
     Buffer m_postcomp;     // Converted elements after the composition
-    std::vector<Buffer> m_candidates;
+    std::vector<Candidate> m_candidates;
     size_t m_focused_candidate = 0;
     size_t m_focused_element = 0;
     EditState m_edit_state = EditState::Empty;
     NavMode m_nav_mode = NavMode::ByCharacter;
+    Splitter::State m_split_state;
+    std::unique_ptr<ContinuousMatcher> m_continuous_matcher;
+    std::unique_ptr<ContinuousMatcher> m_prefetch_matcher;
 };
 
 }  // namespace
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string_view>
 
 #include "utils/common.h"
 
@@ -89,6 +91,22 @@ class BufferMgr {
      */
     virtual void Insert(char ch) = 0;
 
+    /**
+     * Insert several ascii characters at the caret at once. The
+     * composition and candidates are only searched for the text with
+     * all of |keys| inserted, not for each character along the way.
+     */
+    virtual void Insert(std::string_view keys) = 0;
+
+    /**
+     * Same as above, but in continuous mode the candidate search gives up
+     * once |interrupted| returns true. The buffer is then left as it was
+     * and |false| is returned, so the keys can be inserted again together
+     * with the ones that interrupted them.
+     */
+    virtual bool Insert(std::string_view keys,
+                        std::function<bool()> const &interrupted) = 0;
+
     /**
      * Erase one logical character in |direction| from the caret position
      * Logical characters include e.g. tone marks and diacritics
@@ -152,6 +170,17 @@ class BufferMgr {
      * must be updated before display.
      */
     virtual void SelectCandidate(size_t id) = 0;
+
+    /**
+     * While composing, computes the candidates for one of the keys most
+     * likely to be typed next, and stores them in the engine's
+     * CandidatePrefetcher for |Insert| to use. Keys are tried in order of
+     * the most frequent word they could continue or begin. The sentence
+     * search of the continuous mode gives up without storing anything
+     * once |stop| returns true. Returns |false| when there is no key left
+     * to prefetch or the search gave up.
+     */
+    virtual bool PrefetchNextKey(std::function<bool()> const &stop) = 0;
 };
 
 } // namespace khiin::engine
@@ -0,0 +1,59 @@
+#include "Candidate.h"
+
+namespace khiin::engine {
+
+Candidate::Candidate(Buffer buffer) : m_buffer(std::move(buffer)) {}
+
+Candidate::Candidate(std::string input, TaiToken token) : m_input(std::move(input)), m_token(std::move(token)) {}
+
+Buffer &Candidate::Get(SyllableParser *parser) {
+    if (!m_buffer) {
+        m_buffer = Buffer(BufferElement::Builder()
+                              .Parser(parser)
+                              .FromInput(m_input)
+                              .WithTaiToken(m_token.value())
+                              .SetConverted()
+                              .SetCandidate()
+                              .Build());
+    }
+
+    return m_buffer.value();
+}
+
+Buffer *Candidate::buffer() {
+    return m_buffer ? &m_buffer.value() : nullptr;
+}
+
+Buffer const *Candidate::buffer() const {
+    return m_buffer ? &m_buffer.value() : nullptr;
+}
+
+TaiToken const *Candidate::token() const {
+    return m_token ? &m_token.value() : nullptr;
+}
+
+std::string Candidate::Text() const {
+    if (m_buffer) {
+        return m_buffer->Text();
+    }
+
+    return TaiText::ConvertedText(m_input, m_token.value());
+}
+
+std::string Candidate::RawText() const {
+    if (m_buffer) {
+        return m_buffer->RawText();
+    }
+
+    return m_input;
+}
+
+size_t Candidate::Size() const {
+    if (m_buffer) {
+        return m_buffer->Size();
+    }
+
+    return 1;
+}
+
+} // namespace khiin::engine
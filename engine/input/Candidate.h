@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "Buffer.h"
+#include "data/Models.h"
+
+namespace khiin::engine {
+
+class SyllableParser;
+
+// One entry of a candidate list. A single dictionary word is kept as its
+// token and input until the candidate is focused or selected, since most
+// candidates are only ever shown by their text. Other candidates are built
+// when they are found.
+class Candidate {
+  public:
+    explicit Candidate(Buffer buffer);
+    Candidate(std::string input, TaiToken token);
+
+    // Builds the buffer on first use
+    Buffer &Get(SyllableParser *parser);
+
+    // The buffer, or nullptr if it has not been built yet
+    Buffer *buffer();
+    Buffer const *buffer() const;
+
+    // The conversion of a single word candidate, or nullptr
+    TaiToken const *token() const;
+
+    std::string Text() const;
+    std::string RawText() const;
+    size_t Size() const;
+
+  private:
+    std::string m_input;
+    std::optional<TaiToken> m_token;
+    std::optional<Buffer> m_buffer;
+};
+
+} // namespace khiin::engine
@@ -0,0 +1,187 @@
+#include "CandidateCache.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "Engine.h"
+#include "data/Dictionary.h"
+
+namespace khiin::engine {
+namespace {
+
+// Separates the parts of a key, and never appears in raw input
+constexpr char kKeySeparator = '\x1f';
+
+std::string CacheKey(CachedMatch match, std::optional<std::string> const &lgram, std::string const &query) {
+    auto ret = std::string(1, static_cast<char>('0' + static_cast<int>(match)));
+    if (lgram) {
+        ret.push_back('+');
+        ret.append(lgram.value());
+    }
+    ret.push_back(kKeySeparator);
+    ret.append(query);
+    return ret;
+}
+
+class CandidateCacheImpl : public CandidateCache {
+  public:
+    CandidateCacheImpl(Engine *engine, size_t capacity) : m_engine(engine), m_capacity(capacity) {
+        if (m_engine == nullptr) {
+            return;
+        }
+
+        m_engine->RegisterConfigChangedListener(this);
+        if (auto *db = m_engine->database()) {
+            db->RegisterNGramChangeListener(this);
+        }
+    }
+
+    ~CandidateCacheImpl() override {
+        if (m_engine == nullptr) {
+            return;
+        }
+
+        if (auto *db = m_engine->database()) {
+            db->UnregisterNGramChangeListener(this);
+        }
+    }
+
+    bool Find(CachedMatch match, std::optional<std::string> const &lgram, std::string const &query,
+              std::vector<Candidate> &output) override {
+        CheckDictionary();
+
+        auto it = m_index.find(CacheKey(match, lgram, query));
+        if (it == m_index.end()) {
+            ++m_misses;
+            return false;
+        }
+
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        output = it->second->result;
+        return true;
+    }
+
+    void Insert(CachedMatch match, std::optional<std::string> const &lgram, std::string const &query,
+                std::vector<Candidate> const &result, std::vector<std::string> grams) override {
+        if (m_capacity == 0) {
+            return;
+        }
+
+        CheckDictionary();
+        auto key = CacheKey(match, lgram, query);
+
+        if (auto it = m_index.find(key); it != m_index.end()) {
+            Erase(it->second);
+        }
+
+        if (lgram) {
+            grams.push_back(lgram.value());
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+        m_entries.push_front(Entry{key, result, std::move(grams)});
+        m_index.emplace(std::move(key), m_entries.begin());
+
+        while (m_entries.size() > m_capacity) {
+            Erase(std::prev(m_entries.end()));
+        }
+    }
+
+    void Clear() override {
+        m_entries.clear();
+        m_index.clear();
+        ++m_generation;
+    }
+
+    uint64_t generation() const override {
+        return m_generation;
+    }
+
+    size_t size() const override {
+        return m_entries.size();
+    }
+
+    size_t hits() const override {
+        return m_hits;
+    }
+
+    size_t misses() const override {
+        return m_misses;
+    }
+
+    void OnConfigChanged(Config *config) override {
+        Clear();
+    }
+
+    void OnNGramsChanged(std::vector<std::string> const &grams) override {
+        ++m_generation;
+        auto it = m_entries.begin();
+        while (it != m_entries.end()) {
+            auto const &ranked_with = it->grams;
+            auto affected = std::any_of(grams.begin(), grams.end(), [&](std::string const &gram) {
+                return std::binary_search(ranked_with.begin(), ranked_with.end(), gram);
+            });
+
+            if (affected) {
+                m_index.erase(it->key);
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void OnNGramsCleared() override {
+        Clear();
+    }
+
+  private:
+    struct Entry {
+        std::string key;
+        std::vector<Candidate> result;
+        // Sorted outputs the result was ranked with
+        std::vector<std::string> grams;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void Erase(EntryList::iterator it) {
+        m_index.erase(it->key);
+        m_entries.erase(it);
+    }
+
+    // The dictionary rebuilds its tables when it is initialized again
+    void CheckDictionary() {
+        if (m_engine == nullptr) {
+            return;
+        }
+
+        auto *dictionary = m_engine->dictionary();
+        auto const *trie = dictionary != nullptr ? dictionary->word_trie() : nullptr;
+        if (trie != m_word_trie) {
+            Clear();
+            m_word_trie = trie;
+        }
+    }
+
+    Engine *m_engine = nullptr;
+    size_t m_capacity = 0;
+    Trie const *m_word_trie = nullptr;
+    // Most recently used first
+    EntryList m_entries;
+    std::unordered_map<std::string, EntryList::iterator> m_index;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+    uint64_t m_generation = 0;
+};
+
+} // namespace
+
+std::unique_ptr<CandidateCache> CandidateCache::Create(Engine *engine, size_t capacity) {
+    return std::make_unique<CandidateCacheImpl>(engine, capacity);
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Candidate.h"
+#include "config/Config.h"
+#include "data/Database.h"
+
+namespace khiin::engine {
+
+class Engine;
+
+enum class CachedMatch {
+    MultiMatch,
+    OneSplittable,
+};
+
+/**
+ * Bounded LRU cache of CandidateFinder results, keyed by the kind of match,
+ * the output of the left context and the raw query. Moving the caret,
+ * focusing a segment or erasing and retyping a key often asks for results
+ * that were found a moment earlier.
+ *
+ * Each entry keeps the outputs it was ranked with, and is dropped when the
+ * n-gram counts of any of them change. The whole cache is cleared when the
+ * dictionary, user dictionary or config changes.
+ */
+class CandidateCache : public ConfigChangeListener, public NGramChangeListener {
+  public:
+    static constexpr size_t kDefaultCapacity = 256;
+
+    CandidateCache() = default;
+    CandidateCache(CandidateCache const &) = delete;
+    CandidateCache &operator=(CandidateCache const &) = delete;
+    virtual ~CandidateCache() = default;
+
+    // Without an |engine|, the cache is only cleared when asked to
+    static std::unique_ptr<CandidateCache> Create(Engine *engine, size_t capacity = kDefaultCapacity);
+
+    // Copies a cached result into |output| and returns true on a hit
+    virtual bool Find(CachedMatch match, std::optional<std::string> const &lgram, std::string const &query,
+                      std::vector<Candidate> &output) = 0;
+
+    // |grams| are the outputs that the result was ranked with, including
+    // any that did not make it into the result
+    virtual void Insert(CachedMatch match, std::optional<std::string> const &lgram, std::string const &query,
+                        std::vector<Candidate> const &result, std::vector<std::string> grams) = 0;
+
+    virtual void Clear() = 0;
+
+    // Changes whenever results found earlier may be out of date: the cache
+    // was cleared or some n-gram counts changed. For anything else that
+    // keeps results, such as ContinuousMatcher.
+    virtual uint64_t generation() const = 0;
+
+    virtual size_t size() const = 0;
+    virtual size_t hits() const = 0;
+    virtual size_t misses() const = 0;
+};
+
+} // namespace khiin::engine
@@ -1,7 +1,15 @@
 #include "CandidateFinder.h"
 
+#include <algorithm>
 #include <cassert>
-
+#include <cctype>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+
+#include "CandidateCache.h"
 #include "Engine.h"
 #include "Segmenter.h"
 #include "SyllableParser.h"
@@ -11,14 +19,13 @@
 #include "data/Splitter.h"
 #include "data/Trie.h"
 #include "data/UserDictionary.h"
+#include "utils/CommandArena.h"
 
 namespace khiin::engine {
 
 namespace {
 using namespace unicode;
 
-constexpr uint32_t kNumberOfContinuousCandidates = 5;
-
 inline bool IsHigherFrequency(TaiToken const& a, TaiToken const& b) {
     //return a.input_id == b.input_id ? a.weight > b.weight
     //                                : a.input_id < b.input_id;
@@ -94,35 +101,25 @@ std::optional<TaiToken> BestAutocomplete(
     return BestMatchNgram(engine, lgram, options);
 }
 
-std::optional<TaiToken> BestSingleTokenMatch(
-    Engine* engine, std::optional<TaiToken> lgram, std::string const& input) {
-    auto options = engine->dictionary()->WordSearch(copy_str_tolower(input));
-    return BestMatchNgram(engine, lgram, options);
-}
-
-std::vector<Buffer> TokensToBuffers(
-    Engine* engine, std::vector<TaiToken> const& options,
-    std::string const& query) {
-    auto ret = std::vector<Buffer>();
-    auto* parser = engine->syllable_parser();
+std::vector<Candidate> TokensToCandidates(
+    std::vector<TaiToken> const& options, std::string const& query) {
+    auto ret = std::vector<Candidate>();
+    ret.reserve(options.size());
 
     for (auto const& option : options) {
-        auto elem = BufferElement::Builder()
-                        .Parser(parser)
-                        .FromInput(query.substr(0, option.input_size))
-                        .WithTaiToken(option)
-                        .SetConverted()
-                        .SetCandidate()
-                        .Build();
-
-        ret.push_back(Buffer(std::move(elem)));
+        ret.emplace_back(query.substr(0, option.input_size), option);
     }
 
     return ret;
 }
 
-std::set<size_t> InvalidSplitIndices(Engine* engine, std::string const& query) {
-    auto ret = std::set<size_t>();
+// Scratch memory that is released once the current command is handled
+std::pmr::memory_resource* Scratch(Engine* engine) {
+    return engine->command_arena()->resource();
+}
+
+std::pmr::set<size_t> InvalidSplitIndices(Engine* engine, std::string const& query) {
+    auto ret = std::pmr::set<size_t>(Scratch(engine));
 
     if (query.size() <= 1) {
         return ret;
@@ -141,7 +138,7 @@ void DedupeAndSortTokenResultSet(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query, std::vector<TaiToken>& options) {
     //auto* keyconfig = engine->keyconfig();
-    auto seen = std::set<std::string>();
+    auto seen = std::pmr::unordered_set<InternedString>(Scratch(engine));
     auto invalid_sizes = InvalidSplitIndices(engine, query);
 
     auto it = options.begin();
@@ -170,7 +167,7 @@ void DedupeAndSortTokenResultSet(
     SortTokenResults(engine, lgram, options);
 }
 
-std::vector<Buffer> AllWordsFromStart(
+std::vector<Candidate> AllWordsFromStart(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query) {
     // auto ret = std::vector<Buffer>();
@@ -179,32 +176,529 @@ std::vector<Buffer> AllWordsFromStart(
 
     DedupeAndSortTokenResultSet(engine, lgram, query, options);
 
-    return TokensToBuffers(engine, options, query);
+    return TokensToCandidates(options, query);
 }
 
-Buffer WordsToBuffer(Engine* engine, std::vector<std::string> const& words) {
+// Sum of the ranking keys of the tokens on a path. The sum of the word
+// costs of its segmentation comes first, since a path with more words also
+// sums more n-gram counts and weights; the conversions of one segmentation
+// are then compared in the same order as CompareTokenResultsByLengthFirst
+// ranks single tokens.
+struct PathScore {
+    size_t bigram_count = 0;
+    size_t unigram_count = 0;
+    float cost = 0;
+    int64_t weight = 0;
+
+    PathScore Plus(TaiToken const& token, size_t bigram_count) const {
+        return PathScore{this->bigram_count + bigram_count,
+                         this->unigram_count + token.unigram_count, cost,
+                         weight + token.weight};
+    }
+
+    bool operator<(PathScore const& other) const {
+        return std::tie(other.cost, bigram_count, unigram_count, weight) <
+               std::tie(cost, other.bigram_count, other.unigram_count,
+                        other.weight);
+    }
+};
+
+/**
+ * Chooses the conversion of every word in a segmentation together, with one
+ * lattice node per (word, conversion). An edge between the conversions of
+ * adjacent words is scored with the bigram count of the pair, and each node
+ * with its own unigram count and weight. The best full path is found in a
+ * single Viterbi pass, so a later word can change the choice for an earlier
+ * one. Counts come from the in-memory n-gram table, so decoding does not
+ * query the database.
+ */
+class SentenceLattice {
+   public:
+    SentenceLattice(Engine* engine, std::optional<TaiToken> const& lgram,
+                    std::vector<std::string> const& words)
+        : m_engine(engine) {
+        m_columns.reserve(words.size());
+        for (auto const& word : words) {
+            AddColumn(word, lgram);
+        }
+    }
+
+    // Best conversion of each word, or nullopt for a word without any
+    std::vector<std::optional<TaiToken>> BestPath() const {
+        auto ret = std::vector<std::optional<TaiToken>>(m_columns.size());
+        auto node = BestNode(m_columns.size());
+
+        for (auto i = m_columns.size(); i-- > 0;) {
+            auto const& column = m_columns[i];
+            if (column.nodes.empty()) {
+                continue;
+            }
+
+            ret[i] = column.options[node];
+            node = column.nodes[node].prev;
+        }
+
+        return ret;
+    }
+
+    // Outputs of every conversion that was ranked, chosen or not
+    std::vector<std::string> Outputs() const {
+        auto ret = std::vector<std::string>();
+        for (auto const& column : m_columns) {
+            for (auto const& option : column.options) {
+                ret.emplace_back(option.output);
+            }
+        }
+        return ret;
+    }
+
+   private:
+    struct Node {
+        PathScore score;
+        // Node of the previous non-empty column on the best path here
+        int prev = -1;
+    };
+
+    struct Column {
+        std::vector<TaiToken> options;
+        std::vector<Node> nodes;
+    };
+
+    void AddColumn(std::string const& word,
+                   std::optional<TaiToken> const& lgram) {
+        auto& column = m_columns.emplace_back();
+        column.options =
+            m_engine->dictionary()->WordSearch(copy_str_tolower(word));
+        if (column.options.empty()) {
+            return;
+        }
+
+        // Ties are broken in favour of the default order
+        SortTokensByDefault(column.options);
+        auto* prev = PreviousColumn();
+        auto* db = m_engine->database();
+        column.nodes.resize(column.options.size());
+
+        if (prev == nullptr) {
+            std::optional<std::string> lgram_str = std::nullopt;
+            if (lgram) {
+                lgram_str = lgram->output;
+            }
+            db->AddNGramsData(lgram_str, column.options);
+            for (size_t j = 0; j < column.options.size(); ++j) {
+                auto const& option = column.options[j];
+                column.nodes[j].score =
+                    PathScore().Plus(option, option.bigram_count);
+            }
+            return;
+        }
+
+        db->AddNGramsData(std::nullopt, column.options);
+        for (size_t k = 0; k < prev->options.size(); ++k) {
+            for (auto& option : column.options) {
+                option.bigram_count = 0;
+            }
+            db->AddNGramsData(std::string(prev->options[k].output),
+                              column.options);
+
+            for (size_t j = 0; j < column.options.size(); ++j) {
+                auto const& option = column.options[j];
+                auto score = prev->nodes[k].score.Plus(option,
+                                                       option.bigram_count);
+                auto& node = column.nodes[j];
+                if (node.prev == -1 || node.score < score) {
+                    node.score = score;
+                    node.prev = static_cast<int>(k);
+                }
+            }
+        }
+    }
+
+    // Last column before the one being added that has any conversions.
+    // Words without conversions do not break the bigram chain.
+    Column const* PreviousColumn() const {
+        for (auto i = m_columns.size() - 1; i-- > 0;) {
+            if (!m_columns[i].nodes.empty()) {
+                return &m_columns[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Best node of the last non-empty column before |end|
+    int BestNode(size_t end) const {
+        for (auto i = end; i-- > 0;) {
+            auto const& nodes = m_columns[i].nodes;
+            if (nodes.empty()) {
+                continue;
+            }
+
+            auto best = 0;
+            for (size_t j = 1; j < nodes.size(); ++j) {
+                if (nodes[best].score < nodes[j].score) {
+                    best = static_cast<int>(j);
+                }
+            }
+            return best;
+        }
+        return -1;
+    }
+
+    Engine* m_engine = nullptr;
+    std::vector<Column> m_columns;
+};
+
+// |grams|, if given, receives the outputs that the conversions were ranked
+// with
+Buffer WordsToBuffer(Engine* engine, std::optional<TaiToken> const& lgram,
+                     std::vector<std::string> const& words,
+                     std::vector<std::string>* grams = nullptr) {
     auto* parser = engine->syllable_parser();
     auto ret = Buffer();
-    std::optional<TaiToken> prev_best_match = std::nullopt;
-    for (auto const& word : words) {
-        auto best_match = BestSingleTokenMatch(engine, prev_best_match, word);
+    auto lattice = SentenceLattice(engine, lgram, words);
+    auto best_path = lattice.BestPath();
+    if (grams != nullptr) {
+        *grams = lattice.Outputs();
+    }
+
+    for (size_t i = 0; i < words.size(); ++i) {
         auto elem = BufferElement::Builder()
                         .Parser(parser)
-                        .FromInput(word)
+                        .FromInput(words[i])
                         .SetCandidate()
                         .SetConverted();
 
-        if (best_match) {
-            elem.WithTaiToken(best_match.value());
+        if (best_path[i]) {
+            elem.WithTaiToken(best_path[i].value());
         }
 
         ret.Append(elem.Build());
-
-        prev_best_match = best_match;
     }
     return ret;
 }
 
+std::optional<std::string> OutputOf(std::optional<TaiToken> const& token) {
+    if (token) {
+        return std::string(token->output);
+    }
+    return std::nullopt;
+}
+
+char ToLower(char ch) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+}
+
+/**
+ * Searches the conversions of whole sentences of a splittable query, for
+ * the continuous mode candidate list.
+ *
+ * Every dictionary word in the query is a word of the lattice, and is
+ * added once its last letter is appended. Partial sentences ending at a
+ * position are found by extending the sentences ending where each of its
+ * words starts, and only the best |beam_width| of them are kept. Each word
+ * only offers its best |beam_width| conversions by unigram count and
+ * weight, so the search stays bounded however many homophones a word has.
+ *
+ * Nothing at a position depends on the letters after it, so the search
+ * resumes from where a new query differs from the last one: typing or
+ * erasing at the end only finds the words ending at the changed letters.
+ */
+class SentenceBeam {
+   public:
+    SentenceBeam(Engine* engine, SentenceSearchLimits const& limits)
+        : m_engine(engine), m_limits(limits) {}
+
+    // Moves to |query| following |lgram|, keeping everything found for
+    // the part it shares with the current query. Returns false if
+    // |interrupted| returned true before the last letter, in which case
+    // the letters appended so far are kept.
+    bool Seek(std::optional<TaiToken> const& lgram, std::string const& query,
+              std::function<bool()> const& interrupted = nullptr) {
+        auto const* trie = m_engine->dictionary()->word_trie();
+        if (trie != m_trie || OutputOf(lgram) != OutputOf(m_lgram) ||
+            m_positions.empty()) {
+            Reset(trie, lgram);
+        }
+
+        auto mismatch = std::mismatch(m_text.begin(), m_text.end(),
+                                      query.begin(), query.end());
+        auto common = static_cast<size_t>(
+            std::distance(m_text.begin(), mismatch.first));
+        Truncate(common);
+
+        for (auto i = common; i < query.size(); ++i) {
+            if (interrupted && interrupted()) {
+                return false;
+            }
+            Append(query[i]);
+        }
+
+        return true;
+    }
+
+    void Clear() {
+        m_trie = nullptr;
+        m_positions.clear();
+    }
+
+    // The best distinct sentences for the whole query, in ranked order
+    std::vector<Buffer> Search() const {
+        auto ret = std::vector<Buffer>();
+        if (m_positions.empty()) {
+            return ret;
+        }
+
+        auto seen = std::pmr::unordered_set<std::string>(Scratch(m_engine));
+        for (auto hyp : m_positions.back().beam) {
+            if (ret.size() == m_limits.max_results) {
+                break;
+            }
+
+            auto buf = ToBuffer(hyp);
+            if (seen.insert(buf.Text()).second) {
+                ret.push_back(std::move(buf));
+            }
+        }
+
+        return ret;
+    }
+
+   private:
+    struct Word {
+        size_t start = 0;
+        float cost = 0;
+        std::vector<TaiToken> options;
+        // Built on first use, one per option, or one if there are none
+        mutable std::vector<std::optional<BufferElement>> elements;
+    };
+
+    // A sentence up to some position of the query
+    struct Hypothesis {
+        PathScore score;
+        int prev = -1;
+        // Last word, as an index into the words ending at |end|
+        size_t end = 0;
+        int word = -1;
+        // Index of the conversion of the word, or -1 if it has none
+        int option = -1;
+        // Hypothesis whose conversion is the left context of the next word
+        int context = -1;
+    };
+
+    struct Position {
+        // Word being read from this position, if sentences end here
+        Trie::Cursor word;
+        std::vector<Word> words;
+        // Sentences ending here as indices into |m_hyps|, best first
+        std::vector<int> beam;
+        // Size of |m_hyps| once this position was complete
+        size_t hyp_count = 0;
+    };
+
+    void Reset(Trie const* trie, std::optional<TaiToken> const& lgram) {
+        m_trie = trie;
+        m_lgram = lgram;
+        m_text.clear();
+        m_hyps.clear();
+        m_hyps.push_back(Hypothesis());
+        m_positions.clear();
+        auto& root = m_positions.emplace_back();
+        root.word = Trie::Cursor(m_trie);
+        root.beam.push_back(0);
+        root.hyp_count = m_hyps.size();
+        m_open.assign(1, 0);
+    }
+
+    void Append(char ch) {
+        m_text.push_back(ch);
+        auto const end = m_text.size();
+        m_positions.emplace_back();
+
+        auto open_end = m_open.begin();
+        for (auto start : m_open) {
+            auto& cursor = m_positions[start].word;
+            if (!cursor.Advance(ToLower(ch))) {
+                continue;
+            }
+
+            if (auto key_id = cursor.KeyId(); key_id >= 0) {
+                AddWord(start, end, key_id);
+            }
+            *open_end++ = start;
+        }
+        m_open.erase(open_end, m_open.end());
+
+        auto& position = m_positions[end];
+        for (size_t i = 0; i < position.words.size(); ++i) {
+            Extend(end, static_cast<int>(i));
+        }
+        SortBeam(position.beam);
+        if (position.beam.size() > m_limits.beam_width) {
+            position.beam.resize(m_limits.beam_width);
+        }
+        position.hyp_count = m_hyps.size();
+
+        if (!position.beam.empty()) {
+            position.word = Trie::Cursor(m_trie);
+            m_open.push_back(end);
+        }
+    }
+
+    // Keeps the first |size| letters
+    void Truncate(size_t size) {
+        if (size >= m_text.size()) {
+            return;
+        }
+
+        m_text.resize(size);
+        m_positions.resize(size + 1);
+        m_hyps.resize(m_positions[size].hyp_count);
+        m_open.clear();
+
+        for (size_t start = 0; start <= size; ++start) {
+            auto& position = m_positions[start];
+            if (position.beam.empty()) {
+                continue;
+            }
+
+            auto& cursor = position.word;
+            if (auto n = cursor.text().size(); n > size - start) {
+                cursor.Rewind(n - (size - start));
+            }
+
+            if (cursor.valid()) {
+                m_open.push_back(start);
+            }
+        }
+    }
+
+    void AddWord(size_t start, size_t end, int key_id) {
+        auto* dictionary = m_engine->dictionary();
+        auto const& costs = dictionary->word_splitter()->costs();
+        if (static_cast<size_t>(key_id) >= costs.size()) {
+            return;
+        }
+
+        auto& word = m_positions[end].words.emplace_back();
+        word.start = start;
+        word.cost = costs[key_id];
+
+        auto key = std::string(m_text, start, end - start);
+        std::transform(key.begin(), key.end(), key.begin(), ToLower);
+        word.options = dictionary->WordSearch(key);
+        SortTokensByDefault(word.options);
+        m_engine->database()->AddNGramsData(std::nullopt, word.options);
+        std::stable_sort(word.options.begin(), word.options.end(),
+                         [](TaiToken const& a, TaiToken const& b) {
+                             return a.unigram_count > b.unigram_count;
+                         });
+        if (word.options.size() > m_limits.beam_width) {
+            word.options.resize(m_limits.beam_width);
+        }
+        word.elements.resize((std::max)(word.options.size(), size_t(1)));
+    }
+
+    void Extend(size_t end, int word_index) {
+        auto& word = m_positions[end].words[word_index];
+        auto& next = m_positions[end].beam;
+
+        for (auto hyp_index : m_positions[word.start].beam) {
+            auto const hyp = m_hyps[hyp_index];
+            auto score = hyp.score;
+            score.cost += word.cost;
+
+            if (word.options.empty()) {
+                next.push_back(static_cast<int>(m_hyps.size()));
+                m_hyps.push_back(Hypothesis{score, hyp_index, end, word_index,
+                                            -1, hyp.context});
+                continue;
+            }
+
+            for (auto& option : word.options) {
+                option.bigram_count = 0;
+            }
+            if (auto const* context = Context(hyp)) {
+                m_engine->database()->AddNGramsData(
+                    std::string(context->output), word.options);
+            }
+
+            for (size_t i = 0; i < word.options.size(); ++i) {
+                auto const& option = word.options[i];
+                auto index = static_cast<int>(m_hyps.size());
+                next.push_back(index);
+                m_hyps.push_back(
+                    Hypothesis{score.Plus(option, option.bigram_count),
+                               hyp_index, end, word_index,
+                               static_cast<int>(i), index});
+            }
+        }
+    }
+
+    Word const& WordOf(Hypothesis const& hyp) const {
+        return m_positions[hyp.end].words[hyp.word];
+    }
+
+    TaiToken const* Context(Hypothesis const& hyp) const {
+        if (hyp.context == -1) {
+            return m_lgram ? &m_lgram.value() : nullptr;
+        }
+
+        auto const& context = m_hyps[hyp.context];
+        return &WordOf(context).options[context.option];
+    }
+
+    void SortBeam(std::vector<int>& beam) const {
+        std::stable_sort(beam.begin(), beam.end(), [this](int a, int b) {
+            return m_hyps[b].score < m_hyps[a].score;
+        });
+    }
+
+    BufferElement const& Element(Hypothesis const& hyp) const {
+        auto const& word = WordOf(hyp);
+        auto& element = word.elements[hyp.option == -1 ? 0 : hyp.option];
+
+        if (!element) {
+            auto builder =
+                BufferElement::Builder()
+                    .Parser(m_engine->syllable_parser())
+                    .FromInput(m_text.substr(word.start, hyp.end - word.start))
+                    .SetCandidate()
+                    .SetConverted();
+            if (hyp.option != -1) {
+                builder.WithTaiToken(word.options[hyp.option]);
+            }
+            element = builder.Build();
+        }
+
+        return element.value();
+    }
+
+    Buffer ToBuffer(int hyp_index) const {
+        auto path = std::pmr::vector<Hypothesis const*>(Scratch(m_engine));
+        for (auto i = hyp_index; m_hyps[i].word != -1; i = m_hyps[i].prev) {
+            path.push_back(&m_hyps[i]);
+        }
+
+        auto ret = Buffer();
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            ret.Append(BufferElement(Element(**it)));
+        }
+
+        return ret;
+    }
+
+    Engine* m_engine = nullptr;
+    SentenceSearchLimits m_limits;
+    Trie const* m_trie = nullptr;
+    std::optional<TaiToken> m_lgram;
+    std::string m_text;
+    // One more than the letters of |m_text|
+    std::vector<Position> m_positions;
+    // Positions whose word may still continue at the end
+    std::vector<size_t> m_open;
+    std::vector<Hypothesis> m_hyps;
+};
+
 Punctuation OnePunctuation(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query) {
@@ -215,15 +709,15 @@ Punctuation OnePunctuation(
     return Punctuation{0, query, query, std::string()};
 }
 
-std::vector<Buffer> AllPunctuation(
+std::vector<Candidate> AllPunctuation(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query) {
-    auto ret = std::vector<Buffer>();
+    auto ret = std::vector<Candidate>();
     auto options = engine->dictionary()->SearchPunctuation(query);
     for (auto& p : options) {
         auto elem =
             BufferElement::Builder().WithPunctuation(p).SetConverted().Build();
-        ret.push_back(Buffer(std::move(elem)));
+        ret.emplace_back(Buffer(std::move(elem)));
     }
     return ret;
 }
@@ -231,32 +725,53 @@ std::vector<Buffer> AllPunctuation(
 Buffer OneSplittable(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string_view query) {
+    auto* cache = engine->candidate_cache();
+    auto lgram_str = OutputOf(lgram);
+    auto query_str = std::string(query);
+    auto cached = std::vector<Candidate>();
+    if (cache != nullptr &&
+        cache->Find(CachedMatch::OneSplittable, lgram_str, query_str, cached)) {
+        return cached.empty() ? Buffer()
+                              : cached[0].Get(engine->syllable_parser());
+    }
+
     auto segmentations = engine->dictionary()->Segment(query, 1);
+    auto ret = Buffer();
+    auto grams = std::vector<std::string>();
 
-    if (segmentations.empty()) {
-        return Buffer();
+    if (!segmentations.empty()) {
+        ret = WordsToBuffer(engine, lgram, segmentations[0], &grams);
     }
 
-    return WordsToBuffer(engine, segmentations[0]);
+    if (cache != nullptr) {
+        cache->Insert(CachedMatch::OneSplittable, lgram_str, query_str,
+                      std::vector<Candidate>{Candidate(ret)},
+                      std::move(grams));
+    }
+
+    return ret;
 }
 
-std::vector<Buffer> AllSplittables(
+std::vector<Candidate> AllSplittables(
     Engine* engine, std::optional<TaiToken> const& lgram,
-    std::string const& query) {
-    // auto all_cands = std::vector<Buffer>();
-    auto segmentations =
-        engine->dictionary()->Segment(query, kNumberOfContinuousCandidates);
-    auto seen = std::unordered_set<std::string>();
-    auto ret = std::vector<Buffer>();
+    std::string const& query, SentenceBeam& beam) {
+    beam.Seek(lgram, query);
+    auto ret = std::vector<Candidate>();
+    auto seen = std::pmr::unordered_set<std::string>(Scratch(engine));
+    for (auto& buf : beam.Search()) {
+        seen.insert(buf.Text());
+        ret.emplace_back(std::move(buf));
+    }
 
-    for (auto& segmentation : segmentations) {
-        auto buf = WordsToBuffer(engine, segmentation);
-        if (seen.insert(buf.Text()).second) {
-            ret.push_back(std::move(buf));
-        }
+    if (ret.empty()) {
+        auto buf = OneSplittable(engine, lgram, query);
+        seen.insert(buf.Text());
+        ret.emplace_back(std::move(buf));
     }
 
-    auto additionals = CandidateFinder::MultiMatch(engine, lgram, query);
+    // The query is known to be splittable, which is all MultiMatch would
+    // find out by segmenting it again
+    auto additionals = AllWordsFromStart(engine, lgram, query);
     for (auto& addl : additionals) {
         if (seen.insert(addl.Text()).second) {
             ret.push_back(std::move(addl));
@@ -277,8 +792,8 @@ Buffer OneUserItem(
             if (options.size() > 1) {
                 options.erase(options.begin() + 1);
             }
-            auto ret = TokensToBuffers(engine, options, query);
-            return ret[0];
+            auto ret = TokensToCandidates(options, query);
+            return ret[0].Get(engine->syllable_parser());
         }
     }
 
@@ -286,7 +801,7 @@ Buffer OneUserItem(
     return Buffer(std::move(elem));
 }
 
-std::vector<Buffer> AllUserItems(
+std::vector<Candidate> AllUserItems(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query) {
     auto* userdict = engine->user_dict();
@@ -294,13 +809,186 @@ std::vector<Buffer> AllUserItems(
         auto options = userdict->Search(query);
         if (!options.empty()) {
             DedupeAndSortTokenResultSet(engine, lgram, query, options);
-            return TokensToBuffers(engine, options, query);
+            return TokensToCandidates(options, query);
         }
     }
 
-    return std::vector<Buffer>();
+    return std::vector<Candidate>();
 }
 
+// Conversion of one segment of a continuous mode composition: either the
+// whole candidate list, if it is the first segment, or one buffer that is
+// appended to the first candidate
+struct SegmentMatch {
+    SegmentType type = SegmentType::None;
+    std::string raw;
+    std::optional<std::string> lgram;
+    bool replaces_candidates = false;
+    std::vector<Candidate> candidates;
+};
+
+class ContinuousMatcherImpl : public ContinuousMatcher {
+   public:
+    ContinuousMatcherImpl(Engine* engine, SentenceSearchLimits const& limits)
+        : m_engine(engine), m_limits(limits), m_beam(engine, limits) {}
+
+    std::vector<Candidate> MultiMatch(std::optional<TaiToken> const& lgram,
+                                      std::string const& query) override {
+        return MultiMatch(lgram, query, nullptr).value();
+    }
+
+    std::optional<std::vector<Candidate>> MultiMatch(
+        std::optional<TaiToken> const& lgram, std::string const& query,
+        std::function<bool()> const& interrupted) override {
+        auto const* trie = m_engine->dictionary()->word_trie();
+        auto generation = ResultsGeneration();
+        if (trie != m_trie || generation != m_generation) {
+            Clear();
+            m_trie = trie;
+            m_generation = generation;
+        }
+
+        auto* parser = m_engine->syllable_parser();
+        auto candidates = std::vector<Candidate>{Candidate(Buffer())};
+        auto segments = Segmenter::SegmentText(m_engine, query);
+        auto matches = std::vector<SegmentMatch>();
+        matches.reserve(segments.size());
+
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (interrupted && interrupted()) {
+                m_matches = std::move(matches);
+                return std::nullopt;
+            }
+
+            auto& seg = segments[i];
+            auto segment_raw = query.substr(seg.start, seg.size);
+            auto& first = candidates.at(0).Get(parser);
+            auto const& lgram_ =
+                first.Empty() ? lgram : first.Back().candidate();
+
+            auto match = SegmentMatch{seg.type, std::move(segment_raw),
+                                      OutputOf(lgram_), false, {}};
+            if (i < m_matches.size() && m_matches[i].type == match.type &&
+                m_matches[i].raw == match.raw &&
+                m_matches[i].lgram == match.lgram) {
+                match = std::move(m_matches[i]);
+            } else if (!Match(i == 0, lgram_, match, interrupted)) {
+                m_matches = std::move(matches);
+                return std::nullopt;
+            }
+
+            if (match.replaces_candidates) {
+                candidates = match.candidates;
+            } else {
+                candidates[0].Get(parser).Append(
+                    match.candidates[0].Get(parser));
+            }
+            matches.push_back(std::move(match));
+        }
+
+        m_matches = std::move(matches);
+        candidates.at(0).Get(parser).SetConverted(true);
+        return candidates;
+    }
+
+    void Clear() override {
+        m_matches.clear();
+        m_beam.Clear();
+    }
+
+    SentenceSearchLimits const& limits() const override {
+        return m_limits;
+    }
+
+   private:
+    // The candidate cache is told about everything that changes results:
+    // the user dictionary, the config (and with it the keys) and the
+    // n-gram counts
+    uint64_t ResultsGeneration() const {
+        auto* cache = m_engine->candidate_cache();
+        return cache != nullptr ? cache->generation() : 0;
+    }
+
+    // Returns false if the sentence search was interrupted
+    bool Match(bool first, std::optional<TaiToken> const& lgram,
+               SegmentMatch& match,
+               std::function<bool()> const& interrupted) {
+        auto const& raw = match.raw;
+        auto* parser = m_engine->syllable_parser();
+        auto& buffers = match.candidates;
+        match.replaces_candidates =
+            first && (match.type == SegmentType::Splittable ||
+                      match.type == SegmentType::Punct ||
+                      match.type == SegmentType::UserItem);
+
+        switch (match.type) {
+            case SegmentType::Splittable:
+                if (first) {
+                    if (!m_beam.Seek(lgram, raw, interrupted)) {
+                        return false;
+                    }
+                    buffers = AllSplittables(m_engine, lgram, raw, m_beam);
+                } else {
+                    buffers.emplace_back(OneSplittable(m_engine, lgram, raw));
+                }
+                break;
+            case SegmentType::Punct:
+                if (first) {
+                    buffers = AllPunctuation(m_engine, lgram, raw);
+                } else {
+                    buffers.emplace_back(
+                        Buffer(BufferElement::Builder()
+                                   .WithPunctuation(
+                                       OnePunctuation(m_engine, lgram, raw))
+                                   .Build()));
+                }
+                break;
+            case SegmentType::UserItem:
+                if (first) {
+                    buffers = AllUserItems(m_engine, lgram, raw);
+                } else {
+                    buffers.emplace_back(OneUserItem(m_engine, lgram, raw));
+                }
+                break;
+            case SegmentType::SyllablePrefix:
+                buffers.emplace_back(Buffer(
+                    BufferElement::Builder().Parser(parser).FromInput(raw).Build()));
+                break;
+            case SegmentType::WordPrefix: {
+                auto best_match =
+                    BestAutocomplete(m_engine, std::nullopt, raw);
+                auto builder =
+                    BufferElement::Builder().Parser(parser).FromInput(raw);
+                if (best_match) {
+                    builder.WithTaiToken(best_match.value());
+                }
+                buffers.emplace_back(Buffer(builder.Build()));
+                break;
+            }
+            case SegmentType::Hyphens:
+                buffers.emplace_back(Buffer(BufferElement::Builder()
+                                             .FromInput(std::string(raw.size(), '-'))
+                                             .Build()));
+                break;
+            case SegmentType::None:
+                buffers.emplace_back(
+                    Buffer(BufferElement::Builder().FromInput(raw).Build()));
+                break;
+        }
+
+        return true;
+    }
+
+    Engine* m_engine = nullptr;
+    SentenceSearchLimits m_limits;
+    Trie const* m_trie = nullptr;
+    // CandidateCache::generation when |m_matches| were found
+    uint64_t m_generation = 0;
+    SentenceBeam m_beam;
+    // Matches of the segments of the last query, in order
+    std::vector<SegmentMatch> m_matches;
+};
+
 // void AddUserItems(Engine *engine, TaiToken *lgram, std::string const &query,
 // std::vector<Buffer> &candidates) {
 //    auto items = AllUserItems(engine, lgram, query);
@@ -309,17 +997,45 @@ std::vector<Buffer> AllUserItems(
 //    }
 //}
 
+// Every option that could be ranked is in the result, since only options
+// with the same output as a kept one are left out
+std::vector<Candidate> CachedWordsFromStart(
+    Engine* engine, std::optional<TaiToken> const& lgram,
+    std::string const& query) {
+    auto* cache = engine->candidate_cache();
+    auto lgram_str = OutputOf(lgram);
+    auto ret = std::vector<Candidate>();
+    if (cache != nullptr &&
+        cache->Find(CachedMatch::MultiMatch, lgram_str, query, ret)) {
+        return ret;
+    }
+
+    ret = AllWordsFromStart(engine, lgram, query);
+
+    if (cache != nullptr) {
+        auto grams = std::vector<std::string>();
+        grams.reserve(ret.size());
+        for (auto const& cand : ret) {
+            grams.emplace_back(cand.token()->output);
+        }
+        cache->Insert(CachedMatch::MultiMatch, lgram_str, query, ret,
+                      std::move(grams));
+    }
+
+    return ret;
+}
+
 }  // namespace
 
-std::vector<Buffer> BufferListOf(BufferElement&& elem) {
-    return std::vector<Buffer>{Buffer(std::move(elem))};
+std::vector<Candidate> BufferListOf(BufferElement&& elem) {
+    return std::vector<Candidate>{Candidate(Buffer(std::move(elem)))};
 }
 
-std::vector<Buffer> CandidateFinder::MultiMatch(
+std::vector<Candidate> CandidateFinder::MultiMatch(
     Engine* engine, std::optional<TaiToken> const& lgram,
     std::string const& query) {
     if (query.empty()) {
-        return std::vector<Buffer>();
+        return std::vector<Candidate>();
     }
 
     auto invalid_split_indices = InvalidSplitIndices(engine, query);
@@ -330,7 +1046,7 @@ std::vector<Buffer> CandidateFinder::MultiMatch(
         case SegmentType::Punct:
             return AllPunctuation(engine, lgram, query);
         case SegmentType::Splittable:
-            return AllWordsFromStart(engine, lgram, query);
+            return CachedWordsFromStart(engine, lgram, query);
         case SegmentType::UserItem:
             return AllUserItems(engine, lgram, query);
         case SegmentType::SyllablePrefix:
@@ -407,85 +1123,15 @@ Buffer CandidateFinder::ContinuousSingleMatch(
     return ret;
 }
 
-std::vector<Buffer> CandidateFinder::ContinuousMultiMatch(
+std::vector<Candidate> CandidateFinder::ContinuousMultiMatch(
     Engine* engine, std::optional<TaiToken> const& lgram,
-    std::string const& query) {
-    auto candidates = std::vector<Buffer>{Buffer()};
-    auto segments = Segmenter::SegmentText(engine, query);
-    auto* parser = engine->syllable_parser();
-
-    for (size_t i = 0; i < segments.size(); ++i) {
-        auto& seg = segments[i];
-        auto segment_raw = query.substr(seg.start, seg.size);
-        auto const& lgram_ = candidates.at(0).Empty()
-                                 ? lgram
-                                 : candidates.at(0).Back().candidate();
-
-        switch (seg.type) {
-            case SegmentType::Splittable:
-                if (i == 0) {
-                    candidates = AllSplittables(engine, lgram_, segment_raw);
-                } else {
-                    candidates[0].Append(
-                        OneSplittable(engine, lgram_, segment_raw));
-                }
-                break;
-            case SegmentType::Punct:
-                if (i == 0) {
-                    candidates = AllPunctuation(engine, lgram_, segment_raw);
-                } else {
-                    candidates[0].Append(BufferElement::Builder()
-                                             .WithPunctuation(OnePunctuation(
-                                                 engine, lgram_, segment_raw))
-                                             .Build());
-                }
-                break;
-            case SegmentType::UserItem:
-                if (i == 0) {
-                    candidates = AllUserItems(engine, lgram_, segment_raw);
-                } else {
-                    candidates[0].Append(
-                        OneUserItem(engine, lgram_, segment_raw));
-                }
-                break;
-            case SegmentType::SyllablePrefix:
-                candidates[0].Append(BufferElement::Builder()
-                                         .Parser(parser)
-                                         .FromInput(segment_raw)
-                                         .Build());
-                break;
-            case SegmentType::WordPrefix: {
-                auto best_match =
-                    BestAutocomplete(engine, std::nullopt, segment_raw);
-                if (best_match) {
-                    candidates[0].Append(BufferElement::Builder()
-                                             .Parser(parser)
-                                             .FromInput(segment_raw)
-                                             .WithTaiToken(best_match.value())
-                                             .Build());
-                } else {
-                    candidates[0].Append(BufferElement::Builder()
-                                             .Parser(parser)
-                                             .FromInput(segment_raw)
-                                             .Build());
-                }
-                break;
-            }
-            case SegmentType::Hyphens:
-                candidates[0].Append(BufferElement::Builder()
-                                         .FromInput(std::string(seg.size, '-'))
-                                         .Build());
-                break;
-            case SegmentType::None:
-                candidates[0].Append(
-                    BufferElement::Builder().FromInput(segment_raw).Build());
-                break;
-        }
-    }
-
-    candidates.at(0).SetConverted(true);
+    std::string const& query, SentenceSearchLimits const& limits) {
+    return ContinuousMatcher::Create(engine, limits)->MultiMatch(lgram, query);
+}
 
-    return candidates;
+std::unique_ptr<ContinuousMatcher> ContinuousMatcher::Create(
+    Engine* engine, SentenceSearchLimits const& limits) {
+    return std::make_unique<ContinuousMatcherImpl>(engine, limits);
 }
 
 bool CandidateFinder::HasExactMatch(Engine* engine, std::string_view query) {
@@ -1,19 +1,43 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "Buffer.h"
+#include "Candidate.h"
 #include "data/Models.h"
 
 namespace khiin::engine {
 
 class Engine;
 
+// Bounds the whole-sentence search that ranks the continuous mode
+// candidates: at most |beam_width| partial sentences are kept at each
+// position of the input, and at most |beam_width| conversions of each word
+// are tried, so the work grows linearly with the input length. Set from
+// the AppConfig by BufferMgr.
+struct SentenceSearchLimits {
+    size_t beam_width = 8;
+    size_t max_results = 5;
+
+    friend bool operator==(SentenceSearchLimits const& lhs,
+                           SentenceSearchLimits const& rhs) {
+        return lhs.beam_width == rhs.beam_width &&
+               lhs.max_results == rhs.max_results;
+    }
+
+    friend bool operator!=(SentenceSearchLimits const& lhs,
+                           SentenceSearchLimits const& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
 class CandidateFinder {
    public:
-    static std::vector<Buffer> MultiMatch(
+    static std::vector<Candidate> MultiMatch(
         Engine* engine,
         std::optional<TaiToken> const& lgram,
         std::string const& query);
@@ -23,12 +47,50 @@ class CandidateFinder {
         std::optional<TaiToken> const& lgram,
         std::string const& query);
 
-    static std::vector<Buffer> ContinuousMultiMatch(
+    static std::vector<Candidate> ContinuousMultiMatch(
         Engine* engine,
         std::optional<TaiToken> const& lgram,
-        std::string const& query);
+        std::string const& query,
+        SentenceSearchLimits const& limits = SentenceSearchLimits());
 
     static bool HasExactMatch(Engine* engine, std::string_view query);
 };
 
+// Same as CandidateFinder::ContinuousMultiMatch, for a composition that
+// changes a few keys at a time. The conversion of each segment is kept
+// and reused by the next match if the segment and the conversion before
+// it did not change, and the sentence search of the first segment resumes
+// from the first key that changed. Everything kept is dropped when the
+// engine's CandidateCache generation changes.
+class ContinuousMatcher {
+   public:
+    ContinuousMatcher() = default;
+    ContinuousMatcher(ContinuousMatcher const&) = delete;
+    ContinuousMatcher& operator=(ContinuousMatcher const&) = delete;
+    virtual ~ContinuousMatcher() = default;
+
+    static std::unique_ptr<ContinuousMatcher> Create(
+        Engine* engine,
+        SentenceSearchLimits const& limits = SentenceSearchLimits());
+
+    virtual std::vector<Candidate> MultiMatch(
+        std::optional<TaiToken> const& lgram,
+        std::string const& query) = 0;
+
+    // Same as above, but gives up and returns nothing once |interrupted|
+    // returns true, which is asked before each segment and before each
+    // letter of the sentence search. What was found before giving up is
+    // kept for the next match.
+    virtual std::optional<std::vector<Candidate>> MultiMatch(
+        std::optional<TaiToken> const& lgram,
+        std::string const& query,
+        std::function<bool()> const& interrupted) = 0;
+
+    // Forgets everything kept from earlier matches, e.g. after the
+    // n-gram counts have changed
+    virtual void Clear() = 0;
+
+    virtual SentenceSearchLimits const& limits() const = 0;
+};
+
 }  // namespace khiin::engine
@@ -0,0 +1,194 @@
+#include "CandidatePrefetcher.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "config/Config.h"
+
+namespace khiin::engine {
+namespace {
+
+// Separates the parts of a key, and never appears in raw input
+constexpr char kKeySeparator = '\x1f';
+
+// CPU time used so far by the calling thread
+std::chrono::nanoseconds ThreadCpuTime() {
+#ifdef _WIN32
+    FILETIME creation;
+    FILETIME exit;
+    FILETIME kernel;
+    FILETIME user;
+    ::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user);
+    auto ticks = [](FILETIME const &time) {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    // In units of 100 ns
+    return std::chrono::nanoseconds((ticks(kernel) + ticks(user)) * 100);
+#else
+    auto now = timespec();
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+#endif
+}
+
+} // namespace
+
+CandidatePrefetcher::CandidatePrefetcher(StepFn step, std::chrono::milliseconds budget, size_t max_keys)
+    : m_step(std::move(step)), m_max_keys(max_keys), m_budget(budget) {
+    m_thread = std::thread(&CandidatePrefetcher::Run, this);
+}
+
+CandidatePrefetcher::~CandidatePrefetcher() {
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+std::string CandidatePrefetcher::Key(InputMode mode, std::optional<std::string> const &lgram,
+                                     std::string const &query) {
+    auto ret = std::string(1, static_cast<char>('0' + static_cast<int>(mode)));
+    if (lgram) {
+        ret.push_back('+');
+        ret.append(lgram.value());
+    }
+    ret.push_back(kKeySeparator);
+    ret.append(query);
+    return ret;
+}
+
+void CandidatePrefetcher::Schedule() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    ++m_generation;
+    m_scheduled = true;
+    m_wake.notify_one();
+}
+
+void CandidatePrefetcher::Cancel() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    ++m_generation;
+    m_scheduled = false;
+}
+
+void CandidatePrefetcher::Wait() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_idle.wait(lock, [this] {
+        return !m_scheduled && !m_running;
+    });
+}
+
+void CandidatePrefetcher::set_budget(std::chrono::milliseconds budget) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_budget = budget;
+}
+
+size_t CandidatePrefetcher::max_keys() const {
+    return m_max_keys;
+}
+
+bool CandidatePrefetcher::Contains(std::string const &key) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    return m_results.find(key) != m_results.end();
+}
+
+void CandidatePrefetcher::Insert(std::string key, std::vector<Candidate> result) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    if (m_results.size() >= m_max_keys) {
+        return;
+    }
+
+    m_results.insert_or_assign(std::move(key), std::move(result));
+    ++m_prefetched;
+}
+
+bool CandidatePrefetcher::Take(std::string const &key, std::vector<Candidate> &output) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    auto found = false;
+
+    if (auto it = m_results.find(key); it != m_results.end()) {
+        output = std::move(it->second);
+        m_results.erase(it);
+        ++m_used;
+        found = true;
+    }
+
+    ClearResults();
+    return found;
+}
+
+void CandidatePrefetcher::Clear() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    ClearResults();
+}
+
+size_t CandidatePrefetcher::prefetched() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    return m_prefetched;
+}
+
+size_t CandidatePrefetcher::used() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    return m_used;
+}
+
+size_t CandidatePrefetcher::wasted() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    return m_wasted;
+}
+
+void CandidatePrefetcher::Run() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+
+    while (true) {
+        m_wake.wait(lock, [this] {
+            return m_stopping || m_scheduled;
+        });
+
+        if (m_stopping) {
+            return;
+        }
+
+        m_scheduled = false;
+        m_running = true;
+        auto generation = m_generation;
+        auto budget = m_budget;
+        auto start = ThreadCpuTime();
+
+        // Called by the step without |m_mutex|
+        auto stop = [&] {
+            if (ThreadCpuTime() - start >= budget) {
+                return true;
+            }
+            auto step_lock = std::unique_lock<std::mutex>(m_mutex);
+            return m_stopping || generation != m_generation;
+        };
+
+        while (!m_stopping && generation == m_generation && ThreadCpuTime() - start < budget) {
+            lock.unlock();
+            auto more = m_step(stop);
+            lock.lock();
+
+            if (!more) {
+                break;
+            }
+        }
+
+        m_running = false;
+        m_idle.notify_all();
+    }
+}
+
+// Requires |m_mutex|
+void CandidatePrefetcher::ClearResults() {
+    m_wasted += m_results.size();
+    m_results.clear();
+}
+
+} // namespace khiin::engine
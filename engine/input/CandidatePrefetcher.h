@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Candidate.h"
+
+namespace khiin::engine {
+
+enum class InputMode;
+
+// Computes the candidates for the most likely next keys while the engine is
+// idle, so that the next Insert can use them right away.
+//
+// Prefetching runs on its own thread, one key per call to |step|, starting
+// when Schedule is called and stopping when there is nothing left to
+// prefetch, when |budget| has been spent on it, or when Cancel is called.
+// The budget is CPU time of the prefetch thread, so waiting for the engine
+// does not use it up, and a step is asked to give up part way once the
+// budget is spent or prefetching is cancelled.
+// Results are keyed by the input mode, the output of the left context and
+// the raw composition after the key, and at most |max_keys| are kept.
+class CandidatePrefetcher {
+  public:
+    static constexpr size_t kDefaultMaxKeys = 8;
+
+    // Returns true once a step should give up
+    using StopFn = std::function<bool()>;
+
+    // Called on the prefetch thread. Prefetches one more key, giving up
+    // without a result when |stop| returns true, and returns false if there
+    // is no key left or it gave up.
+    using StepFn = std::function<bool(StopFn const &stop)>;
+
+    CandidatePrefetcher(StepFn step, std::chrono::milliseconds budget, size_t max_keys = kDefaultMaxKeys);
+    CandidatePrefetcher(CandidatePrefetcher const &) = delete;
+    CandidatePrefetcher &operator=(CandidatePrefetcher const &) = delete;
+    ~CandidatePrefetcher();
+
+    static std::string Key(InputMode mode, std::optional<std::string> const &lgram, std::string const &query);
+
+    // Starts prefetching for the current state of the engine
+    void Schedule();
+
+    // Stops prefetching. A key that is being prefetched is given up at the
+    // next point where its step checks whether to stop.
+    void Cancel();
+
+    // Blocks until prefetching has stopped
+    void Wait();
+
+    void set_budget(std::chrono::milliseconds budget);
+    size_t max_keys() const;
+
+    bool Contains(std::string const &key);
+    void Insert(std::string key, std::vector<Candidate> result);
+
+    // Moves the result for |key| into |output| and returns true if it was
+    // prefetched. Results for the other keys are dropped either way.
+    bool Take(std::string const &key, std::vector<Candidate> &output);
+
+    void Clear();
+
+    // Number of results computed, taken by Take, and dropped unused
+    size_t prefetched();
+    size_t used();
+    size_t wasted();
+
+  private:
+    void Run();
+    void ClearResults();
+
+    StepFn m_step;
+    size_t m_max_keys = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::chrono::milliseconds m_budget;
+    std::unordered_map<std::string, std::vector<Candidate>> m_results;
+    size_t m_prefetched = 0;
+    size_t m_used = 0;
+    size_t m_wasted = 0;
+    // Incremented by Schedule and Cancel, so that a running pass can tell
+    // that it is out of date
+    uint64_t m_generation = 0;
+    bool m_scheduled = false;
+    bool m_running = false;
+    bool m_stopping = false;
+
+    std::thread m_thread;
+};
+
+} // namespace khiin::engine
@@ -0,0 +1,196 @@
+#include "KeyEventWorker.h"
+
+#include <algorithm>
+#include <string>
+
+#include "utils/unicode.h"
+
+namespace khiin::engine {
+namespace {
+namespace u8u = utf8::unchecked;
+using namespace khiin::unicode;
+
+void AddSegment(proto::Preedit *preedit, proto::SegmentStatus status, std::string value) {
+    auto *segment = preedit->add_segments();
+    segment->set_status(status);
+    segment->set_value(std::move(value));
+}
+
+// Copies |base| into |output| with |text| inserted at the caret as a
+// composing segment, splitting the segment that the caret is in
+void InsertAtCaret(proto::Preedit const &base, std::string const &text, proto::Preedit *output) {
+    auto caret = static_cast<utf8_size_t>(base.caret());
+    utf8_size_t start = 0;
+    auto inserted = false;
+
+    for (auto const &segment : base.segments()) {
+        auto const &value = segment.value();
+        auto size = u8_size(value);
+
+        if (inserted || caret > start + size) {
+            AddSegment(output, segment.status(), value);
+            start += size;
+            continue;
+        }
+
+        auto split = value.begin();
+        u8u::advance(split, caret - start);
+        if (split != value.begin()) {
+            AddSegment(output, segment.status(), std::string(value.begin(), split));
+        }
+        AddSegment(output, proto::SS_COMPOSING, text);
+        if (split != value.end()) {
+            AddSegment(output, segment.status(), std::string(split, value.end()));
+        }
+
+        inserted = true;
+        start += size;
+    }
+
+    if (!inserted) {
+        AddSegment(output, proto::SS_COMPOSING, text);
+    }
+
+    output->set_caret(static_cast<int32_t>((std::min)(caret, start) + u8_size(text)));
+    output->set_focused_caret(base.focused_caret());
+}
+
+} // namespace
+
+KeyEventWorker::KeyEventWorker(ApplyFn apply, CollectFn collect)
+    : m_apply(std::move(apply)), m_collect(std::move(collect)) {
+    m_thread = std::thread(&KeyEventWorker::Run, this);
+}
+
+KeyEventWorker::~KeyEventWorker() {
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void KeyEventWorker::Post(proto::Request const &request, proto::Response *response) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    auto seq = m_next_seq++;
+    auto ch = static_cast<char>(request.key_event().key_code());
+    m_queue.emplace_back(seq, ch);
+    m_unsettled.emplace_back(seq, ch);
+    Provisional(response);
+    m_wake.notify_one();
+}
+
+void KeyEventWorker::GetResult(proto::Response *response) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    if (m_unsettled.empty()) {
+        response->CopyFrom(m_result);
+    } else {
+        Provisional(response);
+    }
+}
+
+void KeyEventWorker::SetResult(proto::Response const &response) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_result.CopyFrom(response);
+    m_unsettled.clear();
+}
+
+void KeyEventWorker::Wait() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_idle.wait(lock, [this] {
+        return m_queue.empty() && !m_applying;
+    });
+}
+
+bool KeyEventWorker::busy() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    return !m_queue.empty() || m_applying;
+}
+
+void KeyEventWorker::SetReadyCallback(std::function<void()> callback) {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    m_ready_callback = std::move(callback);
+}
+
+void KeyEventWorker::Run() {
+    auto lock = std::unique_lock<std::mutex>(m_mutex);
+    // Keys whose insertion was interrupted, to be inserted again
+    auto keys = std::string();
+    uint64_t seq = 0;
+
+    // Called by |m_apply| without |m_mutex|
+    auto superseded = [this] {
+        auto apply_lock = std::unique_lock<std::mutex>(m_mutex);
+        return m_stopping || !m_queue.empty();
+    };
+
+    while (true) {
+        m_wake.wait(lock, [&] {
+            return m_stopping || !m_queue.empty() || !keys.empty();
+        });
+
+        if (m_stopping) {
+            return;
+        }
+
+        // Every key waiting so far goes into one insertion, so the search
+        // for a composition that a newer key already extends is skipped
+        for (auto const &[key_seq, ch] : m_queue) {
+            keys.push_back(ch);
+            seq = key_seq;
+        }
+        m_queue.clear();
+        m_applying = true;
+        lock.unlock();
+        auto applied = m_apply(keys, superseded);
+        lock.lock();
+
+        if (!applied) {
+            continue;
+        }
+        keys.clear();
+
+        // Keys posted during the search replace its result before it is built
+        if (!m_queue.empty()) {
+            continue;
+        }
+
+        lock.unlock();
+        auto result = proto::Response();
+        m_collect(&result);
+        lock.lock();
+
+        m_result = std::move(result);
+        while (!m_unsettled.empty() && m_unsettled.front().first <= seq) {
+            m_unsettled.pop_front();
+        }
+
+        m_applying = false;
+        m_idle.notify_all();
+
+        // Only the result of the last key posted is reported
+        if (m_unsettled.empty() && m_ready_callback) {
+            auto callback = m_ready_callback;
+            lock.unlock();
+            callback();
+            lock.lock();
+        }
+    }
+}
+
+// Requires |m_mutex|
+void KeyEventWorker::Provisional(proto::Response *response) const {
+    auto text = std::string();
+    for (auto const &[seq, ch] : m_unsettled) {
+        text.push_back(ch);
+    }
+
+    auto *preedit = response->mutable_preedit();
+    preedit->Clear();
+    InsertAtCaret(m_result.preedit(), text, preedit);
+    response->set_edit_state(proto::ES_COMPOSING);
+    response->set_candidates_pending(true);
+}
+
+} // namespace khiin::engine
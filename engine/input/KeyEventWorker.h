@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "proto/proto.h"
+
+namespace khiin::engine {
+
+// Applies key events on a worker thread, so that the host's key handler
+// does not wait for segmentation and candidate search.
+//
+// Each posted key gets a provisional response right away: the preedit of
+// the last complete result with the characters typed since then inserted
+// at its caret. A key posted while a search is running interrupts it, and
+// the keys of the abandoned search are applied again together with every
+// key that queued up meanwhile, in a single search. The complete response
+// is only collected once no newer key is waiting, so neither the search
+// nor the result for a superseded key is ever finished.
+class KeyEventWorker {
+  public:
+    // Returns true once a newer key is waiting
+    using SupersededFn = std::function<bool()>;
+
+    // Both are called on the worker thread. |apply| inserts the characters
+    // of every key event waiting in the queue, in the order they were
+    // posted. It may give up once |superseded| returns true, leaving the
+    // state as it was, and returns false if it did. |collect| fills a
+    // response with the current preedit, candidate list and edit state.
+    using ApplyFn = std::function<bool(std::string const &keys, SupersededFn const &superseded)>;
+    using CollectFn = std::function<void(proto::Response *)>;
+
+    KeyEventWorker(ApplyFn apply, CollectFn collect);
+    KeyEventWorker(KeyEventWorker const &) = delete;
+    KeyEventWorker &operator=(KeyEventWorker const &) = delete;
+    ~KeyEventWorker();
+
+    // Queues a key that inserts the printable |key_code| of |request|, and
+    // fills |response| with a provisional preedit
+    void Post(proto::Request const &request, proto::Response *response);
+
+    // Fills |response| with the latest complete result, or with a
+    // provisional preedit while posted keys are still being applied
+    void GetResult(proto::Response *response);
+
+    // Replaces the latest result, after a command that was handled without
+    // the worker. Only call when the worker is not busy.
+    void SetResult(proto::Response const &response);
+
+    // Blocks until every posted key has been applied
+    void Wait();
+
+    // True while a posted key has not been applied
+    bool busy();
+
+    // Called on the worker thread whenever a complete result is ready
+    void SetReadyCallback(std::function<void()> callback);
+
+  private:
+    void Run();
+    void Provisional(proto::Response *response) const;
+
+    ApplyFn m_apply;
+    CollectFn m_collect;
+    std::function<void()> m_ready_callback;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<std::pair<uint64_t, char>> m_queue;
+    // Characters posted after the key that |m_result| was collected for
+    std::deque<std::pair<uint64_t, char>> m_unsettled;
+    proto::Response m_result;
+    uint64_t m_next_seq = 1;
+    bool m_applying = false;
+    bool m_stopping = false;
+
+    std::thread m_thread;
+};
+
+} // namespace khiin::engine
@@ -0,0 +1,127 @@
+#include "LomajiTable.h"
+
+#include <cctype>
+
+#include "utils/unicode.h"
+
+namespace khiin::engine {
+namespace {
+
+const std::string kKhinDotStr = u8"·";
+const std::string kKhinHyphenStr = "--";
+
+// Tones that have a diacritic, each of which gets its own composed form
+constexpr std::array<Tone, 6> kToneDiacritics = {Tone::T2, Tone::T3, Tone::T5, Tone::T7, Tone::T8, Tone::T9};
+
+std::string Capitalize(std::string str) {
+    if (!str.empty()) {
+        str[0] = static_cast<char>(toupper(static_cast<unsigned char>(str[0])));
+    }
+    return str;
+}
+
+size_t KhinPrefixSize(std::string const &syllable) {
+    for (auto const *prefix : {&kKhinDotStr, &kKhinHyphenStr}) {
+        if (syllable.size() > prefix->size() && syllable.compare(0, prefix->size(), *prefix) == 0) {
+            return prefix->size();
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+LomajiTable::LomajiTable(std::vector<std::string> const &syllables) {
+    m_composed.reserve(syllables.size() * 2);
+    m_decomposed.reserve(syllables.size() * 2 * (kToneDiacritics.size() + 1));
+
+    for (auto const &syllable : syllables) {
+        Add(syllable);
+        Add(Capitalize(syllable));
+    }
+}
+
+void LomajiTable::Add(std::string const &body) {
+    if (body.empty() || m_composed.count(body) != 0) {
+        return;
+    }
+
+    // Canonical ordering keeps the other marks in place, so taking the tone
+    // mark back out leaves the same decomposed body for every tone
+    auto &row = m_composed[InternedString(body).view()];
+    auto decomposed = InternedString(Lomaji::Decompose(body));
+    auto add = [&](Tone tone) {
+        auto composed = body;
+        Lomaji::ApplyToneDiacritic(tone, composed);
+        auto interned = InternedString(unicode::to_nfc(composed));
+        row[static_cast<size_t>(tone)] = interned;
+        m_decomposed.emplace(interned.view(), Decomposed{decomposed, tone});
+    };
+
+    add(Tone::NaT);
+    for (auto tone : kToneDiacritics) {
+        add(tone);
+    }
+}
+
+void LomajiTable::ApplyToneDiacritic(Tone tone, std::string &syllable) const {
+    if (auto it = m_composed.find(syllable); it != m_composed.end()) {
+        auto index = Lomaji::NeedsToneDiacritic(tone) ? static_cast<size_t>(tone) : static_cast<size_t>(Tone::NaT);
+        if (auto composed = it->second[index]; !composed.empty()) {
+            syllable.assign(composed.view());
+            return;
+        }
+    }
+
+    Lomaji::ApplyToneDiacritic(tone, syllable);
+    syllable = unicode::to_nfc(syllable);
+}
+
+Tone LomajiTable::RemoveToneDiacritic(std::string &syllable) const {
+    auto khin_size = size_t(0);
+    auto const *found = FindDecomposed(syllable, khin_size);
+    if (found == nullptr) {
+        return Lomaji::RemoveToneDiacritic(syllable);
+    }
+
+    if (found->tone != Tone::NaT) {
+        syllable.replace(khin_size, std::string::npos, found->body.view());
+    }
+    return found->tone;
+}
+
+Tone LomajiTable::SplitTone(std::string const &syllable, std::string &body) const {
+    auto khin_size = size_t(0);
+    auto const *found = FindDecomposed(syllable, khin_size);
+    if (found == nullptr) {
+        body = Lomaji::Decompose(syllable);
+        return Lomaji::RemoveToneDiacritic(body);
+    }
+
+    body.assign(syllable, 0, khin_size);
+    body.append(found->body.view());
+    return found->tone;
+}
+
+size_t LomajiTable::size() const {
+    return m_decomposed.size();
+}
+
+// Looks up |syllable| with or without a leading khin, which the table
+// leaves out. |khin_size| is set to the size of the khin that was left out.
+LomajiTable::Decomposed const *LomajiTable::FindDecomposed(std::string const &syllable, size_t &khin_size) const {
+    khin_size = 0;
+    if (auto it = m_decomposed.find(syllable); it != m_decomposed.end()) {
+        return &it->second;
+    }
+
+    if (khin_size = KhinPrefixSize(syllable); khin_size != 0) {
+        if (auto it = m_decomposed.find(std::string_view(syllable).substr(khin_size)); it != m_decomposed.end()) {
+            return &it->second;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Lomaji.h"
+#include "data/StringPool.h"
+
+namespace khiin::engine {
+
+/**
+ * Composed forms of every syllable in the database with each tone, built once
+ * when the syllable parser is created. Composing or decomposing a syllable that
+ * is in the table is a hash probe instead of searching for the tone position
+ * and normalizing the result. Syllables are kept in lower case and capitalized,
+ * and anything not in the table falls back to Lomaji.
+ */
+class LomajiTable {
+  public:
+    LomajiTable() = default;
+    // |syllables| are toneless composed syllables, as in the syllables table
+    explicit LomajiTable(std::vector<std::string> const &syllables);
+
+    // Same as Lomaji::ApplyToneDiacritic followed by unicode::to_nfc
+    void ApplyToneDiacritic(Tone tone, std::string &syllable) const;
+
+    // Same as Lomaji::RemoveToneDiacritic: |syllable| is decomposed and its
+    // tone mark removed if it has one, and left as it is otherwise
+    Tone RemoveToneDiacritic(std::string &syllable) const;
+
+    // Sets |body| to |syllable| decomposed and without its tone mark, and
+    // returns the tone
+    Tone SplitTone(std::string const &syllable, std::string &body) const;
+
+    // Number of composed forms in the table
+    size_t size() const;
+
+  private:
+    static constexpr size_t kToneCount = static_cast<size_t>(Tone::TK) + 1;
+
+    struct Decomposed {
+        InternedString body;
+        Tone tone = Tone::NaT;
+    };
+
+    void Add(std::string const &body);
+    Decomposed const *FindDecomposed(std::string const &syllable, size_t &khin_size) const;
+
+    // Composed form of a body with each tone, or empty for a tone without
+    // a diacritic of its own. Keys are views of interned strings.
+    std::unordered_map<std::string_view, std::array<InternedString, kToneCount>> m_composed;
+    // Decomposed toneless body and tone of each composed form, without khin
+    std::unordered_map<std::string_view, Decomposed> m_decomposed;
+};
+
+} // namespace khiin::engine
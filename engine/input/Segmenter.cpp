@@ -1,111 +1,199 @@
 #include "Segmenter.h"
 
+#include <memory_resource>
+
 #include "config/KeyConfig.h"
 #include "data/Dictionary.h"
-#include "data/Splitter.h"
+#include "data/Trie.h"
 #include "data/UserDictionary.h"
+#include "utils/CommandArena.h"
 
 #include "Engine.h"
+#include "Lomaji.h"
 
 namespace khiin::engine {
 namespace {
 
-size_t CheckHyphens(Engine *engine, std::string_view str) {
-    auto hyphen_keys = engine->keyconfig()->GetHyphenKeys();
-
-    size_t n_hyphens = 0;
-    auto is_hyphen = false;
-    for (auto c : str) {
-        for (auto key : hyphen_keys) {
-            if (c == key) {
-                ++n_hyphens;
-                is_hyphen = true;
-                break;
-            } else {
-                is_hyphen = false;
-            }
-        }
-        if (!is_hyphen) {
-            break;
-        }
+struct LatticeColumn {
+    // Word edges from this position are SegmentLattice::m_edges[first_edge,
+    // next column's first_edge)
+    uint32_t first_edge = 0;
+    bool is_hyphen = false;
+    bool is_tone_key = false;
+    bool word_prefix = false;
+    bool syllable_prefix = false;
+    uint32_t max_syllable = 0;
+
+    // Folded from the right
+    uint32_t hyphens = 0;
+    bool splittable = false;
+    uint32_t max_split = 0;
+    uint32_t trailing_prefix_split = 0;
+    // Farthest end reachable by words that do not end before a tone key,
+    // counting this position itself
+    uint32_t farthest_split = 0;
+    // Farthest word prefix reachable by words, counting this position
+    // itself, or -1
+    int32_t farthest_prefix = -1;
+};
+
+/**
+ * Every span the segmenter looks for in a (lowercased) buffer, collected
+ * in a single left-to-right pass:
+ *
+ * - A word edge from |i| to |j| for each dictionary word buffer[i, j)
+ * - From each position, whether the rest of the buffer is a word prefix
+ *   or a syllable prefix, and how far the syllable trie matches
+ * - Hyphen keys and tone keys
+ *
+ * Reachability over the word edges is then folded from right to left, so
+ * that every check below is answered in constant time for any suffix of
+ * the buffer. Building the lattice is linear in the buffer size times the
+ * length of the longest word. The lattice lives in the engine's command
+ * arena.
+ */
+class SegmentLattice {
+  public:
+    SegmentLattice(Engine *engine, std::string_view buffer)
+        : m_resource(engine->command_arena()->resource()), m_size(buffer.size()), m_columns(m_resource),
+          m_edges(m_resource) {
+        m_columns.resize(m_size + 1);
+        m_edges.reserve(m_size * 2);
+        AddSpans(engine, buffer);
+        Fold();
     }
 
-    return n_hyphens;
-}
-
-bool CheckSplittable(Engine *engine, std::string_view str) {
-    return engine->dictionary()->word_splitter()->CanSplit(str);
-}
-
-bool CheckWordPrefix(Engine *engine, std::string_view str) {
-    return engine->dictionary()->IsWordPrefix(str);
-}
+    size_t Hyphens(size_t pos) const {
+        return m_columns[pos].hyphens;
+    }
 
-bool CheckSyllablePrefix(Engine *engine, std::string_view str) {
-    return engine->dictionary()->IsSyllablePrefix(str);
-}
+    // If buffer[pos:] can be split into words
+    bool Splittable(size_t pos) const {
+        return m_columns[pos].splittable;
+    }
 
-size_t CheckSplittableWithTrailingPrefix(Engine *engine, std::string_view str) {
-    auto dictionary = engine->dictionary();
-    auto splitter = dictionary->word_splitter();
-    auto start = str.begin();
-    auto end = str.end();
-
-    for (auto it = str.end(); it != start; --it) {
-        auto lhs = std::string(start, it);
-        auto rhs = std::string(it, end);
-        if (splitter->CanSplit(lhs) && dictionary->IsWordPrefix(rhs)) {
-            return lhs.size();
-        }
+    // If buffer[pos:] is a word or a word prefix
+    bool WordPrefix(size_t pos) const {
+        return m_columns[pos].word_prefix;
     }
 
-    return 0;
-}
+    // If buffer[pos:] is a syllable prefix, ignoring a trailing tone key
+    bool SyllablePrefix(size_t pos) const {
+        return m_columns[pos].syllable_prefix;
+    }
 
-size_t MaxSyllable(Engine *engine, std::string_view str) {
-    auto dictionary = engine->dictionary();
+    // Size of the longest run of words from |pos| that is followed by a word
+    // prefix up to the end of the buffer, or 0
+    size_t SplittableWithTrailingPrefix(size_t pos) const {
+        return m_columns[pos].trailing_prefix_split;
+    }
 
-    if (!dictionary->StartsWithSyllable(str)) {
-        return 0;
+    // Size of the longest run of words from |pos| that does not end right
+    // before a tone key, or 0
+    size_t MaxSplitSize(size_t pos) const {
+        return m_columns[pos].max_split;
     }
 
-    size_t i = 1;
-    auto size = str.size();
-    while (i < size + 1) {
-        if (dictionary->IsSyllablePrefix(str.substr(0, i))) {
-            ++i;
-            continue;
-        }
-        break;
+    // Size of the longest syllable prefix from |pos|, including a trailing
+    // tone key, or 0 if no syllable starts at |pos|
+    size_t MaxSyllable(size_t pos) const {
+        return m_columns[pos].max_syllable;
     }
-    return --i;
-}
 
-std::set<size_t> InvalidSplitIndices(Engine *engine, std::string_view query) {
-    auto ret = std::set<size_t>();
+  private:
+    void AddSpans(Engine *engine, std::string_view buffer) {
+        auto *keyconfig = engine->keyconfig();
+        auto hyphen_keys = keyconfig->GetHyphenKeys();
+        auto needs_tone = [&](char ch) {
+            return Lomaji::NeedsToneDiacritic(keyconfig->CheckToneKey(ch));
+        };
+
+        auto word = Trie::Cursor(engine->dictionary()->word_trie(), m_resource);
+        auto syllable = Trie::Cursor(engine->dictionary()->syllable_trie(), m_resource);
+        m_columns[m_size].word_prefix = word.IsKeyOrPrefix();
+
+        // A trailing tone key is not part of the syllable input
+        auto syllable_end = m_size != 0 && needs_tone(buffer.back()) ? m_size - 1 : m_size;
+
+        for (size_t i = 0; i < m_size; ++i) {
+            auto &col = m_columns[i];
+            col.first_edge = static_cast<uint32_t>(m_edges.size());
+            col.is_hyphen = std::find(hyphen_keys.begin(), hyphen_keys.end(), buffer[i]) != hyphen_keys.end();
+            col.is_tone_key = keyconfig->IsToneKey(buffer[i]);
+
+            word.Rewind(word.text().size());
+            auto j = i;
+            for (; j < m_size && word.Advance(buffer[j]); ++j) {
+                if (word.IsKey()) {
+                    m_edges.push_back(static_cast<uint32_t>(j + 1));
+                }
+            }
+            col.word_prefix = j == m_size && word.IsKeyOrPrefix();
+
+            syllable.Rewind(syllable.text().size());
+            auto starts_with_key = syllable.IsKey();
+            col.syllable_prefix = i == syllable_end && syllable.IsKeyOrPrefix();
+            for (j = i; j < m_size && syllable.Advance(buffer[j]); ++j) {
+                starts_with_key = starts_with_key || syllable.IsKey();
+                if (j + 1 == syllable_end) {
+                    col.syllable_prefix = syllable.IsKeyOrPrefix();
+                }
+            }
 
-    if (query.size() <= 1) {
-        return ret;
+            if (starts_with_key) {
+                col.max_syllable = static_cast<uint32_t>(j - i);
+                if (j < m_size && needs_tone(buffer[j])) {
+                    ++col.max_syllable;
+                }
+            }
+        }
+
+        m_columns[m_size].first_edge = static_cast<uint32_t>(m_edges.size());
     }
 
-    for (size_t i = 0; i < query.size() - 1; ++i) {
-        if (engine->keyconfig()->IsToneKey(query.at(i + 1))) {
-            ret.insert(i);
+    void Fold() {
+        auto &last = m_columns[m_size];
+        last.splittable = true;
+        last.farthest_split = static_cast<uint32_t>(m_size);
+        last.farthest_prefix = last.word_prefix ? static_cast<int32_t>(m_size) : -1;
+
+        for (auto i = m_size; i-- != 0;) {
+            auto &col = m_columns[i];
+            auto edges_end = m_columns[i + 1].first_edge;
+            auto split_end = uint32_t(0);
+            auto prefix_end = int32_t(-1);
+
+            col.hyphens = col.is_hyphen ? m_columns[i + 1].hyphens + 1 : 0;
+
+            for (auto e = col.first_edge; e != edges_end; ++e) {
+                auto const &to = m_columns[m_edges[e]];
+                col.splittable = col.splittable || to.splittable;
+                if (!to.is_tone_key) {
+                    split_end = std::max(split_end, to.farthest_split);
+                }
+                prefix_end = std::max(prefix_end, to.farthest_prefix);
+            }
+
+            auto pos = static_cast<uint32_t>(i);
+            col.max_split = split_end != 0 ? split_end - pos : 0;
+            col.trailing_prefix_split = prefix_end != -1 ? static_cast<uint32_t>(prefix_end) - pos : 0;
+            col.farthest_split = std::max(pos, split_end);
+            col.farthest_prefix = std::max(col.word_prefix ? static_cast<int32_t>(pos) : -1, prefix_end);
         }
     }
 
-    return ret;
-}
-
-size_t MaxSplitSize(Engine *engine, std::string_view str) {
-    auto invalid_indices = InvalidSplitIndices(engine, str);
-    return engine->dictionary()->word_splitter()->MaxSplitSize(str, invalid_indices);
-}
+    std::pmr::memory_resource *m_resource = nullptr;
+    size_t m_size = 0;
+    // One more column than the buffer size, for the end of the buffer
+    std::pmr::vector<LatticeColumn> m_columns;
+    // End positions of word edges, grouped by start position
+    std::pmr::vector<uint32_t> m_edges;
+};
 
-std::pair<size_t, SegmentType> CheckSyllableOrSplittable(Engine *engine, std::string_view str) {
+std::pair<size_t, SegmentType> CheckSyllableOrSplittable(SegmentLattice const &lattice, size_t index) {
     auto ret = std::make_pair(size_t(0), SegmentType::None);
-    auto max_syl = MaxSyllable(engine, str);
-    auto max_split = MaxSplitSize(engine, str);
+    auto max_syl = lattice.MaxSyllable(index);
+    auto max_split = lattice.MaxSplitSize(index);
 
     if (max_syl > 0 || max_split > 0) {
         if (max_syl > max_split) {
@@ -120,8 +208,16 @@ std::pair<size_t, SegmentType> CheckSyllableOrSplittable(Engine *engine, std::st
     return ret;
 }
 
+// Only the first code point decides, so the rest of |str| is not normalized
 size_t CheckAsciiPunctuation(std::string_view str) {
-    return unicode::start_glyph_type(str) == unicode::GlyphCategory::AsciiPunct ? 1 : 0;
+    if (str.empty()) {
+        return 0;
+    }
+
+    auto end = str.begin();
+    utf8::unchecked::advance(end, 1);
+    auto first = str.substr(0, std::min(static_cast<size_t>(std::distance(str.begin(), end)), str.size()));
+    return unicode::start_glyph_type(first) == unicode::GlyphCategory::AsciiPunct ? 1 : 0;
 }
 
 size_t CheckUserDictionary(Engine *engine, std::string_view query) {
@@ -142,6 +238,7 @@ bool CheckUserDictionaryExact(Engine* engine, std::string_view query) {
 
 std::vector<SegmentOffset> SegmentTextImpl(Engine *engine, std::string_view raw_buffer) {
     auto ret = std::vector<SegmentOffset>();
+    auto lattice = SegmentLattice(engine, raw_buffer);
     auto begin = raw_buffer.begin();
     auto it = raw_buffer.begin();
     auto end = raw_buffer.end();
@@ -161,7 +258,7 @@ std::vector<SegmentOffset> SegmentTextImpl(Engine *engine, std::string_view raw_
         auto index = static_cast<size_t>(std::distance(begin, it));
         auto remainder = raw_buffer.substr(index);
 
-        if (auto size = CheckHyphens(engine, remainder); size > 0) {
+        if (auto size = lattice.Hyphens(index); size > 0) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::Hyphens, index, size});
             it += size;
@@ -175,7 +272,7 @@ std::vector<SegmentOffset> SegmentTextImpl(Engine *engine, std::string_view raw_
             continue;
         }
 
-        if (CheckSplittable(engine, remainder)) {
+        if (lattice.Splittable(index)) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::Splittable, index, remainder.size()});
             break;
@@ -187,33 +284,33 @@ std::vector<SegmentOffset> SegmentTextImpl(Engine *engine, std::string_view raw_
             break;
         }
 
-        if (CheckWordPrefix(engine, remainder)) {
+        if (lattice.WordPrefix(index)) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::WordPrefix, index, remainder.size()});
             break;
         }
 
-        if (CheckSyllablePrefix(engine, remainder)) {
+        if (lattice.SyllablePrefix(index)) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::SyllablePrefix, index, remainder.size()});
             break;
         }
 
-        if (auto splits_at = CheckSplittableWithTrailingPrefix(engine, remainder); splits_at > 0) {
+        if (auto splits_at = lattice.SplittableWithTrailingPrefix(index); splits_at > 0) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::Splittable, index, splits_at});
             ret.push_back(SegmentOffset{SegmentType::WordPrefix, index + splits_at, remainder.size() - splits_at});
             break;
         }
 
-        if (auto [size, type] = CheckSyllableOrSplittable(engine, remainder); size > 0) {
+        if (auto [size, type] = CheckSyllableOrSplittable(lattice, index); size > 0) {
             flush_plaintext();
             ret.push_back(SegmentOffset{type, index, size});
             it += size;
             continue;
         }
 
-        if (auto size = CheckUserDictionary(engine, std::string(remainder)); size > 0) {
+        if (auto size = CheckUserDictionary(engine, remainder); size > 0) {
             flush_plaintext();
             ret.push_back(SegmentOffset{SegmentType::UserItem, index, size});
             it += size;
@@ -235,7 +332,9 @@ std::vector<SegmentOffset> SegmentTextImpl(Engine *engine, std::string_view raw_
 }
 
 SegmentOffset LongestSegmentFromStartImpl(Engine *engine, std::string_view raw_buffer) {
-    if (auto size = CheckHyphens(engine, raw_buffer); size > 0) {
+    auto lattice = SegmentLattice(engine, raw_buffer);
+
+    if (auto size = lattice.Hyphens(0); size > 0) {
         return SegmentOffset{SegmentType::Hyphens, 0, size};
     }
 
@@ -243,7 +342,7 @@ SegmentOffset LongestSegmentFromStartImpl(Engine *engine, std::string_view raw_b
         return SegmentOffset{SegmentType::Punct, 0, size};
     }
 
-    if (auto size = MaxSplitSize(engine, raw_buffer); size > 0) {
+    if (auto size = lattice.MaxSplitSize(0); size > 0) {
         return SegmentOffset{SegmentType::Splittable, 0, size};
     }
 
@@ -251,11 +350,11 @@ SegmentOffset LongestSegmentFromStartImpl(Engine *engine, std::string_view raw_b
         return SegmentOffset{SegmentType::UserItem, 0, size};
     }
 
-    if (CheckWordPrefix(engine, raw_buffer)) {
+    if (lattice.WordPrefix(0)) {
         return SegmentOffset{SegmentType::WordPrefix, 0, raw_buffer.size()};
     }
 
-    if (CheckSyllablePrefix(engine, raw_buffer)) {
+    if (lattice.SyllablePrefix(0)) {
         return SegmentOffset{SegmentType::SyllablePrefix, 0, raw_buffer.size()};
     }
 
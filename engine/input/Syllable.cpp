@@ -7,6 +7,8 @@
 #include "config/KeyConfig.h"
 #include "utils/unicode.h"
 
+#include "LomajiTable.h"
+
 namespace khiin::engine {
 namespace {
 namespace u8u = utf8::unchecked;
@@ -19,7 +21,8 @@ const std::string kKhinHyphenStr = "--";
 
 Syllable::Syllable(Syllable const &other) = default;
 
-Syllable::Syllable(KeyConfig *keyconfig, bool dotted_khin) : m_keyconfig(keyconfig), m_dotted_khin(dotted_khin) {}
+Syllable::Syllable(KeyConfig *keyconfig, bool dotted_khin, LomajiTable const *table)
+    : m_keyconfig(keyconfig), m_table(table), m_dotted_khin(dotted_khin) {}
 
 void Syllable::SetRawInput(std::string const &input) {
     m_raw_input = input;
@@ -287,12 +290,19 @@ void Syllable::EnsureToneKey() {
 
 void Syllable::BuildComposed() {
     auto composed_str = m_keyconfig->Convert(m_raw_body);
-    Lomaji::ApplyToneDiacritic(m_tone, composed_str);
+    if (m_table != nullptr) {
+        m_table->ApplyToneDiacritic(m_tone, composed_str);
+    } else {
+        Lomaji::ApplyToneDiacritic(m_tone, composed_str);
+        composed_str = to_nfc(composed_str);
+    }
+
+    // The khin is not changed by normalization
     if (m_khin_pos != KhinKeyPosition::None) {
         const auto &khinstr = m_dotted_khin ? kKhinDotStr : kKhinHyphenStr;
         composed_str.insert(0, khinstr);
     }
-    m_composed = to_nfc(composed_str);
+    m_composed = std::move(composed_str);
 }
 
 void Syllable::BuildRaw() {
@@ -305,7 +315,8 @@ void Syllable::BuildRaw() {
 
     m_raw_body = m_composed;
 
-    if (m_tone = Lomaji::RemoveToneDiacritic(m_raw_body); m_tone != Tone::NaT) {
+    m_tone = m_table != nullptr ? m_table->RemoveToneDiacritic(m_raw_body) : Lomaji::RemoveToneDiacritic(m_raw_body);
+    if (m_tone != Tone::NaT) {
         EnsureToneKey();
     }
 
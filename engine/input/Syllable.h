@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "Lomaji.h"
@@ -14,10 +15,12 @@ enum class KhinKeyPosition {
 };
 
 class KeyConfig;
+class LomajiTable;
 
 struct Syllable {
     Syllable(Syllable const &other);
-    Syllable(KeyConfig *keyconfig, bool dotted_khin);
+    // With a |table|, known syllables are composed and decomposed with it
+    Syllable(KeyConfig *keyconfig, bool dotted_khin, LomajiTable const *table = nullptr);
     bool operator==(Syllable const &rhs) const;
     void SetRawInput(std::string const &input);
     void SetComposed(std::string const &input);
@@ -49,6 +52,7 @@ struct Syllable {
     void BuildRaw();
 
     KeyConfig *m_keyconfig;
+    LomajiTable const *m_table = nullptr;
     bool m_dotted_khin = false;
     std::string m_raw_input;
     std::string m_raw_body;
@@ -59,4 +63,8 @@ struct Syllable {
     std::string m_composed;
 };
 
+// A parsed syllable shared by every TaiText that contains it. Changing one
+// means replacing it with a changed copy.
+using SharedSyllable = std::shared_ptr<Syllable const>;
+
 } // namespace khiin::engine
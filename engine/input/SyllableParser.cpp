@@ -2,13 +2,18 @@
 
 #include <algorithm>
 #include <iterator>
+#include <list>
+#include <string_view>
+#include <unordered_map>
 
 #include "config/Config.h"
 #include "config/KeyConfig.h"
+#include "data/Database.h"
 #include "utils/unicode.h"
 
 #include "Engine.h"
 #include "Lomaji.h"
+#include "LomajiTable.h"
 #include "Syllable.h"
 #include "TaiText.h"
 
@@ -50,10 +55,6 @@ std::vector<T> odometer_merge(std::vector<std::vector<T>> const &vector_set) {
 // inline constexpr std::array<char, 8> kToneableLetters = {'a', 'e', 'i', 'm', 'n', 'o', 'u'};
 // inline constexpr std::array<char, 2> kSyllableSeparator = {' ', '-'};
 
-const std::unordered_map<Tone, std::string> kToneToUnicodeMap = {{Tone::T2, u8"\u0301"}, {Tone::T3, u8"\u0300"},
-                                                                 {Tone::T5, u8"\u0302"}, {Tone::T7, u8"\u0304"},
-                                                                 {Tone::T8, u8"\u030d"}, {Tone::T9, u8"\u0306"}};
-
 const std::string kKhinDotStr = u8"\u00b7";
 const std::string kKhinHyphenStr = "--";
 const std::string kSpaceStr = u8" ";
@@ -67,19 +68,6 @@ inline bool EndsWithPtkh(std::string_view str) {
     return ch == 'p' || ch == 't' || ch == 'k' || ch == 'h';
 }
 
-bool RemoveToneDiacriticSaveTone(KeyConfig *keyconfig, std::string &input, Tone &tone, char &key, char &telex_key) {
-    for (auto const &[t, t_str] : kToneToUnicodeMap) {
-        if (auto i = input.find(t_str); i != std::string::npos) {
-            tone = t;
-            input.erase(i, t_str.size());
-            keyconfig->GetToneKeys(tone, key, telex_key);
-            return true;
-        }
-    }
-
-    return false;
-}
-
 void EraseAll(std::string &input, std::string const &substr) {
     auto idx = std::string::npos;
     while ((idx = input.find(substr)) != std::string::npos) {
@@ -87,13 +75,16 @@ void EraseAll(std::string &input, std::string const &substr) {
     }
 }
 
-void ComposedToRawWithAlternates(KeyConfig *keyconfig, const std::string &input, std::vector<std::string> &output,
-                                 bool &has_tone) {
-    auto syl = Lomaji::Decompose(input);
-    auto tone = Tone::NaT;
+void ComposedToRawWithAlternates(KeyConfig *keyconfig, LomajiTable const &table, const std::string &input,
+                                 std::vector<std::string> &output, bool &has_tone) {
+    auto syl = std::string();
+    auto tone = table.SplitTone(input, syl);
     char digit_key = 0;
     char telex_key = 0;
-    auto found_tone = RemoveToneDiacriticSaveTone(keyconfig, syl, tone, digit_key, telex_key);
+    auto found_tone = tone != Tone::NaT;
+    if (found_tone) {
+        keyconfig->GetToneKeys(tone, digit_key, telex_key);
+    }
     syl = keyconfig->Deconvert(syl);
     unicode::str_tolower(syl);
 
@@ -122,28 +113,101 @@ void ComposedToRawWithAlternates(KeyConfig *keyconfig, const std::string &input,
     }
 }
 
+constexpr size_t kSyllableCacheCapacity = 1024;
+
+// Bounded LRU of parsed syllables by their input
+class SyllableCache {
+  public:
+    explicit SyllableCache(size_t capacity) : m_capacity(capacity) {}
+
+    SharedSyllable Find(std::string const &input) {
+        auto it = m_index.find(input);
+        if (it == m_index.end()) {
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+
+    void Insert(std::string const &input, SharedSyllable syllable) {
+        if (m_capacity == 0) {
+            return;
+        }
+
+        if (m_entries.size() == m_capacity) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+
+        m_entries.emplace_front(input, std::move(syllable));
+        m_index.emplace(m_entries.front().first, m_entries.begin());
+    }
+
+    void Clear() {
+        m_index.clear();
+        m_entries.clear();
+    }
+
+  private:
+    using Entry = std::pair<std::string, SharedSyllable>;
+
+    size_t m_capacity = 0;
+    // Most recently used first
+    std::list<Entry> m_entries;
+    // Keys point into |m_entries|
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;
+};
+
 class SyllableParserImpl : public SyllableParser {
   public:
-    explicit SyllableParserImpl(Engine *engine) : m_engine(engine) {}
+    explicit SyllableParserImpl(Engine *engine)
+        : m_engine(engine), m_raw_cache(kSyllableCacheCapacity), m_composed_cache(kSyllableCacheCapacity) {
+        if (auto *db = m_engine->database()) {
+            auto syllables = std::vector<std::string>();
+            db->LoadSyllables(syllables);
+            m_table = LomajiTable(syllables);
+        }
+    }
 
     bool DottedKhin() {
         return m_engine->config()->dotted_khin();
     }
 
     Syllable ParseRaw(std::string const &input) override {
-        auto syl = Syllable(m_engine->keyconfig(), DottedKhin());
-        syl.SetRawInput(input);
-        return syl;
+        return *ParseRawShared(input);
     }
 
     Syllable ParseComposed(std::string const &input) override {
-        auto syl = Syllable(m_engine->keyconfig(), DottedKhin());
-        syl.SetComposed(input);
+        return *ParseComposedShared(input);
+    }
+
+    SharedSyllable ParseRawShared(std::string const &input) override {
+        CheckCaches();
+        if (auto cached = m_raw_cache.Find(input)) {
+            return cached;
+        }
+
+        auto syl = std::make_shared<Syllable>(m_engine->keyconfig(), DottedKhin(), &m_table);
+        syl->SetRawInput(input);
+        m_raw_cache.Insert(input, syl);
+        return syl;
+    }
+
+    SharedSyllable ParseComposedShared(std::string const &input) override {
+        CheckCaches();
+        if (auto cached = m_composed_cache.Find(input)) {
+            return cached;
+        }
+
+        auto syl = std::make_shared<Syllable>(m_engine->keyconfig(), DottedKhin(), &m_table);
+        syl->SetComposed(input);
+        m_composed_cache.Insert(input, syl);
         return syl;
     }
 
     void ToFuzzy(std::string const &input, std::vector<std::string> &output, bool &has_tone) override {
-        ComposedToRawWithAlternates(m_engine->keyconfig(), input, output, has_tone);
+        ComposedToRawWithAlternates(m_engine->keyconfig(), m_table, input, output, has_tone);
     }
 
     std::vector<InputSequence> AsInputSequences(std::string const &word) override {
@@ -215,12 +279,11 @@ class SyllableParserImpl : public SyllableParser {
         auto sep = std::find_if(t_start, t_end, IsSyllableSeparator);
 
         auto targ_syl = [&]() {
-            return ParseComposed(std::string(t_start, sep));
+            return ParseComposedShared(std::string(t_start, sep));
         };
 
         while (sep != t_end) {
-            auto syl = AlignRawToComposed(targ_syl(), r_start, r_end);
-            ret.AddItem(syl);
+            ret.AddItem(AlignRawToComposed(*targ_syl(), r_start, r_end));
 
             if (r_start == r_end) {
                 return ret;
@@ -230,8 +293,7 @@ class SyllableParserImpl : public SyllableParser {
             t_start = sep + 1;
             sep = std::find_if(t_start, t_end, IsSyllableSeparator);
         }
-        auto syl = AlignRawToComposed(targ_syl(), r_start, r_end);
-        ret.AddItem(syl);
+        ret.AddItem(AlignRawToComposed(*targ_syl(), r_start, r_end));
 
         return ret;
     }
@@ -239,7 +301,7 @@ class SyllableParserImpl : public SyllableParser {
   private:
     // |raw| may be more than one syllable, and may have separators or tones or not.
     // |target| is exactly one syllable.
-    Syllable AlignRawToComposed(Syllable const &target, std::string::const_iterator &r_begin,
+    SharedSyllable AlignRawToComposed(Syllable const &target, std::string::const_iterator &r_begin,
                                 std::string::const_iterator const &r_end) {
 
         auto const &target_raw = target.raw_input();
@@ -271,10 +333,38 @@ class SyllableParserImpl : public SyllableParser {
 
         auto r_syl = std::string(r_begin, r_it);
         r_begin = r_it;
-        return ParseRaw(r_syl);
+        return ParseRawShared(r_syl);
     }
 
+    // Syllables depend on the keys and on the dotted khin setting, which
+    // may be changed directly rather than through a config change
+    void CheckCaches() {
+        auto *keyconfig = m_engine->keyconfig();
+        auto stamp = CacheStamp{keyconfig, keyconfig->version(), DottedKhin()};
+
+        if (stamp != m_cache_stamp) {
+            m_raw_cache.Clear();
+            m_composed_cache.Clear();
+            m_cache_stamp = stamp;
+        }
+    }
+
+    struct CacheStamp {
+        KeyConfig *keyconfig = nullptr;
+        uint64_t keyconfig_version = 0;
+        bool dotted_khin = false;
+
+        bool operator!=(CacheStamp const &other) const {
+            return keyconfig != other.keyconfig || keyconfig_version != other.keyconfig_version ||
+                   dotted_khin != other.dotted_khin;
+        }
+    };
+
     Engine *m_engine;
+    LomajiTable m_table;
+    SyllableCache m_raw_cache;
+    SyllableCache m_composed_cache;
+    CacheStamp m_cache_stamp;
 };
 
 } // namespace
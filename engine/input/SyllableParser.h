@@ -10,6 +10,7 @@ namespace khiin::engine {
 class Engine;
 class KeyConfig;
 struct Syllable;
+using SharedSyllable = std::shared_ptr<Syllable const>;
 class TaiText;
 enum class KhinKeyPosition;
 
@@ -29,6 +30,14 @@ class SyllableParser {
 
     virtual Syllable ParseRaw(std::string const &input) = 0;
     virtual Syllable ParseComposed(std::string const &input) = 0;
+
+    // Same as ParseRaw and ParseComposed, but the result is shared with
+    // earlier calls for the same input. Parsed syllables are kept in a
+    // bounded cache, which is dropped when the key config or the dotted khin
+    // setting changes.
+    virtual SharedSyllable ParseRawShared(std::string const &input) = 0;
+    virtual SharedSyllable ParseComposedShared(std::string const &input) = 0;
+
     virtual void ToFuzzy(std::string const &input, std::vector<std::string> &output, bool &has_tone) = 0;
     virtual std::vector<InputSequence> AsInputSequences(std::string const &input) = 0;
     virtual TaiText AsTaiText(std::string const &raw, std::string const &target) = 0;
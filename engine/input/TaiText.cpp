@@ -11,29 +11,44 @@ namespace {
 namespace u8u = utf8::unchecked;
 
 const auto composed_size_visitor = overloaded  //
-    {[](Syllable const &elem) {
-         return elem.composed_size();
+    {[](SharedSyllable const &elem) {
+         return elem->composed_size();
      },
      [](VirtualSpace elem) {
          return size_t(1);
      }};
 
 const auto to_raw_visitor = overloaded  //
-    {[](Syllable const &elem) {
-         return elem.raw_input();
+    {[](SharedSyllable const &elem) {
+         return elem->raw_input();
      },
      [](VirtualSpace elem) {
          return std::string();
      }};
 
 const auto to_composed_visitor = overloaded  //
-    {[](Syllable const &elem) {
-         return elem.composed();
+    {[](SharedSyllable const &elem) {
+         return elem->composed();
      },
      [](VirtualSpace elem) {
          return std::string(1, ' ');
      }};
 
+Syllable const *SyllableOf(TaiText::Chunk const &chunk) {
+    auto const *syl = std::get_if<SharedSyllable>(&chunk);
+    return syl != nullptr ? syl->get() : nullptr;
+}
+
+// Replaces the shared syllable in |chunk| with a copy changed by |change|
+template <typename F>
+void ChangeSyllable(TaiText::Chunk &chunk, F change) {
+    if (auto *syl = std::get_if<SharedSyllable>(&chunk)) {
+        auto changed = std::make_shared<Syllable>(**syl);
+        change(*changed);
+        *syl = std::move(changed);
+    }
+}
+
 std::vector<std::string> SplitConvertedToSyllables(std::string_view str) {
     using namespace unicode;
     auto ret = std::vector<std::string>();
@@ -90,10 +105,10 @@ bool TaiText::operator==(TaiText const &rhs) const {
             continue;
         }
 
-        auto const *lsyl = std::get_if<Syllable>(&l);
-        auto const *rsyl = std::get_if<Syllable>(&r);
+        auto const *lsyl = std::get_if<SharedSyllable>(&l);
+        auto const *rsyl = std::get_if<SharedSyllable>(&r);
 
-        if (lsyl != nullptr && rsyl != nullptr && *lsyl == *rsyl) {
+        if (lsyl != nullptr && rsyl != nullptr && **lsyl == **rsyl) {
             continue;
         }
 
@@ -104,7 +119,11 @@ bool TaiText::operator==(TaiText const &rhs) const {
 }
 
 void TaiText::AddItem(Syllable syllable) {
-    m_elements.push_back(Chunk{syllable});
+    m_elements.push_back(Chunk{std::make_shared<Syllable const>(std::move(syllable))});
+}
+
+void TaiText::AddItem(SharedSyllable syllable) {
+    m_elements.push_back(Chunk{std::move(syllable)});
 }
 
 void TaiText::AddItem(VirtualSpace spacer) {
@@ -126,7 +145,7 @@ std::string TaiText::RawText() const {
 utf8_size_t TaiText::RawSize() const {
     utf8_size_t size = 0;
     for (auto const &v_elem : m_elements) {
-        if (auto *elem = std::get_if<Syllable>(&v_elem)) {
+        if (auto *elem = SyllableOf(v_elem)) {
             size += elem->raw_input_size();
         }
     }
@@ -149,16 +168,21 @@ utf8_size_t TaiText::ComposedSize() const {
     return size;
 }
 
+std::string TaiText::ConvertedText(std::string const &raw, TaiToken const &candidate) {
+    if (Lomaji::IsLomaji(candidate.output) && !unicode::all_lower(raw)) {
+        return Lomaji::MatchCapitalization(raw, candidate.output);
+    }
+
+    return std::string(candidate.output);
+}
+
 std::string TaiText::ConvertedText() const {
     if (candidate) {
         if (Lomaji::IsLomaji(candidate->output)) {
-            auto raw = RawText();
-            if (!unicode::all_lower(raw)) {
-                return Lomaji::MatchCapitalization(raw, candidate->output);
-            }
+            return ConvertedText(RawText(), candidate.value());
         }
 
-        return candidate->output;
+        return std::string(candidate->output);
     }
 
     return ComposedText();
@@ -173,7 +197,7 @@ utf8_size_t TaiText::ConvertedSize() const {
 size_t TaiText::SyllableSize() const {
     size_t ret = 0;
     for (auto const &v_elem : m_elements) {
-        if (std::holds_alternative<Syllable>(v_elem)) {
+        if (std::holds_alternative<SharedSyllable>(v_elem)) {
             ++ret;
         }
     }
@@ -186,7 +210,7 @@ utf8_size_t TaiText::RawToComposedCaret(size_t raw_caret) const {
 
     for (auto const &v_elem : m_elements) {
         if (remainder > 0) {
-            if (auto *elem = std::get_if<Syllable>(&v_elem)) {
+            if (auto *elem = SyllableOf(v_elem)) {
                 if (auto raw_size = elem->raw_input_size();
                     remainder > raw_size) {
                     remainder -= raw_size;
@@ -215,7 +239,7 @@ size_t TaiText::ComposedToRawCaret(utf8_size_t caret) const {
             break;
         }
 
-        if (auto *elem = std::get_if<Syllable>(&v_elem)) {
+        if (auto *elem = SyllableOf(v_elem)) {
             if (auto size = elem->composed_size(); remainder > size) {
                 remainder -= size;
                 raw_caret += elem->raw_input_size();
@@ -252,7 +276,7 @@ size_t TaiText::ConvertedToRawCaret(utf8_size_t caret) const {
             break;
         }
 
-        if (auto *elem = std::get_if<Syllable>(&v_elem)) {
+        if (auto *elem = SyllableOf(v_elem)) {
             if (auto size = elem->composed_size(); remainder > size) {
                 remainder -= size;
                 raw_caret += elem->raw_input_size();
@@ -289,8 +313,10 @@ void TaiText::Erase(utf8_size_t index) {
 
     if (std::holds_alternative<VirtualSpace>(*it)) {
         m_elements.erase(it);
-    } else if (auto *elem = std::get_if<Syllable>(&*it)) {
-        elem->Erase(remainder);
+    } else {
+        ChangeSyllable(*it, [&](Syllable &syl) {
+            syl.Erase(remainder);
+        });
     }
 }
 
@@ -316,8 +342,10 @@ bool TaiText::IsVirtualSpace(utf8_size_t index) const {
 
 void TaiText::SetKhin(KhinKeyPosition khin_pos, char khin_key) {
     for (auto it = m_elements.begin(); it != m_elements.end(); ++it) {
-        if (auto *elem = std::get_if<Syllable>(&*it)) {
-            elem->SetKhin(khin_pos, khin_key);
+        if (std::holds_alternative<SharedSyllable>(*it)) {
+            ChangeSyllable(*it, [&](Syllable &syl) {
+                syl.SetKhin(khin_pos, khin_key);
+            });
             // Only the first khin can be non-virtual
             khin_pos = KhinKeyPosition::Virtual;
             khin_key = 0;
@@ -327,15 +355,14 @@ void TaiText::SetKhin(KhinKeyPosition khin_pos, char khin_key) {
 
 TaiText TaiText::FromRawSyllable(
     SyllableParser *parser, std::string const &syllable) {
-    auto syl = parser->ParseRaw(syllable);
     TaiText ret;
-    ret.AddItem(syl);
+    ret.AddItem(parser->ParseRawShared(syllable));
     return ret;
 }
 
 TaiText TaiText::FromMatching(
     SyllableParser *parser, std::string const &input, TaiToken const &match) {
-    return parser->AsTaiText(input, match.input);
+    return parser->AsTaiText(input, std::string(match.input));
 }
 
 }  // namespace khiin::engine
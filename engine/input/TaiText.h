@@ -18,13 +18,19 @@ struct VirtualSpace {
 // segment on the buffer (e.g., has a single candidate)
 class TaiText {
   public:
-    using Chunk = std::variant<Syllable, VirtualSpace>;
+    // Syllables are shared with the parser's cache and with copies of the
+    // text, and are copied only when they are changed
+    using Chunk = std::variant<SharedSyllable, VirtualSpace>;
     static TaiText FromRawSyllable(SyllableParser *parser, std::string const &syllable);
     static TaiText FromMatching(SyllableParser *parser, std::string const &input, TaiToken const &match);
 
+    // Converted text of |raw| input with |candidate|, without parsing |raw|
+    static std::string ConvertedText(std::string const &raw, TaiToken const &candidate);
+
     bool operator==(TaiText const &rhs) const;
 
     void AddItem(Syllable syllable);
+    void AddItem(SharedSyllable syllable);
     void AddItem(VirtualSpace spacer);
     void SetCandidate(TaiToken const &candidate);
 
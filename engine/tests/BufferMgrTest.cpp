@@ -194,6 +194,51 @@ TEST_F(BufferCaretTest, MoveType_siongho) {
     ExpectBuffer("si hong ho", 4);
 }
 
+TEST_F(BufferCaretTest, MoveType_siongho_at_once) {
+    input("siongho");
+    curs_left(6);
+    input("ho");
+    auto expected_display = display();
+    auto expected_caret = caret();
+    auto expected_candidates = get_cand_strings();
+
+    bufmgr->Clear();
+    bufmgr->Insert("siongho");
+    curs_left(6);
+    bufmgr->Insert("ho");
+    EXPECT_EQ(display(), expected_display);
+    EXPECT_EQ(caret(), expected_caret);
+    EXPECT_EQ(get_cand_strings(), expected_candidates);
+}
+
+TEST_F(BufferCaretTest, Interrupted_insert_leaves_the_buffer) {
+    input("siongho");
+    curs_left(6);
+    auto display_before = display();
+    auto caret_before = caret();
+    auto candidates_before = get_cand_strings();
+
+    EXPECT_FALSE(bufmgr->Insert("ho", [] {
+        return true;
+    }));
+    EXPECT_EQ(display(), display_before);
+    EXPECT_EQ(caret(), caret_before);
+    EXPECT_EQ(get_cand_strings(), candidates_before);
+
+    EXPECT_TRUE(bufmgr->Insert("ho", [] {
+        return false;
+    }));
+    auto display_after = display();
+    auto caret_after = caret();
+
+    bufmgr->Clear();
+    input("siongho");
+    curs_left(6);
+    input("ho");
+    EXPECT_EQ(display(), display_after);
+    EXPECT_EQ(caret(), caret_after);
+}
+
 //+---------------------------------------------------------------------------
 //
 // Deletions
@@ -405,6 +450,56 @@ TEST_F(CandidatesTest, Candidates_e) {
     ExpectCandidate("ē");
 }
 
+TEST_F(CandidatesTest, Sentence_limits_from_config) {
+    auto conf = AppConfig();
+    conf.set_input_mode(IM_CONTINUOUS);
+    engine()->config()->UpdateAppConfig(conf);
+    input("e5e5");
+    auto all = get_cand_strings();
+
+    bufmgr->Clear();
+    conf.set_sentence_max_results(1);
+    engine()->config()->UpdateAppConfig(conf);
+    input("e5e5");
+    auto one = get_cand_strings();
+    engine()->config()->UpdateAppConfig(AppConfig());
+
+    ASSERT_FALSE(one.empty());
+    EXPECT_LT(one.size(), all.size());
+    EXPECT_EQ(one[0], all[0]);
+}
+
+TEST_F(CandidatesTest, Sentence_limits_are_clamped) {
+    auto conf = AppConfig();
+    conf.set_input_mode(IM_CONTINUOUS);
+    engine()->config()->UpdateAppConfig(conf);
+    auto beam_width = engine()->config()->sentence_beam_width();
+    auto max_results = engine()->config()->sentence_max_results();
+    input("e5e5");
+    auto defaults = get_cand_strings();
+
+    bufmgr->Clear();
+    conf.set_sentence_beam_width(UINT32_MAX);
+    conf.set_sentence_max_results(UINT32_MAX);
+    engine()->config()->UpdateAppConfig(conf);
+    EXPECT_EQ(engine()->config()->sentence_beam_width(), 64);
+    EXPECT_EQ(engine()->config()->sentence_max_results(), 64);
+    input("e5e5");
+    auto oversized = get_cand_strings();
+
+    bufmgr->Clear();
+    conf.set_sentence_beam_width(0);
+    conf.set_sentence_max_results(0);
+    engine()->config()->UpdateAppConfig(conf);
+    EXPECT_EQ(engine()->config()->sentence_beam_width(), beam_width);
+    EXPECT_EQ(engine()->config()->sentence_max_results(), max_results);
+    engine()->config()->UpdateAppConfig(AppConfig());
+
+    ASSERT_FALSE(oversized.empty());
+    EXPECT_GE(oversized.size(), defaults.size());
+    EXPECT_EQ(oversized[0], defaults[0]);
+}
+
 TEST_F(CandidatesTest, Goa_goa) {
     input("goa");
     ExpectCandidateSize(8);
@@ -547,7 +642,7 @@ TEST_F(BufferConversionTest, Convert_e5) {
 
 TEST_F(BufferConversionTest, Convert_ebe1) {
     input("ebe");
-    ExpectCandidateSize(9);
+    ExpectCandidateSize(13);
     ExpectSegment(1, 0, SS_COMPOSING, "e be", 4);
 }
 
@@ -747,6 +842,9 @@ TEST_F(CandidateNavigationTest, Focus_hobo) {
     ExpectSegment(2, 0, SS_FOCUSED, "好", 2);
     ExpectSegment(2, 1, SS_CONVERTED, "無", 2);
     curs_down(1);
+    ExpectSegment(3, 0, SS_FOCUSED, "好", 4);
+    ExpectSegment(3, 2, SS_CONVERTED, "bo", 4);
+    curs_down(4);
     ExpectSegment(2, 0, SS_FOCUSED, "好", 4);
     ExpectSegment(2, 1, SS_COMPOSING, " bo", 4);
 }
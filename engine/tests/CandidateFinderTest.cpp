@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "Engine.h"
+#include "data/Database.h"
+#include "input/CandidateCache.h"
+#include "input/CandidateFinder.h"
+
+#include "TestEnv.h"
+
+namespace khiin::engine {
+namespace {
+
+struct CandidateFinderTest : ::testing::Test, TestEnv {
+  protected:
+    void TearDown() override {
+        engine()->database()->ClearNGramsData();
+    }
+
+    void ExpectSameAsFullMatch(ContinuousMatcher *matcher, std::string const &query) {
+        auto expected = CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt, query);
+        auto result = matcher->MultiMatch(std::nullopt, query);
+        ASSERT_EQ(result.size(), expected.size()) << query;
+        for (size_t i = 0; i < result.size(); ++i) {
+            EXPECT_EQ(result[i].Text(), expected[i].Text()) << query;
+            EXPECT_EQ(result[i].RawText(), expected[i].RawText()) << query;
+        }
+    }
+};
+
+TEST_F(CandidateFinderTest, ContinuousMatcher_type_and_erase) {
+    auto matcher = ContinuousMatcher::Create(engine());
+    auto input = std::string("hobohoboe5e5-chiahpa");
+
+    for (size_t i = 1; i <= input.size(); ++i) {
+        ExpectSameAsFullMatch(matcher.get(), input.substr(0, i));
+    }
+
+    for (size_t i = input.size(); i > 0; --i) {
+        ExpectSameAsFullMatch(matcher.get(), input.substr(0, i));
+    }
+}
+
+TEST_F(CandidateFinderTest, ContinuousMatcher_edit_middle) {
+    auto matcher = ContinuousMatcher::Create(engine());
+    ExpectSameAsFullMatch(matcher.get(), "hoboe5e5");
+    ExpectSameAsFullMatch(matcher.get(), "hoe5e5");
+    ExpectSameAsFullMatch(matcher.get(), "hobobohoe5e5");
+    ExpectSameAsFullMatch(matcher.get(), "e5");
+}
+
+TEST_F(CandidateFinderTest, ContinuousMatcher_resumes_after_interruption) {
+    auto matcher = ContinuousMatcher::Create(engine());
+    EXPECT_FALSE(matcher->MultiMatch(std::nullopt, "hoboe5e5", [] {
+        return true;
+    }));
+
+    auto letters = 0;
+    EXPECT_FALSE(matcher->MultiMatch(std::nullopt, "hoboe5e5", [&] {
+        return ++letters > 3;
+    }));
+    EXPECT_GT(letters, 3);
+
+    ExpectSameAsFullMatch(matcher.get(), "hoboe5e5");
+}
+
+TEST_F(CandidateFinderTest, ContinuousMatcher_rematches_after_ngrams_change) {
+    auto matcher = ContinuousMatcher::Create(engine());
+    auto result = matcher->MultiMatch(std::nullopt, "e5");
+    ASSERT_FALSE(result.empty());
+    EXPECT_NE(result[0].Text(), "鞋");
+
+    engine()->database()->RecordUnigrams({"鞋"});
+    result = matcher->MultiMatch(std::nullopt, "e5");
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(result[0].Text(), "鞋");
+}
+
+TEST_F(CandidateFinderTest, ContinuousMatcher_rematches_after_user_dictionary_changes) {
+    auto matcher = ContinuousMatcher::Create(engine());
+    auto has_user_item = [&] {
+        auto result = matcher->MultiMatch(std::nullopt, "khiin");
+        return std::any_of(result.begin(), result.end(), [](Candidate const &cand) {
+            return cand.Text() == "起引";
+        });
+    };
+
+    EXPECT_FALSE(has_user_item());
+    engine()->LoadUserDictionary("khiin_userdb.txt");
+    EXPECT_TRUE(has_user_item());
+    engine()->LoadUserDictionary("");
+    EXPECT_FALSE(has_user_item());
+}
+
+TEST_F(CandidateFinderTest, MultiMatch_builds_candidates_on_demand) {
+    auto *parser = engine()->syllable_parser();
+
+    for (auto const *query : {"e5", "bo", "Bo", "hobo"}) {
+        auto result = CandidateFinder::MultiMatch(engine(), std::nullopt, query);
+        ASSERT_FALSE(result.empty()) << query;
+
+        for (auto &cand : result) {
+            EXPECT_EQ(cand.buffer(), nullptr) << query;
+            auto text = cand.Text();
+            auto raw = cand.RawText();
+            auto &buffer = cand.Get(parser);
+            EXPECT_EQ(cand.buffer(), &buffer);
+            EXPECT_EQ(buffer.Text(), text) << query;
+            EXPECT_EQ(buffer.RawText(), raw) << query;
+            EXPECT_EQ(buffer.Size(), 1);
+        }
+    }
+}
+
+TEST_F(CandidateFinderTest, CandidateCache_hits_and_misses) {
+    auto *cache = engine()->candidate_cache();
+    ASSERT_NE(cache, nullptr);
+    cache->Clear();
+    auto hits = cache->hits();
+    auto misses = cache->misses();
+
+    auto first = CandidateFinder::MultiMatch(engine(), std::nullopt, "e5");
+    EXPECT_EQ(cache->hits(), hits);
+    EXPECT_EQ(cache->misses(), misses + 1);
+
+    auto second = CandidateFinder::MultiMatch(engine(), std::nullopt, "e5");
+    EXPECT_EQ(cache->hits(), hits + 1);
+    EXPECT_EQ(cache->misses(), misses + 1);
+    ASSERT_EQ(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); ++i) {
+        EXPECT_EQ(first[i].Text(), second[i].Text());
+    }
+
+    auto lgram = TaiToken();
+    lgram.output = "兮";
+    CandidateFinder::MultiMatch(engine(), lgram, "e5");
+    EXPECT_EQ(cache->misses(), misses + 2);
+}
+
+TEST_F(CandidateFinderTest, CandidateCache_invalidated_by_ngrams) {
+    auto *cache = engine()->candidate_cache();
+    auto before = CandidateFinder::MultiMatch(engine(), std::nullopt, "e5");
+    ASSERT_FALSE(before.empty());
+    EXPECT_NE(before[0].Text(), "鞋");
+    auto size = cache->size();
+
+    engine()->database()->RecordUnigrams({"鞋"});
+    EXPECT_LT(cache->size(), size);
+
+    auto after = CandidateFinder::MultiMatch(engine(), std::nullopt, "e5");
+    ASSERT_FALSE(after.empty());
+    EXPECT_EQ(after[0].Text(), "鞋");
+}
+
+TEST_F(CandidateFinderTest, CandidateCache_evicts_least_recently_used) {
+    auto cache = CandidateCache::Create(nullptr, 2);
+    auto result = std::vector<Candidate>();
+    cache->Insert(CachedMatch::MultiMatch, std::nullopt, "a", {}, {});
+    cache->Insert(CachedMatch::MultiMatch, std::nullopt, "b", {}, {});
+    EXPECT_TRUE(cache->Find(CachedMatch::MultiMatch, std::nullopt, "a", result));
+    cache->Insert(CachedMatch::MultiMatch, std::nullopt, "c", {}, {});
+
+    EXPECT_EQ(cache->size(), 2);
+    EXPECT_TRUE(cache->Find(CachedMatch::MultiMatch, std::nullopt, "a", result));
+    EXPECT_FALSE(cache->Find(CachedMatch::MultiMatch, std::nullopt, "b", result));
+    EXPECT_TRUE(cache->Find(CachedMatch::MultiMatch, std::nullopt, "c", result));
+    EXPECT_FALSE(cache->Find(CachedMatch::OneSplittable, std::nullopt, "c", result));
+}
+
+} // namespace
+} // namespace khiin::engine
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "proto/proto.h"
+
+#include "Engine.h"
+#include "config/Config.h"
+#include "input/CandidatePrefetcher.h"
+
+#include "TestEnv.h"
+
+namespace khiin::engine {
+namespace {
+
+using namespace khiin::proto;
+using namespace std::chrono_literals;
+
+std::vector<Candidate> OneCandidate(std::string text) {
+    return std::vector<Candidate>{Candidate(std::move(text), TaiToken())};
+}
+
+TEST(CandidatePrefetcherTest, Take_uses_one_result_and_drops_the_rest) {
+    auto prefetcher = CandidatePrefetcher([](CandidatePrefetcher::StopFn const &) { return false; }, 20ms, 2);
+    auto key_a = CandidatePrefetcher::Key(InputMode::Basic, std::nullopt, "a");
+    auto key_b = CandidatePrefetcher::Key(InputMode::Basic, std::nullopt, "b");
+    auto key_c = CandidatePrefetcher::Key(InputMode::Basic, std::nullopt, "c");
+
+    prefetcher.Insert(key_a, OneCandidate("a"));
+    prefetcher.Insert(key_b, OneCandidate("b"));
+    prefetcher.Insert(key_c, OneCandidate("c"));
+    EXPECT_TRUE(prefetcher.Contains(key_a));
+    EXPECT_TRUE(prefetcher.Contains(key_b));
+    EXPECT_FALSE(prefetcher.Contains(key_c));
+    EXPECT_EQ(prefetcher.prefetched(), 2);
+
+    auto output = std::vector<Candidate>();
+    EXPECT_TRUE(prefetcher.Take(key_b, output));
+    ASSERT_EQ(output.size(), 1);
+    EXPECT_EQ(output[0].RawText(), "b");
+    EXPECT_FALSE(prefetcher.Contains(key_a));
+    EXPECT_EQ(prefetcher.used(), 1);
+    EXPECT_EQ(prefetcher.wasted(), 1);
+
+    prefetcher.Insert(key_a, OneCandidate("a"));
+    EXPECT_FALSE(prefetcher.Take(key_b, output));
+    EXPECT_EQ(prefetcher.used(), 1);
+    EXPECT_EQ(prefetcher.wasted(), 2);
+}
+
+TEST(CandidatePrefetcherTest, Keys_differ_by_mode_and_context) {
+    auto basic = CandidatePrefetcher::Key(InputMode::Basic, std::nullopt, "a");
+    EXPECT_NE(basic, CandidatePrefetcher::Key(InputMode::Continuous, std::nullopt, "a"));
+    EXPECT_NE(basic, CandidatePrefetcher::Key(InputMode::Basic, std::string(), "a"));
+    EXPECT_NE(basic, CandidatePrefetcher::Key(InputMode::Basic, std::string("a"), ""));
+}
+
+TEST(CandidatePrefetcherTest, Runs_until_nothing_is_left) {
+    auto steps = std::atomic<int>(0);
+    auto prefetcher = CandidatePrefetcher(
+        [&](CandidatePrefetcher::StopFn const &) {
+            return ++steps < 3;
+        },
+        10s);
+
+    prefetcher.Schedule();
+    prefetcher.Wait();
+    EXPECT_EQ(steps, 3);
+}
+
+// A step that keeps working until it is told to stop
+bool SpinUntilStopped(CandidatePrefetcher::StopFn const &stop) {
+    while (!stop()) {
+    }
+    return false;
+}
+
+TEST(CandidatePrefetcherTest, Stops_when_the_budget_is_spent) {
+    auto steps = std::atomic<int>(0);
+    auto prefetcher = CandidatePrefetcher(
+        [&](CandidatePrefetcher::StopFn const &stop) {
+            ++steps;
+            return SpinUntilStopped(stop);
+        },
+        20ms);
+
+    prefetcher.Schedule();
+    prefetcher.Wait();
+    EXPECT_EQ(steps, 1);
+
+    // Each idle period gets the whole budget again
+    prefetcher.Schedule();
+    prefetcher.Wait();
+    EXPECT_EQ(steps, 2);
+}
+
+TEST(CandidatePrefetcherTest, Waiting_does_not_spend_the_budget) {
+    auto steps = std::atomic<int>(0);
+    auto prefetcher = CandidatePrefetcher(
+        [&](CandidatePrefetcher::StopFn const &) {
+            std::this_thread::sleep_for(5ms);
+            return ++steps < 10;
+        },
+        20ms);
+
+    prefetcher.Schedule();
+    prefetcher.Wait();
+    EXPECT_EQ(steps, 10);
+}
+
+TEST(CandidatePrefetcherTest, Cancel_stops_the_running_step) {
+    auto steps = std::atomic<int>(0);
+    auto prefetcher = CandidatePrefetcher(
+        [&](CandidatePrefetcher::StopFn const &stop) {
+            ++steps;
+            return SpinUntilStopped(stop);
+        },
+        10s);
+
+    prefetcher.Schedule();
+    while (steps == 0) {
+        std::this_thread::yield();
+    }
+    prefetcher.Cancel();
+    prefetcher.Wait();
+    EXPECT_EQ(steps, 1);
+}
+
+TEST(CandidatePrefetcherTest, Cancel_stops_before_the_next_step) {
+    auto steps = std::atomic<int>(0);
+    auto prefetcher = CandidatePrefetcher(
+        [&](CandidatePrefetcher::StopFn const &) {
+            ++steps;
+            std::this_thread::sleep_for(1ms);
+            return true;
+        },
+        10s);
+
+    prefetcher.Schedule();
+    while (steps == 0) {
+        std::this_thread::yield();
+    }
+    prefetcher.Cancel();
+    prefetcher.Wait();
+
+    auto after_cancel = steps.load();
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(steps, after_cancel);
+}
+
+// Types on an engine with prefetching enabled, letting it finish
+// prefetching between keys, and on the shared engine without it
+struct PrefetchTest : ::testing::Test, TestEnv {
+  protected:
+    void SetUp() override {
+        prefetching = Engine::Create("./khiin_test.db");
+        Reset(engine());
+    }
+
+    void TearDown() override {
+        Reset(engine());
+        SetConfig(engine(), AppConfig());
+    }
+
+    static void SetConfig(Engine *target, AppConfig const &config) {
+        auto request = Request();
+        request.set_type(CMD_SET_CONFIG);
+        request.mutable_config()->CopyFrom(config);
+        auto response = Response();
+        target->SendCommand(&request, &response);
+    }
+
+    void SetInputMode(proto::InputMode mode) {
+        auto config = AppConfig();
+        config.set_input_mode(mode);
+        SetConfig(engine(), config);
+        config.mutable_prefetch_candidates()->set_value(true);
+        SetConfig(prefetching.get(), config);
+    }
+
+    static void Reset(Engine *target) {
+        auto request = Request();
+        request.set_type(CMD_RESET);
+        auto response = Response();
+        target->SendCommand(&request, &response);
+    }
+
+    static Response SendKey(Engine *target, char ch) {
+        auto request = Request();
+        request.set_type(CMD_SEND_KEY);
+        request.mutable_key_event()->set_key_code(ch);
+        auto response = Response();
+        target->SendCommand(&request, &response);
+        return response;
+    }
+
+    void TypeAndCompare(std::string const &keys) {
+        for (auto ch : keys) {
+            prefetching->candidate_prefetcher()->Wait();
+            auto response = SendKey(prefetching.get(), ch);
+            auto expected = SendKey(engine(), ch);
+            EXPECT_EQ(response.preedit().SerializeAsString(), expected.preedit().SerializeAsString()) << keys;
+            EXPECT_EQ(response.candidate_list().SerializeAsString(), expected.candidate_list().SerializeAsString())
+                << keys;
+        }
+    }
+
+    std::unique_ptr<Engine> prefetching;
+};
+
+TEST_F(PrefetchTest, Disabled_by_default) {
+    SendKey(prefetching.get(), 'a');
+    EXPECT_EQ(prefetching->candidate_prefetcher(), nullptr);
+}
+
+TEST_F(PrefetchTest, Continuous_results_match) {
+    SetInputMode(IM_CONTINUOUS);
+    TypeAndCompare("e5e5");
+    TypeAndCompare("hobo");
+
+    auto *prefetcher = prefetching->candidate_prefetcher();
+    EXPECT_GT(prefetcher->prefetched(), 0);
+    EXPECT_GT(prefetcher->used(), 0);
+}
+
+TEST_F(PrefetchTest, Basic_results_match) {
+    SetInputMode(IM_BASIC);
+    TypeAndCompare("e5e5");
+    TypeAndCompare("hobo");
+
+    auto *prefetcher = prefetching->candidate_prefetcher();
+    EXPECT_GT(prefetcher->used(), 0);
+}
+
+TEST_F(PrefetchTest, Other_commands_drop_prefetched_results) {
+    SetInputMode(IM_CONTINUOUS);
+    TypeAndCompare("e");
+
+    auto *prefetcher = prefetching->candidate_prefetcher();
+    prefetcher->Wait();
+    auto prefetched = prefetcher->prefetched();
+    ASSERT_GT(prefetched, 0);
+
+    Reset(prefetching.get());
+    Reset(engine());
+    prefetcher->Wait();
+    EXPECT_EQ(prefetcher->wasted(), prefetched);
+    TypeAndCompare("e");
+    EXPECT_EQ(prefetcher->used(), 0);
+}
+
+} // namespace
+} // namespace khiin::engine
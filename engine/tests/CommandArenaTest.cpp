@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <vector>
+
+#include "utils/CommandArena.h"
+
+namespace khiin::engine {
+namespace {
+
+TEST(CommandArenaTest, Heap_outside_of_a_scope) {
+    auto arena = CommandArena(1024);
+    EXPECT_FALSE(arena.active());
+    EXPECT_EQ(arena.resource(), std::pmr::get_default_resource());
+
+    {
+        auto scope = CommandArena::Scope(&arena);
+        EXPECT_TRUE(arena.active());
+        EXPECT_NE(arena.resource(), std::pmr::get_default_resource());
+    }
+
+    EXPECT_FALSE(arena.active());
+    EXPECT_EQ(arena.resource(), std::pmr::get_default_resource());
+}
+
+TEST(CommandArenaTest, Released_when_the_outermost_scope_closes) {
+    auto arena = CommandArena(1024);
+    void *first = nullptr;
+
+    {
+        auto outer = CommandArena::Scope(&arena);
+        first = arena.resource()->allocate(64);
+
+        {
+            auto inner = CommandArena::Scope(&arena);
+            EXPECT_TRUE(arena.active());
+        }
+
+        // Still in use by the outer scope
+        EXPECT_TRUE(arena.active());
+        EXPECT_NE(arena.resource()->allocate(64), first);
+    }
+
+    auto scope = CommandArena::Scope(&arena);
+    EXPECT_EQ(arena.resource()->allocate(64), first);
+}
+
+TEST(CommandArenaTest, Grows_past_its_block) {
+    auto arena = CommandArena(256);
+    auto scope = CommandArena::Scope(&arena);
+    auto vec = std::pmr::vector<int>(arena.resource());
+
+    for (auto i = 0; i < 10000; ++i) {
+        vec.push_back(i);
+    }
+
+    EXPECT_EQ(vec.size(), 10000);
+    EXPECT_EQ(vec.back(), 9999);
+}
+
+TEST(CommandArenaTest, Null_scope_does_nothing) {
+    auto scope = CommandArena::Scope(nullptr);
+    SUCCEED();
+}
+
+} // namespace
+} // namespace khiin::engine
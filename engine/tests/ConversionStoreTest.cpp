@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "data/ConversionStore.h"
+
+namespace khiin::engine {
+namespace {
+
+TaiToken MakeToken(int input_id, std::string key_sequence, std::string output, int weight) {
+    auto token = TaiToken();
+    token.input_id = input_id;
+    token.key_sequence = std::move(key_sequence);
+    token.input = token.key_sequence;
+    token.output = std::move(output);
+    token.annotation = "note";
+    token.category = 1;
+    token.weight = weight;
+    return token;
+}
+
+std::vector<std::string> const kKeys = {"ho", "a", "hoa"};
+
+std::vector<TaiToken> const kConversions = {
+    MakeToken(1, "ho", "好", 10), MakeToken(2, "a", "阿", 10), MakeToken(1, "ho", "號", 5),
+    MakeToken(3, "hoa", "花", 10), MakeToken(9, "xyz", "x", 0),  MakeToken(2, "a", "亞", 5),
+};
+
+std::vector<std::string> Outputs(std::vector<TaiToken> const &tokens) {
+    auto ret = std::vector<std::string>();
+    for (auto const &token : tokens) {
+        ret.emplace_back(token.output);
+    }
+    return ret;
+}
+
+TEST(ConversionStoreTest, LoadByKeyId) {
+    auto store = ConversionStore::Create(kKeys, kConversions);
+    ASSERT_NE(store, nullptr);
+    EXPECT_EQ(store->key_count(), 3);
+    EXPECT_EQ(store->size(), 5);
+
+    auto tokens = std::vector<TaiToken>();
+    store->Load(0, tokens);
+    EXPECT_EQ(Outputs(tokens), (std::vector<std::string>{"好", "號"}));
+    EXPECT_EQ(tokens[0].key_sequence, "ho");
+    EXPECT_EQ(tokens[0].input, "ho");
+    EXPECT_EQ(tokens[0].input_id, 1);
+    EXPECT_EQ(tokens[0].annotation, "note");
+    EXPECT_EQ(tokens[0].category, 1);
+    EXPECT_EQ(tokens[1].weight, 5);
+
+    tokens.clear();
+    store->Load(-1, tokens);
+    store->Load(3, tokens);
+    EXPECT_TRUE(tokens.empty());
+}
+
+TEST(ConversionStoreTest, LoadSeveralKeysInGivenOrder) {
+    auto store = ConversionStore::Create(kKeys, kConversions);
+    auto tokens = std::vector<TaiToken>();
+    store->Load(std::vector<int>{2, 1, 0}, tokens);
+    EXPECT_EQ(Outputs(tokens), (std::vector<std::string>{"好", "阿", "號", "花", "亞"}));
+}
+
+TEST(ConversionStoreTest, CompileAndMap) {
+    auto data = ConversionStore::Compile(kKeys, kConversions);
+    auto aligned = std::vector<uint32_t>((data.size() + 3) / 4);
+    std::memcpy(aligned.data(), data.data(), data.size());
+    auto view = std::string_view(reinterpret_cast<char const *>(aligned.data()), data.size());
+
+    auto store = ConversionStore::Map(view);
+    ASSERT_NE(store, nullptr);
+    auto tokens = std::vector<TaiToken>();
+    store->Load(1, tokens);
+    EXPECT_EQ(Outputs(tokens), (std::vector<std::string>{"阿", "亞"}));
+
+    EXPECT_EQ(ConversionStore::Map(view.substr(0, view.size() - 4)), nullptr);
+    EXPECT_EQ(ConversionStore::Map(std::string_view()), nullptr);
+}
+
+} // namespace
+} // namespace khiin::engine
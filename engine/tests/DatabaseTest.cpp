@@ -85,6 +85,69 @@ TEST_F(DatabaseTest, GetBigramCounts) {
     //EXPECT_EQ(result[0].count, 1);
 }
 
+// Statements are reused between calls with different numbers of grams
+TEST_F(DatabaseTest, RecordUnigramsRepeatedly) {
+    db->RecordUnigrams({"a", "b", "a"});
+    db->RecordUnigrams({"b"});
+    db->RecordUnigrams({"c", "\"quoted\\", "b"});
+
+    auto tokens = std::vector<TaiToken>(4);
+    tokens[0].output = "a";
+    tokens[1].output = "b";
+    tokens[2].output = "c";
+    tokens[3].output = "\"quoted\\";
+    db->AddNGramsData(std::nullopt, tokens);
+    EXPECT_EQ(tokens[0].unigram_count, 2);
+    EXPECT_EQ(tokens[1].unigram_count, 3);
+    EXPECT_EQ(tokens[2].unigram_count, 1);
+    EXPECT_EQ(tokens[3].unigram_count, 1);
+}
+
+TEST_F(DatabaseTest, RecordBigramsRepeatedly) {
+    db->RecordBigrams({{"a", "b"}, {"a", "c"}});
+    db->RecordBigrams({{"a", "b"}});
+
+    auto tokens = std::vector<TaiToken>(3);
+    tokens[0].output = "b";
+    tokens[1].output = "c";
+    tokens[2].output = "d";
+    db->AddNGramsData("a", tokens);
+    EXPECT_EQ(tokens[0].bigram_count, 2);
+    EXPECT_EQ(tokens[1].bigram_count, 1);
+    EXPECT_EQ(tokens[2].bigram_count, 0);
+}
+
+// Recorded n-grams are written in the background, and all of them before
+// the database is closed
+TEST_F(DatabaseTest, RecordedNGramsAreWrittenOnClose) {
+    db->RecordUnigrams({"a", "a"});
+    db->RecordBigrams({{"a", "b"}});
+    db.reset();
+    db = Database::Connect(kDatabaseFilename);
+
+    auto tokens = std::vector<TaiToken>(1);
+    tokens[0].output = "b";
+    db->AddNGramsData("a", tokens);
+    EXPECT_EQ(tokens[0].bigram_count, 1);
+
+    tokens[0].output = "a";
+    db->AddNGramsData(std::nullopt, tokens);
+    EXPECT_EQ(tokens[0].unigram_count, 2);
+}
+
+TEST_F(DatabaseTest, LoadConversionsRepeatedly) {
+    auto one = std::vector<std::string>{"a"};
+    auto two = std::vector<std::string>{"a", "ho2"};
+    auto first = std::vector<TaiToken>();
+    auto second = std::vector<TaiToken>();
+    auto again = std::vector<TaiToken>();
+    db->LoadConversions(one, InputType::Numeric, first);
+    db->LoadConversions(two, InputType::Numeric, second);
+    db->LoadConversions(one, InputType::Numeric, again);
+    EXPECT_GE(second.size(), first.size());
+    EXPECT_EQ(again.size(), first.size());
+}
+
 TEST_F(DatabaseTest, select_syllable_list) {
     // auto res = db->GetSyllableList();
     // EXPECT_GT(res.size(), 0);
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "proto/proto.h"
+
+#include "Engine.h"
+#include "data/ConversionStore.h"
+#include "data/Database.h"
+#include "data/Dictionary.h"
+#include "data/DictionaryImage.h"
+#include "data/Trie.h"
+
+#include "TestEnv.h"
+
+namespace khiin::engine {
+namespace {
+
+// Not named after khiin_test.db, so the test engine never picks it up
+constexpr auto kImageFile = "khiin_test_image.dict";
+
+struct DictionaryImageTest : ::testing::Test, TestEnv {
+  protected:
+    void SetUp() override {
+        ASSERT_TRUE(engine()->dictionary()->CompileImage(kImageFile));
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(kImageFile);
+    }
+
+    std::string fingerprint() {
+        return engine()->database()->DictionaryFingerprint();
+    }
+};
+
+TEST(DictionaryImageStaticTest, ImageFileFor) {
+    EXPECT_EQ(DictionaryImage::ImageFileFor("khiin.db"), "khiin.dict");
+    EXPECT_EQ(DictionaryImage::ImageFileFor("dir/khiin_test.db"), "dir/khiin_test.dict");
+    EXPECT_EQ(DictionaryImage::ImageFileFor(""), "");
+}
+
+TEST_F(DictionaryImageTest, RoundTrip) {
+    auto image = DictionaryImage::Open(kImageFile, fingerprint());
+    ASSERT_NE(image, nullptr);
+
+    auto keys = std::vector<std::string>();
+    auto expected = std::vector<std::string>();
+    image->LoadKeySequences(keys);
+    engine()->database()->AllWordsByFreq(expected, InputType::Numeric);
+    EXPECT_EQ(keys, expected);
+    EXPECT_EQ(image->WordCount(), expected.size());
+
+    auto word_trie = image->WordTrie();
+    ASSERT_NE(word_trie, nullptr);
+    for (auto const &key : keys) {
+        EXPECT_TRUE(word_trie->HasKey(key)) << key;
+    }
+
+    auto conversions = image->Conversions();
+    ASSERT_NE(conversions, nullptr);
+    EXPECT_EQ(conversions->key_count(), keys.size());
+    for (auto const &key : {"a", "ho2"}) {
+        auto actual = std::vector<TaiToken>();
+        conversions->Load(word_trie->KeyId(key), actual);
+        EXPECT_EQ(actual.size(), engine()->dictionary()->WordSearch(key).size()) << key;
+    }
+}
+
+// Syllable inputs depend on the key config, so they must not come from an
+// image compiled with other keys
+TEST_F(DictionaryImageTest, SyllablesFollowKeyConfig) {
+    auto const db_file = std::string("khiin_test_keys.db");
+    auto const image_file = DictionaryImage::ImageFileFor(db_file);
+    std::filesystem::copy_file("khiin_test.db", db_file, std::filesystem::copy_options::overwrite_existing);
+    ASSERT_TRUE(engine()->dictionary()->CompileImage(image_file));
+
+    auto keyed = Engine::Create(db_file);
+    auto *dict = keyed->dictionary();
+    EXPECT_TRUE(dict->IsSyllablePrefix("pann"));
+    EXPECT_FALSE(dict->IsSyllablePrefix("pav"));
+
+    auto request = proto::Request();
+    request.set_type(proto::CMD_SET_CONFIG);
+    request.mutable_config()->mutable_key_config()->set_nasal("v");
+    auto response = proto::Response();
+    keyed->SendCommand(&request, &response);
+    EXPECT_TRUE(dict->IsSyllablePrefix("pav"));
+
+    keyed.reset();
+    std::filesystem::remove(db_file);
+    std::filesystem::remove(image_file);
+}
+
+TEST_F(DictionaryImageTest, StaleFingerprint) {
+    EXPECT_EQ(DictionaryImage::Open(kImageFile, fingerprint() + "x"), nullptr);
+    EXPECT_EQ(DictionaryImage::Open(kImageFile, ""), nullptr);
+}
+
+TEST_F(DictionaryImageTest, Missing) {
+    EXPECT_EQ(DictionaryImage::Open("does_not_exist.dict", fingerprint()), nullptr);
+}
+
+TEST_F(DictionaryImageTest, Corrupt) {
+    {
+        auto out = std::ofstream(kImageFile, std::ios::binary | std::ios::trunc);
+        out << "KHIINDIC but not really";
+    }
+
+    EXPECT_EQ(DictionaryImage::Open(kImageFile, fingerprint()), nullptr);
+}
+
+} // namespace
+} // namespace khiin::engine
@@ -1,6 +1,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
+
+#include "data/Database.h"
 #include "data/Dictionary.h"
 
 #include "TestEnv.h"
@@ -14,5 +17,37 @@ TEST_F(DictionaryTest, Loads) {
     auto dict = engine()->dictionary();
 }
 
+TEST_F(DictionaryTest, LongestSyllablePrefix) {
+    auto *dict = engine()->dictionary();
+
+    for (auto query : {"a", "ho2", "hoa", "hoxyz", "chhiong5", "chhiong5x", "chh", "x", "a2b", "ang5ang"}) {
+        size_t expected = 0;
+        while (expected < std::strlen(query) && dict->IsSyllablePrefix(std::string_view(query, expected + 1))) {
+            ++expected;
+        }
+        EXPECT_EQ(dict->LongestSyllablePrefix(query), expected) << query;
+    }
+}
+
+// The in-memory conversions must match what the database returns
+TEST_F(DictionaryTest, WordSearchMatchesDatabase) {
+    auto *dict = engine()->dictionary();
+
+    for (auto query : {"a", "ho2", "hoa", "chhiong5", "goa", "xyz"}) {
+        auto inputs = std::vector<std::string>{query};
+        auto expected = std::vector<TaiToken>();
+        engine()->database()->LoadConversions(inputs, InputType::Numeric, expected);
+        auto actual = dict->WordSearch(query);
+
+        ASSERT_EQ(actual.size(), expected.size()) << query;
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].output, expected[i].output) << query;
+            EXPECT_EQ(actual[i].input, expected[i].input) << query;
+            EXPECT_EQ(actual[i].input_id, expected[i].input_id) << query;
+            EXPECT_EQ(actual[i].weight, expected[i].weight) << query;
+        }
+    }
+}
+
 } // namespace
 } // namespace khiin::engine
@@ -0,0 +1,394 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "proto/proto.h"
+
+#include "Engine.h"
+#include "input/KeyEventWorker.h"
+
+#include "TestEnv.h"
+
+namespace khiin::engine {
+namespace {
+
+using namespace khiin::proto;
+using namespace std::chrono_literals;
+
+Request KeyRequest(char ch) {
+    auto request = Request();
+    request.set_type(CMD_SEND_KEY);
+    request.mutable_key_event()->set_key_code(ch);
+    return request;
+}
+
+Request SpecialKeyRequest(SpecialKey key) {
+    auto request = Request();
+    request.set_type(CMD_SEND_KEY);
+    request.mutable_key_event()->set_special_key(key);
+    return request;
+}
+
+std::string PreeditText(Response const &response) {
+    auto ret = std::string();
+    for (auto const &segment : response.preedit().segments()) {
+        ret += segment.value();
+    }
+    return ret;
+}
+
+std::vector<std::string> CandidateValues(Response const &response) {
+    auto ret = std::vector<std::string>();
+    for (auto const &candidate : response.candidate_list().candidates()) {
+        ret.push_back(candidate.value());
+    }
+    return ret;
+}
+
+// Lets the test hold the worker inside |apply| until it is released
+class Gate {
+  public:
+    void Pass() {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_entered = true;
+        m_changed.notify_all();
+        m_changed.wait(lock, [this] {
+            return m_open;
+        });
+    }
+
+    void WaitUntilEntered() {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_changed.wait(lock, [this] {
+            return m_entered;
+        });
+    }
+
+    void Open() {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_open = true;
+        m_changed.notify_all();
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_entered = false;
+    bool m_open = false;
+};
+
+// Counts ready callbacks, which run on the worker thread after Wait may
+// already have returned
+class ReadyCount {
+  public:
+    void Increment() {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        ++m_count;
+        m_changed.notify_all();
+    }
+
+    // Waits briefly for a late callback, then returns the count
+    int Get() {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_changed.wait_for(lock, 1s, [this] {
+            return m_count > 0;
+        });
+        return m_count;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    int m_count = 0;
+};
+
+TEST(KeyEventWorkerTest, Only_the_last_result_is_collected) {
+    auto gate = Gate();
+    auto applied = std::string();
+    auto collected = 0;
+    auto ready = ReadyCount();
+
+    auto worker = KeyEventWorker(
+        [&](std::string const &keys, KeyEventWorker::SupersededFn const &) {
+            gate.Pass();
+            applied += keys;
+            return true;
+        },
+        [&](Response *response) {
+            ++collected;
+            response->mutable_preedit()->add_segments()->set_value(applied);
+            response->mutable_preedit()->set_caret(static_cast<int32_t>(applied.size()));
+        });
+    worker.SetReadyCallback([&] {
+        ready.Increment();
+    });
+
+    auto response = Response();
+    worker.Post(KeyRequest('a'), &response);
+    gate.WaitUntilEntered();
+    worker.Post(KeyRequest('b'), &response);
+    worker.Post(KeyRequest('c'), &response);
+    EXPECT_TRUE(worker.busy());
+    EXPECT_TRUE(response.candidates_pending());
+    EXPECT_EQ(PreeditText(response), "abc");
+
+    gate.Open();
+    worker.Wait();
+
+    EXPECT_FALSE(worker.busy());
+    EXPECT_EQ(applied, "abc");
+    EXPECT_EQ(collected, 1);
+    EXPECT_EQ(ready.Get(), 1);
+
+    response = Response();
+    worker.GetResult(&response);
+    EXPECT_FALSE(response.candidates_pending());
+    EXPECT_EQ(PreeditText(response), "abc");
+}
+
+// The keys that queue up behind a search are inserted together, so the
+// searches for the compositions they pass through never run
+TEST(KeyEventWorkerTest, Pending_keys_skip_superseded_searches) {
+    auto gate = Gate();
+    auto batches = std::vector<std::string>();
+
+    auto worker = KeyEventWorker(
+        [&](std::string const &keys, KeyEventWorker::SupersededFn const &) {
+            gate.Pass();
+            batches.push_back(keys);
+            return true;
+        },
+        [](Response *) {});
+
+    auto response = Response();
+    worker.Post(KeyRequest('t'), &response);
+    gate.WaitUntilEntered();
+    for (auto ch : std::string("aichi")) {
+        worker.Post(KeyRequest(ch), &response);
+    }
+
+    gate.Open();
+    worker.Wait();
+
+    EXPECT_EQ(batches, (std::vector<std::string>{"t", "aichi"}));
+}
+
+// A search that runs until a newer key arrives gives up, and its keys are
+// applied again together with the newer ones
+TEST(KeyEventWorkerTest, Newer_keys_interrupt_a_running_search) {
+    auto gate = Gate();
+    auto attempts = std::vector<std::string>();
+    auto applied = std::string();
+
+    auto worker = KeyEventWorker(
+        [&](std::string const &keys, KeyEventWorker::SupersededFn const &superseded) {
+            attempts.push_back(keys);
+            if (attempts.size() == 1) {
+                gate.Pass();
+                while (!superseded()) {
+                    std::this_thread::yield();
+                }
+                return false;
+            }
+            applied += keys;
+            return true;
+        },
+        [](Response *) {});
+
+    auto response = Response();
+    worker.Post(KeyRequest('h'), &response);
+    gate.WaitUntilEntered();
+    gate.Open();
+    worker.Post(KeyRequest('o'), &response);
+    worker.Wait();
+
+    EXPECT_EQ(attempts, (std::vector<std::string>{"h", "ho"}));
+    EXPECT_EQ(applied, "ho");
+}
+
+TEST(KeyEventWorkerTest, Provisional_preedit_inserts_at_caret) {
+    auto gate = Gate();
+    auto worker = KeyEventWorker(
+        [&](std::string const &, KeyEventWorker::SupersededFn const &) {
+            gate.Pass();
+            return true;
+        },
+        [](Response *) {});
+
+    auto result = Response();
+    auto *preedit = result.mutable_preedit();
+    auto *segment = preedit->add_segments();
+    segment->set_status(SS_CONVERTED);
+    segment->set_value(u8"好無");
+    segment = preedit->add_segments();
+    segment->set_status(SS_COMPOSING);
+    segment->set_value("bo");
+    preedit->set_caret(1);
+    preedit->set_focused_caret(0);
+    worker.SetResult(result);
+
+    auto response = Response();
+    worker.Post(KeyRequest('x'), &response);
+    ASSERT_EQ(response.preedit().segments_size(), 4);
+    EXPECT_EQ(response.preedit().segments(0).value(), u8"好");
+    EXPECT_EQ(response.preedit().segments(0).status(), SS_CONVERTED);
+    EXPECT_EQ(response.preedit().segments(1).value(), "x");
+    EXPECT_EQ(response.preedit().segments(1).status(), SS_COMPOSING);
+    EXPECT_EQ(response.preedit().segments(2).value(), u8"無");
+    EXPECT_EQ(response.preedit().segments(2).status(), SS_CONVERTED);
+    EXPECT_EQ(response.preedit().segments(3).value(), "bo");
+    EXPECT_EQ(response.preedit().caret(), 2);
+    EXPECT_EQ(response.edit_state(), ES_COMPOSING);
+
+    gate.Open();
+    worker.Wait();
+}
+
+// Plays the part of a host: sends keys from its own thread, and fetches the
+// candidates when the engine reports that they are ready
+class FakeHost {
+  public:
+    explicit FakeHost(Engine *engine) : m_engine(engine) {
+        m_engine->SetCandidatesReadyCallback([this] {
+            auto lock = std::unique_lock<std::mutex>(m_mutex);
+            ++m_ready_count;
+            m_ready.notify_all();
+        });
+    }
+
+    ~FakeHost() {
+        m_engine->SetCandidatesReadyCallback(nullptr);
+    }
+
+    Response Send(Request const &request) {
+        auto response = Response();
+        m_engine->SendCommand(&request, &response);
+        return response;
+    }
+
+    // Waits for ready callbacks until the result of the last key is complete
+    Response WaitForCandidates() {
+        auto request = Request();
+        request.set_type(CMD_GET_CANDIDATES);
+
+        while (true) {
+            {
+                auto lock = std::unique_lock<std::mutex>(m_mutex);
+                auto ready = m_ready.wait_for(lock, 10s, [this] {
+                    return m_ready_count > 0;
+                });
+                if (!ready) {
+                    ADD_FAILURE() << "Candidates were never ready";
+                    return Response();
+                }
+                m_ready_count = 0;
+            }
+
+            auto response = Send(request);
+            if (!response.candidates_pending()) {
+                return response;
+            }
+        }
+    }
+
+  private:
+    Engine *m_engine = nullptr;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    int m_ready_count = 0;
+};
+
+struct DeferredCandidatesTest : ::testing::Test, TestEnv {
+  protected:
+    void SetUp() override {
+        deferred = Engine::Create("./khiin_test.db");
+        SetDeferred(deferred.get(), true);
+        Reset(engine());
+    }
+
+    void TearDown() override {
+        Reset(engine());
+    }
+
+    static void SetDeferred(Engine *target, bool value) {
+        auto request = Request();
+        request.set_type(CMD_SET_CONFIG);
+        request.mutable_config()->mutable_deferred_candidates()->set_value(value);
+        auto response = Response();
+        target->SendCommand(&request, &response);
+    }
+
+    static void Reset(Engine *target) {
+        auto request = Request();
+        request.set_type(CMD_RESET);
+        auto response = Response();
+        target->SendCommand(&request, &response);
+    }
+
+    // The same request sent to the shared engine, which computes
+    // everything on the calling thread
+    Response Expected(Request const &request) {
+        auto response = Response();
+        engine()->SendCommand(&request, &response);
+        return response;
+    }
+
+    void ExpectSameResult(Response const &result, Response const &expected) {
+        EXPECT_FALSE(result.candidates_pending());
+        EXPECT_EQ(PreeditText(result), PreeditText(expected));
+        EXPECT_EQ(result.preedit().caret(), expected.preedit().caret());
+        EXPECT_EQ(CandidateValues(result), CandidateValues(expected));
+        EXPECT_EQ(result.edit_state(), expected.edit_state());
+    }
+
+    std::unique_ptr<Engine> deferred;
+};
+
+TEST_F(DeferredCandidatesTest, Typing_returns_provisional_preedit) {
+    auto host = FakeHost(deferred.get());
+    auto expected = Response();
+
+    for (auto ch : std::string("hobo")) {
+        auto response = host.Send(KeyRequest(ch));
+        EXPECT_TRUE(response.candidates_pending());
+        EXPECT_EQ(response.candidate_list().candidates_size(), 0);
+        EXPECT_NE(PreeditText(response).find(ch), std::string::npos);
+        expected = Expected(KeyRequest(ch));
+    }
+
+    ExpectSameResult(host.WaitForCandidates(), expected);
+}
+
+TEST_F(DeferredCandidatesTest, Other_keys_wait_for_pending_keys) {
+    auto host = FakeHost(deferred.get());
+
+    for (auto ch : std::string("e5e5")) {
+        host.Send(KeyRequest(ch));
+        Expected(KeyRequest(ch));
+    }
+
+    auto request = SpecialKeyRequest(SK_BACKSPACE);
+    auto response = host.Send(request);
+    ExpectSameResult(response, Expected(request));
+
+    auto get = Request();
+    get.set_type(CMD_GET_CANDIDATES);
+    ExpectSameResult(host.Send(get), response);
+
+    host.Send(KeyRequest('5'));
+    auto expected = Expected(KeyRequest('5'));
+    ExpectSameResult(host.WaitForCandidates(), expected);
+
+    request = SpecialKeyRequest(SK_LEFT);
+    ExpectSameResult(host.Send(request), Expected(request));
+    host.Send(KeyRequest('a'));
+    ExpectSameResult(host.WaitForCandidates(), Expected(KeyRequest('a')));
+}
+
+} // namespace
+} // namespace khiin::engine
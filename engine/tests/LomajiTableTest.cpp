@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "data/Database.h"
+#include "input/Lomaji.h"
+#include "input/LomajiTable.h"
+#include "utils/unicode.h"
+
+#include "TestEnv.h"
+
+namespace khiin::engine {
+namespace {
+
+const std::vector<std::string> kSyllables = {"a", "oan", "ho", u8"o͘", u8"naⁿ", "ng", "m", "chhiat"};
+// Tones that Lomaji can apply; T6 and TK have no diacritic of their own
+const std::vector<Tone> kTones = {Tone::NaT, Tone::T1, Tone::T2, Tone::T3, Tone::T4,
+                                  Tone::T5,  Tone::T7, Tone::T8, Tone::T9};
+
+std::string Composed(Tone tone, std::string syllable) {
+    Lomaji::ApplyToneDiacritic(tone, syllable);
+    return unicode::to_nfc(syllable);
+}
+
+TEST(LomajiTableTest, Compose_matches_lomaji) {
+    auto table = LomajiTable(kSyllables);
+    EXPECT_EQ(table.size(), kSyllables.size() * 2 * 7);
+
+    for (auto syllable : kSyllables) {
+        for (auto const &body : {syllable, Lomaji::MatchCapitalization("A", syllable)}) {
+            for (auto tone : kTones) {
+                auto composed = body;
+                table.ApplyToneDiacritic(tone, composed);
+                EXPECT_EQ(composed, Composed(tone, body)) << body << " " << static_cast<int>(tone);
+            }
+        }
+    }
+}
+
+TEST(LomajiTableTest, Decompose_matches_lomaji) {
+    auto table = LomajiTable(kSyllables);
+
+    for (auto const &syllable : kSyllables) {
+        for (auto tone : kTones) {
+            for (auto const &prefix : {std::string(), std::string(u8"·"), std::string("--")}) {
+                auto composed = prefix + Composed(tone, syllable);
+
+                auto removed = composed;
+                auto expected = composed;
+                EXPECT_EQ(table.RemoveToneDiacritic(removed), Lomaji::RemoveToneDiacritic(expected)) << composed;
+                EXPECT_EQ(removed, expected);
+
+                auto body = std::string();
+                expected = Lomaji::Decompose(composed);
+                auto expected_tone = Lomaji::RemoveToneDiacritic(expected);
+                EXPECT_EQ(table.SplitTone(composed, body), expected_tone) << composed;
+                EXPECT_EQ(body, expected);
+            }
+        }
+    }
+}
+
+struct LomajiTableDbTest : ::testing::Test, TestEnv {};
+
+TEST_F(LomajiTableDbTest, Every_syllable_matches_lomaji) {
+    auto syllables = std::vector<std::string>();
+    engine()->database()->LoadSyllables(syllables);
+    auto table = LomajiTable(syllables);
+
+    for (auto const &syllable : syllables) {
+        for (auto tone : kTones) {
+            auto composed = syllable;
+            table.ApplyToneDiacritic(tone, composed);
+            ASSERT_EQ(composed, Composed(tone, syllable));
+
+            auto body = std::string();
+            auto expected = composed;
+            ASSERT_EQ(table.SplitTone(composed, body), Lomaji::RemoveToneDiacritic(expected)) << composed;
+            ASSERT_EQ(body, Lomaji::Decompose(expected));
+        }
+    }
+}
+
+TEST(LomajiTableTest, Falls_back_outside_the_table) {
+    auto table = LomajiTable(kSyllables);
+
+    auto composed = std::string("tai");
+    table.ApplyToneDiacritic(Tone::T5, composed);
+    EXPECT_EQ(composed, u8"tâi");
+
+    auto body = std::string();
+    EXPECT_EQ(table.SplitTone(composed, body), Tone::T5);
+    EXPECT_EQ(body, "tai");
+    EXPECT_EQ(table.RemoveToneDiacritic(composed), Tone::T5);
+    EXPECT_EQ(composed, "tai");
+
+    auto empty = LomajiTable();
+    composed = "a";
+    empty.ApplyToneDiacritic(Tone::T2, composed);
+    EXPECT_EQ(composed, u8"á");
+}
+
+} // namespace
+} // namespace khiin::engine
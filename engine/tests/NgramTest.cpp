@@ -1,5 +1,8 @@
 #include "TestEnv.h"
 #include "data/Database.h"
+#include "data/Dictionary.h"
+#include "data/NGramCounts.h"
+#include "data/StringPool.h"
 #include "input/CandidateFinder.h"
 
 namespace khiin::engine {
@@ -37,4 +40,112 @@ TEST_F(NgramTest, TestUnigramSort) {
     EXPECT_EQ(result[2].Text(), "兮");
 }
 
+TEST_F(NgramTest, TestBigramRevisesEarlierWord) {
+    auto result =
+        CandidateFinder::ContinuousSingleMatch(engine(), std::nullopt, "e5e5");
+    EXPECT_EQ(result.Text(), "个个");
+    engine()->database()->RecordBigrams({{"兮", "鞋"}});
+    result =
+        CandidateFinder::ContinuousSingleMatch(engine(), std::nullopt, "e5e5");
+    EXPECT_EQ(result.Text(), "兮鞋");
+}
+
+TEST_F(NgramTest, TestSentenceCandidates) {
+    auto result =
+        CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt, "e5e5");
+    ASSERT_GE(result.size(), 3);
+    EXPECT_EQ(result[0].Text(), "个个");
+    EXPECT_EQ(result[0].Size(), 2);
+    EXPECT_EQ(result[1].Size(), 2);
+    EXPECT_EQ(result[2].Size(), 2);
+
+    engine()->database()->RecordBigrams({{"兮", "鞋"}});
+    result =
+        CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt, "e5e5");
+    EXPECT_EQ(result[0].Text(), "兮鞋");
+
+    auto limits = SentenceSearchLimits();
+    limits.max_results = 2;
+    result = CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt,
+                                                   "e5e5", limits);
+    EXPECT_EQ(result[0].Text(), "兮鞋");
+}
+
+// N-gram counts rank the conversions of a segmentation, but must not make a
+// segmentation with more words beat a cheaper one
+TEST_F(NgramTest, TestUnigramDoesNotOutweighSplitCost) {
+    auto result =
+        CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt, "abogoae");
+    ASSERT_FALSE(result.empty());
+    auto best = result[0].Text();
+    EXPECT_EQ(result[0].Size(), 2);
+
+    auto go = engine()->dictionary()->WordSearch("go");
+    ASSERT_FALSE(go.empty());
+    RecordUnigrams({std::string(go[0].output)});
+    result =
+        CandidateFinder::ContinuousMultiMatch(engine(), std::nullopt, "abogoae");
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(result[0].Text(), best);
+    EXPECT_EQ(result[0].Size(), 2);
+}
+
+TEST(NGramCountsTest, Lookup) {
+    auto counts = NGramCounts();
+    counts.AddUnigram("a", 2);
+    counts.AddUnigram("b", 1);
+    counts.AddUnigram("a", 1);
+    counts.AddBigram("a", "b", 4);
+    counts.AddBigram("c", "a", 1);
+
+    EXPECT_EQ(counts.UnigramCount("a"), 3);
+    EXPECT_EQ(counts.UnigramCount("c"), 0);
+    EXPECT_EQ(counts.UnigramCount("x"), 0);
+    EXPECT_EQ(counts.BigramCount("a", "b"), 4);
+    EXPECT_EQ(counts.BigramCount("b", "a"), 0);
+
+    auto tokens = std::vector<TaiToken>(3);
+    tokens[0].output = "b";
+    tokens[1].output = "a";
+    tokens[2].output = "x";
+    counts.Lookup("a", tokens);
+    EXPECT_EQ(tokens[0].unigram_count, 1);
+    EXPECT_EQ(tokens[0].bigram_count, 4);
+    EXPECT_EQ(tokens[1].unigram_count, 3);
+    EXPECT_EQ(tokens[1].bigram_count, 0);
+    EXPECT_EQ(tokens[2].unigram_count, 0);
+
+    counts.Clear();
+    counts.Lookup(std::nullopt, tokens);
+    EXPECT_EQ(tokens[1].unigram_count, 0);
+    EXPECT_EQ(tokens[0].bigram_count, 4);
+}
+
+TEST(NGramCountsTest, Lookup_counts_the_first_homograph_only) {
+    auto counts = NGramCounts();
+    counts.AddUnigram("a", 2);
+    counts.AddBigram("b", "a", 3);
+
+    auto tokens = std::vector<TaiToken>(3);
+    tokens[0].output = "a";
+    tokens[1].output = "b";
+    tokens[2].output = "a";
+    counts.Lookup("b", tokens);
+    EXPECT_EQ(tokens[0].unigram_count, 2);
+    EXPECT_EQ(tokens[0].bigram_count, 3);
+    EXPECT_EQ(tokens[2].unigram_count, 0);
+    EXPECT_EQ(tokens[2].bigram_count, 0);
+}
+
+TEST(NGramCountsTest, Grams_are_not_interned) {
+    auto counts = NGramCounts();
+    auto pool_size = StringPool::size();
+    counts.AddUnigram("ngram counts user gram", 1);
+    counts.AddBigram("ngram counts user lgram", "ngram counts user rgram", 1);
+
+    EXPECT_EQ(StringPool::size(), pool_size);
+    EXPECT_EQ(counts.UnigramCount("ngram counts user gram"), 1);
+    EXPECT_EQ(counts.BigramCount("ngram counts user lgram", "ngram counts user rgram"), 1);
+}
+
 }  // namespace khiin::engine
@@ -77,5 +77,25 @@ TEST_F(SegmenterTest, Segment_u__bo) {
     EXPECT_EQ(segments[2].size, 2);
 }
 
+TEST_F(SegmenterTest, Segment_long_input) {
+    auto input = std::string();
+    for (auto i = 0; i < 9; ++i) {
+        input += "goabobehkhi";
+    }
+
+    auto segments = Segmenter::SegmentText(TestEnv::engine(), input);
+    EXPECT_EQ(segments.size(), 1);
+    EXPECT_EQ(segments[0].type, SegmentType::Splittable);
+    EXPECT_EQ(segments[0].start, 0);
+    EXPECT_EQ(segments[0].size, 99);
+
+    segments = Segmenter::SegmentText(TestEnv::engine(), input + "--" + input);
+    EXPECT_EQ(segments.size(), 3);
+    EXPECT_EQ(segments[1].type, SegmentType::Hyphens);
+    EXPECT_EQ(segments[1].start, 99);
+    EXPECT_EQ(segments[2].start, 101);
+    EXPECT_EQ(segments[2].size, 99);
+}
+
 } // namespace
 } // namespace khiin::engine
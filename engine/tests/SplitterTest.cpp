@@ -89,6 +89,63 @@ TEST(SplitterTest, SplitIndices) {
     EXPECT_EQ(splitter.MaxSplitSize("toalang"), 7);
 }
 
+TEST(SplitterTest, MaxSplitSizeInvalidIndices) {
+    auto splitter = Splitter(words);
+    EXPECT_EQ(splitter.MaxSplitSize("lihoxyz", {1}), 0);
+    EXPECT_EQ(splitter.MaxSplitSize("lihoxyz", {3}), 2);
+    EXPECT_EQ(splitter.MaxSplitSize("toalang", {2}), 7);
+}
+
+TEST(SplitterTest, SharedTrie) {
+    auto trie = Trie::CreateFrozen(words);
+    auto shared = Splitter(trie.get(), words.size());
+    auto owned = Splitter(words);
+    EXPECT_EQ(shared.costs(), owned.costs());
+
+    for (auto query : {"goamchaiujoachelanghamgoaukangkhoanesengtiong", "goamchaiblarg", "li2ho2", "ppp"}) {
+        EXPECT_EQ(shared.CanSplit(query), owned.CanSplit(query)) << query;
+        EXPECT_EQ(shared.MaxSplitSize(query), owned.MaxSplitSize(query)) << query;
+
+        auto shared_res = std::vector<std::string>();
+        auto owned_res = std::vector<std::string>();
+        shared.Split(query, shared_res);
+        owned.Split(query, owned_res);
+        EXPECT_EQ(shared_res, owned_res) << query;
+    }
+}
+
+TEST(SplitterTest, StateTyping) {
+    auto splitter = Splitter(words);
+    auto state = Splitter::State(&splitter);
+    EXPECT_TRUE(state.CanSplit());
+    EXPECT_EQ(state.MaxSplitSize(), 0);
+
+    auto input = std::string("goamchaiujoachelanghamxgoaukangkhoan");
+    for (auto ch : input) {
+        state.Append(ch);
+        EXPECT_EQ(state.CanSplit(), splitter.CanSplit(state.text())) << state.text();
+        EXPECT_EQ(state.MaxSplitSize(), splitter.MaxSplitSize(state.text())) << state.text();
+    }
+
+    while (!state.text().empty()) {
+        state.Truncate(1);
+        EXPECT_EQ(state.CanSplit(), splitter.CanSplit(state.text())) << state.text();
+        EXPECT_EQ(state.MaxSplitSize(), splitter.MaxSplitSize(state.text())) << state.text();
+    }
+}
+
+TEST(SplitterTest, StateSeek) {
+    auto splitter = Splitter(words);
+    auto state = Splitter::State(&splitter);
+
+    for (auto query : {"toalang", "toa7lang5", "toa7", "toa7langx", "liho", "lihoxyz", "", "mchaijoache"}) {
+        state.Seek(query);
+        EXPECT_EQ(state.text(), query);
+        EXPECT_EQ(state.CanSplit(), splitter.CanSplit(query)) << query;
+        EXPECT_EQ(state.MaxSplitSize(), splitter.MaxSplitSize(query)) << query;
+    }
+}
+
 struct SplitterTestWithDb : ::testing::Test, TestEnv {};
 
 TEST_F(SplitterTestWithDb, DISABLED_UsingActualEngine) {
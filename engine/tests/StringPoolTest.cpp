@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "data/StringPool.h"
+
+namespace khiin::engine {
+namespace {
+
+TEST(StringPoolTest, Equal_strings_share_an_id) {
+    auto a = InternedString(std::string("string pool test"));
+    auto b = InternedString("string pool test");
+    auto c = InternedString(std::string_view("string pool test 2"));
+
+    EXPECT_EQ(a.id(), b.id());
+    EXPECT_NE(a.id(), c.id());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.view(), "string pool test");
+    EXPECT_EQ(a, std::string("string pool test"));
+    EXPECT_EQ("string pool test 2", c);
+    EXPECT_NE(c, "string pool test");
+}
+
+TEST(StringPoolTest, Empty_string) {
+    auto empty = InternedString();
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.id(), 0);
+    EXPECT_EQ(empty.view(), "");
+    EXPECT_EQ(InternedString("").id(), 0);
+    EXPECT_EQ(InternedString(std::string()).id(), 0);
+}
+
+TEST(StringPoolTest, Behaves_like_a_string) {
+    auto str = InternedString(u8"好無");
+    EXPECT_EQ(str.size(), std::string(u8"好無").size());
+    EXPECT_EQ(std::string(str.begin(), str.end()), u8"好無");
+    EXPECT_EQ(std::string(str), u8"好無");
+    EXPECT_EQ(std::string("a") + str, u8"a好無");
+    EXPECT_TRUE(InternedString("a") < InternedString("b"));
+
+    auto set = std::unordered_set<InternedString>{str, InternedString(u8"好無")};
+    EXPECT_EQ(set.size(), 1);
+}
+
+TEST(StringPoolTest, Strings_stay_valid_as_the_pool_grows) {
+    auto first = InternedString("string pool growth");
+    auto view = first.view();
+
+    for (int i = 0; i < 10000; ++i) {
+        InternedString("string pool growth " + std::to_string(i));
+    }
+
+    EXPECT_EQ(view.data(), first.view().data());
+    EXPECT_EQ(InternedString("string pool growth 9999"), "string pool growth 9999");
+}
+
+TEST(StringPoolTest, Interning_from_many_threads) {
+    auto ids = std::vector<std::vector<uint32_t>>(4);
+    auto threads = std::vector<std::thread>();
+
+    for (size_t t = 0; t < ids.size(); ++t) {
+        threads.emplace_back([&ids, t] {
+            for (int i = 0; i < 2000; ++i) {
+                auto str = InternedString("string pool thread " + std::to_string(i));
+                ids[t].push_back(str.id());
+                EXPECT_EQ(str.view(), "string pool thread " + std::to_string(i));
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t t = 1; t < ids.size(); ++t) {
+        EXPECT_EQ(ids[t], ids[0]);
+    }
+}
+
+} // namespace
+} // namespace khiin::engine
@@ -4,6 +4,7 @@
 #include "proto/proto.h"
 
 #include "Engine.h"
+#include "config/Config.h"
 #include "config/KeyConfig.h"
 #include "input/Syllable.h"
 #include "input/SyllableParser.h"
@@ -158,5 +159,50 @@ TEST_F(SyllableParserTest, TaiText_an1) {
     EXPECT_EQ(result.ComposedText(), "an");
 }
 
+TEST_F(SyllableParserTest, Parsed_syllables_are_shared) {
+    auto first = parser->ParseRawShared("lang5");
+    auto second = parser->ParseRawShared("lang5");
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->composed(), u8"l\u00e2ng");
+    EXPECT_NE(parser->ParseRawShared("lang2"), first);
+    EXPECT_EQ(parser->ParseComposedShared(u8"l\u00e2ng"), parser->ParseComposedShared(u8"l\u00e2ng"));
+}
+
+TEST_F(SyllableParserTest, Shared_syllables_are_copied_when_changed) {
+    auto text = TaiText::FromRawSyllable(parser, "lang5");
+    auto copy = text;
+    copy.Erase(0);
+
+    EXPECT_EQ(text.RawText(), "lang5");
+    EXPECT_NE(copy.RawText(), "lang5");
+    EXPECT_EQ(parser->ParseRawShared("lang5")->raw_input(), "lang5");
+}
+
+TEST_F(SyllableParserTest, Cache_dropped_when_dotted_khin_changes) {
+    auto *config = engine()->config();
+    auto dotted = config->dotted_khin();
+    auto before = parser->ParseRawShared("--a");
+
+    config->set_dotted_khin(!dotted);
+    auto after = parser->ParseRawShared("--a");
+    EXPECT_NE(after, before);
+    EXPECT_NE(after->composed(), before->composed());
+
+    config->set_dotted_khin(dotted);
+    EXPECT_EQ(parser->ParseRawShared("--a")->composed(), before->composed());
+}
+
+TEST(SyllableParserCacheTest, Cache_dropped_when_keys_change) {
+    auto engine = Engine::Create("./khiin_test.db");
+    auto *parser = engine->syllable_parser();
+    auto before = parser->ParseRawShared("hav");
+    EXPECT_EQ(before->composed(), "hav");
+
+    ASSERT_TRUE(engine->keyconfig()->SetKey('v', VKey::Nasal, true));
+    auto after = parser->ParseRawShared("hav");
+    EXPECT_NE(after, before);
+    EXPECT_EQ(after->composed(), u8"ha\u207f");
+}
+
 } // namespace
 } // namespace khiin::engine
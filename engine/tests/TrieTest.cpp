@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <functional>
 #include <memory>
+#include <random>
 
 #include "data/Trie.h"
 
@@ -61,6 +63,38 @@ TEST_F(TrieTest, autocomplete) {
     EXPECT_NE(std::find(res.begin(), res.end(), "na"), res.end());
 }
 
+TEST_F(TrieTest, autocomplete_frequency_order) {
+    ins({u8"niau", u8"na", u8"nia", u8"nai", u8"ni"});
+
+    auto res = trie->Autocomplete(u8"n");
+    EXPECT_EQ(res, (std::vector<std::string>{u8"niau", u8"na", u8"nia", u8"nai", u8"ni"}));
+
+    res = trie->Autocomplete(u8"n", 2);
+    EXPECT_EQ(res, (std::vector<std::string>{u8"niau", u8"na"}));
+
+    res = trie->Autocomplete(u8"n", 0, 2);
+    EXPECT_EQ(res, (std::vector<std::string>{u8"na", u8"nia", u8"nai", u8"ni"}));
+
+    trie->Remove(u8"niau");
+    res = trie->Autocomplete(u8"ni");
+    EXPECT_EQ(res, (std::vector<std::string>{u8"nia", u8"ni"}));
+}
+
+TEST_F(TrieTest, next_letters_frequency_order) {
+    ins({u8"niau", u8"na", u8"nia", u8"be", u8"nai", u8"ni"});
+
+    EXPECT_EQ(trie->NextLetters(u8"n"), u8"ia");
+    EXPECT_EQ(trie->NextLetters(u8"ni"), u8"a");
+    EXPECT_EQ(trie->NextLetters(u8""), u8"nb");
+    EXPECT_EQ(trie->NextLetters(u8"", 1), u8"n");
+    EXPECT_EQ(trie->NextLetters(u8"niau"), u8"");
+    EXPECT_EQ(trie->NextLetters(u8"x"), u8"");
+
+    trie->Remove(u8"niau");
+    trie->Remove(u8"nia");
+    EXPECT_EQ(trie->NextLetters(u8"n"), u8"ai");
+}
+
 TEST_F(TrieTest, autocomplete_tone) {
     // ins({u8"na2", u8"na7", u8"nai"});
 
@@ -97,19 +131,133 @@ std::string str_from_vec_int(std::vector<int> data) {
 }
 
 TEST_F(TrieTest, Multisplit) {
-    ins({"the", "me", "theme", "meat", "at", "them", "eat"});
-    auto cost_map = std::unordered_map<std::string, float>();
-    cost_map.insert(std::make_pair("the", 1.0f));
-    cost_map.insert(std::make_pair("at", 1.1f));
-    cost_map.insert(std::make_pair("me", 1.2f));
-    cost_map.insert(std::make_pair("eat", 1.3f));
-    cost_map.insert(std::make_pair("them", 1.4f));
-    cost_map.insert(std::make_pair("meat", 1.5f));
-    cost_map.insert(std::make_pair("theme", 1.6f));
+    ins({"the", "at", "me", "eat", "them", "meat", "theme"});
+    auto costs = std::vector<float>{1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f, 1.6f};
 
     // theme at, them eat, the meat, the me at
-    auto ret = trie->Multisplit("themeat", cost_map, 5);
+    auto ret = trie->Multisplit("themeat", costs, 5);
     EXPECT_EQ(ret.size(), 4);
+    EXPECT_EQ(ret[0], (std::vector<int>{3, 7}));    // the meat: 2.5
+    EXPECT_EQ(ret[3], (std::vector<int>{3, 5, 7})); // the me at: 3.3
+}
+
+TEST_F(TrieTest, Multisplit_limit) {
+    ins({"the", "at", "me", "eat", "them", "meat", "theme"});
+    auto costs = std::vector<float>{1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f, 1.6f};
+
+    EXPECT_EQ(trie->Multisplit("themeat", costs, 2).size(), 2);
+    EXPECT_TRUE(trie->Multisplit("themeat", costs, 0).empty());
+}
+
+TEST_F(TrieTest, Multisplit_missing_costs) {
+    ins({"the", "at", "me", "eat", "them", "meat", "theme"});
+
+    // Only "the" and "at" have costs, so there is no full split
+    auto ret = trie->Multisplit("themeat", std::vector<float>{1.0f, 1.1f}, 5);
+    ASSERT_EQ(ret.size(), 1);
+    EXPECT_EQ(ret[0], (std::vector<int>{3}));
+}
+
+TEST_F(TrieTest, Multisplit_long_input) {
+    ins({"the", "at", "me", "eat", "them", "meat", "theme"});
+    auto costs = std::vector<float>{1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f, 1.6f};
+    auto query = std::string();
+    for (auto i = 0; i < 40; ++i) {
+        query += "themeat";
+    }
+
+    auto ret = trie->Multisplit(query, costs, 5);
+    ASSERT_EQ(ret.size(), 5);
+    for (auto const &splits : ret) {
+        EXPECT_EQ(splits.back(), static_cast<int>(query.size()));
+        EXPECT_TRUE(std::is_sorted(splits.begin(), splits.end()));
+    }
+
+    // Cheapest is "the meat" every time
+    EXPECT_EQ(ret[0].size(), 80);
+}
+
+TEST_F(TrieTest, Multisplit_k_best_order) {
+    ins({"a", "aa", "aaa"});
+    auto costs = std::vector<float>{1.0f, 1.5f, 1.8f};
+
+    // All 13 compositions of "aaaaa" into parts of size 1-3
+    auto ret = trie->Multisplit("aaaaa", costs, 50);
+    ASSERT_EQ(ret.size(), 13);
+
+    auto cost_of = [&](std::vector<int> const &splits) {
+        auto cost = 0.0f;
+        auto prev = 0;
+        for (auto split : splits) {
+            cost += costs[split - prev - 1];
+            prev = split;
+        }
+        return cost;
+    };
+
+    for (size_t i = 1; i < ret.size(); ++i) {
+        EXPECT_LE(cost_of(ret[i - 1]), cost_of(ret[i]));
+        EXPECT_NE(ret[i - 1], ret[i]);
+    }
+
+    EXPECT_FLOAT_EQ(cost_of(ret[0]), 3.3f); // aa aaa or aaa aa
+}
+
+TEST_F(TrieTest, Multisplit_matches_brute_force) {
+    auto words = std::vector<std::string>{"a", "b", "ab", "ba", "aab", "bba", "abab", "b", "aaaa"};
+    auto costs = std::vector<float>{1.0f, 1.1f, 1.3f, 1.7f, 2.3f, 2.9f, 3.1f, 9.0f, 3.7f};
+    ins(words);
+
+    auto segment_costs = [&](std::string const &query) {
+        auto ret = std::vector<float>();
+        std::function<void(size_t, float)> dfs = [&](size_t pos, float cost) {
+            if (pos == query.size()) {
+                ret.push_back(cost);
+                return;
+            }
+            for (size_t len = 1; pos + len <= query.size(); ++len) {
+                auto id = trie->KeyId(query.substr(pos, len));
+                if (id >= 0) {
+                    dfs(pos + len, cost + costs[id]);
+                }
+            }
+        };
+        dfs(0, 0.0f);
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    };
+
+    auto rng = std::mt19937(1);
+    for (auto i = 0; i < 50; ++i) {
+        auto query = std::string();
+        for (auto j = 0; j < 14; ++j) {
+            query += (rng() % 2 == 0) ? 'a' : 'b';
+        }
+
+        auto expected = segment_costs(query);
+        auto ret = trie->Multisplit(query, costs, 20);
+        ASSERT_EQ(ret.size(), std::min(expected.size(), size_t(20))) << query;
+
+        for (size_t k = 0; k < ret.size(); ++k) {
+            auto cost = 0.0f;
+            auto prev = 0;
+            for (auto split : ret[k]) {
+                cost += costs[trie->KeyId(query.substr(prev, split - prev))];
+                prev = split;
+            }
+            EXPECT_NEAR(cost, expected[k], 1e-4) << query << " rank " << k;
+        }
+    }
+}
+
+TEST_F(TrieTest, KeyId) {
+    trie->Insert(std::vector<std::string>{"the", "at", "the"});
+    trie->Insert("me");
+    EXPECT_EQ(trie->KeyId("the"), 0);
+    EXPECT_EQ(trie->KeyId("at"), 1);
+    EXPECT_EQ(trie->KeyId("me"), 3);
+    EXPECT_EQ(trie->KeyId("th"), -1);
+    EXPECT_EQ(trie->KeyId("x"), -1);
 }
 
 /**
@@ -1281,5 +1429,125 @@ TEST_F(TrieTest, big_word_list) {
     EXPECT_EQ(std::find(res.begin(), res.end(), u8"any"), res.end());
 }
 
+TEST_F(TrieTest, Cursor) {
+    ins({u8"cho", u8"chong", u8"ba"});
+
+    auto cursor = Trie::Cursor(trie.get());
+    EXPECT_TRUE(cursor.IsKeyOrPrefix());
+    EXPECT_FALSE(cursor.IsKey());
+
+    EXPECT_TRUE(cursor.Advance(u8"cho"));
+    EXPECT_TRUE(cursor.IsKey());
+    EXPECT_EQ(cursor.KeyId(), 0);
+
+    auto fork = cursor.Fork();
+    EXPECT_TRUE(fork.Advance('n'));
+    EXPECT_FALSE(fork.IsKey());
+    EXPECT_TRUE(fork.Advance('g'));
+    EXPECT_EQ(fork.KeyId(), 1);
+    EXPECT_EQ(cursor.text(), u8"cho");
+
+    EXPECT_FALSE(cursor.Advance(u8"xx"));
+    EXPECT_FALSE(cursor.valid());
+    EXPECT_FALSE(cursor.IsKeyOrPrefix());
+    EXPECT_EQ(cursor.KeyId(), -1);
+    EXPECT_EQ(cursor.matched_size(), 3);
+
+    cursor.Rewind(1);
+    EXPECT_FALSE(cursor.valid());
+    cursor.Rewind(1);
+    EXPECT_TRUE(cursor.IsKey());
+
+    EXPECT_TRUE(cursor.Seek(u8"chon"));
+    EXPECT_TRUE(cursor.IsKeyOrPrefix());
+    EXPECT_FALSE(cursor.IsKey());
+    EXPECT_TRUE(cursor.Seek(u8"ba"));
+    EXPECT_TRUE(cursor.IsKey());
+    EXPECT_EQ(cursor.KeyId(), 2);
+
+    cursor.Rewind(10);
+    EXPECT_EQ(cursor.text(), u8"");
+    EXPECT_TRUE(cursor.IsKeyOrPrefix());
+}
+
+TEST(FrozenTrieTest, matches_mutable_trie) {
+    auto words = std::vector<std::string>{"cho",  "cho2", "chong", "chong5", "chongthong2", "ba",
+                                          "niau", "nia",  "na",    "a",      "cho"};
+    auto frozen = Trie::CreateFrozen(words);
+    auto mutable_trie = Trie::Create();
+    mutable_trie->Insert(words);
+
+    for (auto query : {"", "c", "cho", "chon", "chong5", "chongthong2", "chongthong25", "nia", "x", "baxxx"}) {
+        EXPECT_EQ(frozen->HasKey(query), mutable_trie->HasKey(query)) << query;
+        EXPECT_EQ(frozen->HasKeyOrPrefix(query), mutable_trie->HasKeyOrPrefix(query)) << query;
+        EXPECT_EQ(frozen->StartsWithKey(query), mutable_trie->StartsWithKey(query)) << query;
+        EXPECT_EQ(frozen->LongestKeyOf(query), mutable_trie->LongestKeyOf(query)) << query;
+
+        auto frozen_keys = std::vector<std::string>();
+        auto mutable_keys = std::vector<std::string>();
+        frozen->FindKeys(query, frozen_keys);
+        mutable_trie->FindKeys(query, mutable_keys);
+        EXPECT_EQ(frozen_keys, mutable_keys) << query;
+
+        EXPECT_EQ(frozen->Autocomplete(query), mutable_trie->Autocomplete(query)) << query;
+
+        auto frozen_cursor = Trie::Cursor(frozen.get());
+        auto mutable_cursor = Trie::Cursor(mutable_trie.get());
+        frozen_cursor.Seek(query);
+        mutable_cursor.Seek(query);
+        EXPECT_EQ(frozen_cursor.IsKeyOrPrefix(), mutable_trie->HasKeyOrPrefix(query)) << query;
+        EXPECT_EQ(frozen_cursor.IsKey(), mutable_cursor.IsKey()) << query;
+        EXPECT_EQ(frozen_cursor.KeyId(), frozen->KeyId(query)) << query;
+        EXPECT_EQ(frozen_cursor.matched_size(), mutable_cursor.matched_size()) << query;
+        EXPECT_EQ(frozen->Autocomplete(query, 2, 3), mutable_trie->Autocomplete(query, 2, 3)) << query;
+        EXPECT_EQ(frozen->NextLetters(query), mutable_trie->NextLetters(query)) << query;
+    }
+}
+
+TEST(FrozenTrieTest, Multisplit) {
+    auto words = std::vector<std::string>{"the", "at", "me", "eat", "them", "meat", "theme"};
+    auto costs = std::vector<float>{1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f, 1.6f};
+    auto frozen = Trie::CreateFrozen(words);
+    auto mutable_trie = Trie::Create();
+    mutable_trie->Insert(words);
+
+    auto ret = frozen->Multisplit("themeat", costs, 5);
+    EXPECT_EQ(ret.size(), 4);
+    EXPECT_EQ(ret, mutable_trie->Multisplit("themeat", costs, 5));
+
+    for (size_t i = 0; i < words.size(); ++i) {
+        EXPECT_EQ(frozen->KeyId(words[i]), static_cast<int>(i));
+    }
+    EXPECT_EQ(frozen->KeyId("them2"), -1);
+}
+
+TEST(FrozenTrieTest, is_read_only) {
+    auto trie = Trie::CreateFrozen({"ba"});
+    trie->Insert("na");
+    EXPECT_FALSE(trie->HasKey("na"));
+    EXPECT_FALSE(trie->Remove("ba"));
+    EXPECT_TRUE(trie->HasKey("ba"));
+}
+
+TEST(FrozenTrieTest, map_compiled) {
+    auto data = Trie::CompileFrozen({"ba", "bah", "na"});
+    auto trie = Trie::MapFrozen(data);
+    ASSERT_NE(trie, nullptr);
+    EXPECT_TRUE(trie->HasKey("ba"));
+    EXPECT_TRUE(trie->HasKey("bah"));
+    EXPECT_TRUE(trie->HasKeyOrPrefix("n"));
+    EXPECT_FALSE(trie->HasKey("b"));
+
+    EXPECT_EQ(Trie::MapFrozen(""), nullptr);
+    EXPECT_EQ(Trie::MapFrozen(std::string_view(data).substr(0, data.size() - 1)), nullptr);
+}
+
+TEST(FrozenTrieTest, empty) {
+    auto trie = Trie::CreateFrozen({});
+    EXPECT_FALSE(trie->HasKey(""));
+    EXPECT_FALSE(trie->HasKeyOrPrefix("a"));
+    EXPECT_TRUE(trie->Autocomplete("").empty());
+}
+
 } // namespace
-} // namespace khiin::engine
\ No newline at end of file
+} // namespace khiin::engine
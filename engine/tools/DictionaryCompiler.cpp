@@ -0,0 +1,41 @@
+// Compiles a khiin database into a dictionary image, which the engine maps
+// at startup instead of rebuilding its tries from the database.
+//
+// Usage: khiin_dictc <khiin.db> [<output.dict>]
+//
+// The default output is next to the database with a .dict extension, which
+// is where the engine looks for it.
+
+#include <filesystem>
+#include <iostream>
+
+#include "Engine.h"
+#include "data/Dictionary.h"
+#include "data/DictionaryImage.h"
+
+int main(int argc, char *argv[]) {
+    using namespace khiin::engine;
+    namespace fs = std::filesystem;
+
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <khiin.db> [<output.dict>]\n";
+        return 2;
+    }
+
+    auto db_file = std::string(argv[1]);
+    if (!fs::exists(fs::u8path(db_file))) {
+        std::cerr << "Database not found: " << db_file << "\n";
+        return 1;
+    }
+
+    auto image_file = argc == 3 ? std::string(argv[2]) : DictionaryImage::ImageFileFor(db_file);
+    auto engine = Engine::Create(db_file);
+
+    if (!engine->dictionary()->CompileImage(image_file)) {
+        std::cerr << "Unable to write dictionary image: " << image_file << "\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << image_file << "\n";
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include "CommandArena.h"
+
+#include <cassert>
+
+namespace khiin::engine {
+
+CommandArena::Scope::Scope(CommandArena *arena) : m_arena(arena) {
+    if (m_arena != nullptr) {
+        ++m_arena->m_depth;
+    }
+}
+
+CommandArena::Scope::~Scope() {
+    if (m_arena == nullptr) {
+        return;
+    }
+
+    assert(m_arena->m_depth > 0);
+    if (--m_arena->m_depth == 0) {
+        m_arena->m_resource.release();
+    }
+}
+
+CommandArena::CommandArena(size_t block_size)
+    : m_block(std::make_unique<std::byte[]>(block_size)),
+      m_resource(m_block.get(), block_size, std::pmr::new_delete_resource()) {}
+
+std::pmr::memory_resource *CommandArena::resource() {
+    if (m_depth == 0) {
+        return std::pmr::get_default_resource();
+    }
+    return &m_resource;
+}
+
+bool CommandArena::active() const {
+    return m_depth != 0;
+}
+
+} // namespace khiin::engine
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace khiin::engine {
+
+// Scratch memory for the containers that only live while the engine handles
+// one command, such as the sets and lattices built while finding the
+// candidates for a keystroke. Allocating is a pointer bump into a block that
+// is kept between commands, and nothing is freed until the command is done.
+//
+// The arena is only used inside a Scope. Scopes may be nested, and all of the
+// memory is released when the outermost one closes. Outside of any scope,
+// resource() is the default heap, so that code called outside of a command
+// does not grow the arena. Not thread-safe: the engine only uses it while
+// holding its lock.
+class CommandArena {
+  public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    class Scope {
+      public:
+        explicit Scope(CommandArena *arena);
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+        ~Scope();
+
+      private:
+        CommandArena *m_arena = nullptr;
+    };
+
+    explicit CommandArena(size_t block_size = kDefaultBlockSize);
+    CommandArena(CommandArena const &) = delete;
+    CommandArena &operator=(CommandArena const &) = delete;
+
+    // Nothing allocated from it may outlive the outermost open scope
+    std::pmr::memory_resource *resource();
+
+    bool active() const;
+
+  private:
+    // Memory past the block comes from the heap until the next release
+    std::unique_ptr<std::byte[]> m_block;
+    std::pmr::monotonic_buffer_resource m_resource;
+    int m_depth = 0;
+};
+
+} // namespace khiin::engine
@@ -0,0 +1,132 @@
+#include "MappedFile.h"
+
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace khiin::engine {
+namespace {
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+
+class MappedFileImpl : public MappedFile {
+  public:
+    ~MappedFileImpl() override {
+        if (m_view != nullptr) {
+            ::UnmapViewOfFile(m_view);
+        }
+        if (m_mapping != nullptr) {
+            ::CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            ::CloseHandle(m_file);
+        }
+    }
+
+    bool Map(std::string const &file_path) {
+        m_file = ::CreateFileW(fs::u8path(file_path).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        auto size = LARGE_INTEGER();
+        if (::GetFileSizeEx(m_file, &size) == 0 || size.QuadPart == 0) {
+            return false;
+        }
+
+        m_mapping = ::CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            return false;
+        }
+
+        m_view = ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_view == nullptr) {
+            return false;
+        }
+
+        m_data = std::string_view(static_cast<char const *>(m_view), static_cast<size_t>(size.QuadPart));
+        return true;
+    }
+
+    std::string_view data() const override {
+        return m_data;
+    }
+
+  private:
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    void *m_view = nullptr;
+    std::string_view m_data;
+};
+
+#else
+
+class MappedFileImpl : public MappedFile {
+  public:
+    ~MappedFileImpl() override {
+        if (m_view != MAP_FAILED) {
+            ::munmap(m_view, m_data.size());
+        }
+        if (m_fd != -1) {
+            ::close(m_fd);
+        }
+    }
+
+    bool Map(std::string const &file_path) {
+        m_fd = ::open(file_path.c_str(), O_RDONLY);
+        if (m_fd == -1) {
+            return false;
+        }
+
+        struct stat st = {};
+        if (::fstat(m_fd, &st) != 0 || st.st_size == 0) {
+            return false;
+        }
+
+        auto size = static_cast<size_t>(st.st_size);
+        m_view = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (m_view == MAP_FAILED) {
+            return false;
+        }
+
+        m_data = std::string_view(static_cast<char const *>(m_view), size);
+        return true;
+    }
+
+    std::string_view data() const override {
+        return m_data;
+    }
+
+  private:
+    int m_fd = -1;
+    void *m_view = MAP_FAILED;
+    std::string_view m_data;
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<MappedFile> MappedFile::Open(std::string const &file_path) {
+    auto ret = std::make_unique<MappedFileImpl>();
+
+    if (!ret->Map(file_path)) {
+        return nullptr;
+    }
+
+    return ret;
+}
+
+} // namespace khiin::engine
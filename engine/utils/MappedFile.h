@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace khiin::engine {
+
+// A read-only view of a whole file mapped into memory. The view stays valid
+// until the MappedFile is destroyed.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+    virtual ~MappedFile() = default;
+
+    // Returns nullptr if the file does not exist, is empty, or cannot be mapped
+    static std::unique_ptr<MappedFile> Open(std::string const &file_path);
+
+    virtual std::string_view data() const = 0;
+};
+
+} // namespace khiin::engine
@@ -69,6 +69,7 @@ inline int bitscan_reverse(uint64_t x) {
 
 inline std::vector<int> bitpositions(uint64_t bb_ull) {
     auto ret = std::vector<int>();
+    ret.reserve(std::bitset<64>(bb_ull).count());
     while (bb_ull != 0) {
         auto pos = bitscan_forward(bb_ull);
         auto bits = std::bitset<64>(bb_ull);
@@ -120,6 +120,7 @@ PROTOBUF_CONSTEXPR Response::Response(
   , /*decltype(_impl_.edit_state_)*/0
   , /*decltype(_impl_.committed_)*/false
   , /*decltype(_impl_.consumable_)*/false
+  , /*decltype(_impl_.candidates_pending_)*/false
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct ResponseDefaultTypeInternal {
   PROTOBUF_CONSTEXPR ResponseDefaultTypeInternal()
@@ -390,19 +391,21 @@ bool CommandType_IsValid(int value) {
     case 12:
     case 13:
     case 14:
+    case 15:
       return true;
     default:
       return false;
   }
 }
 
-static ::PROTOBUF_NAMESPACE_ID::internal::ExplicitlyConstructed<std::string> CommandType_strings[15] = {};
+static ::PROTOBUF_NAMESPACE_ID::internal::ExplicitlyConstructed<std::string> CommandType_strings[16] = {};
 
 static const char CommandType_names[] =
   "CMD_COMMIT"
   "CMD_DISABLE"
   "CMD_ENABLE"
   "CMD_FOCUS_CANDIDATE"
+  "CMD_GET_CANDIDATES"
   "CMD_LIST_EMOJIS"
   "CMD_PLACE_CURSOR"
   "CMD_RESET"
@@ -420,35 +423,37 @@ static const ::PROTOBUF_NAMESPACE_ID::internal::EnumEntry CommandType_entries[]
   { {CommandType_names + 10, 11}, 9 },
   { {CommandType_names + 21, 10}, 10 },
   { {CommandType_names + 31, 19}, 6 },
-  { {CommandType_names + 50, 15}, 13 },
-  { {CommandType_names + 65, 16}, 8 },
-  { {CommandType_names + 81, 9}, 3 },
-  { {CommandType_names + 90, 19}, 14 },
-  { {CommandType_names + 109, 10}, 2 },
-  { {CommandType_names + 119, 20}, 5 },
-  { {CommandType_names + 139, 12}, 1 },
-  { {CommandType_names + 151, 14}, 11 },
-  { {CommandType_names + 165, 21}, 7 },
-  { {CommandType_names + 186, 17}, 12 },
-  { {CommandType_names + 203, 15}, 0 },
+  { {CommandType_names + 50, 18}, 15 },
+  { {CommandType_names + 68, 15}, 13 },
+  { {CommandType_names + 83, 16}, 8 },
+  { {CommandType_names + 99, 9}, 3 },
+  { {CommandType_names + 108, 19}, 14 },
+  { {CommandType_names + 127, 10}, 2 },
+  { {CommandType_names + 137, 20}, 5 },
+  { {CommandType_names + 157, 12}, 1 },
+  { {CommandType_names + 169, 14}, 11 },
+  { {CommandType_names + 183, 21}, 7 },
+  { {CommandType_names + 204, 17}, 12 },
+  { {CommandType_names + 221, 15}, 0 },
 };
 
 static const int CommandType_entries_by_number[] = {
-  14, // 0 -> CMD_UNSPECIFIED
-  10, // 1 -> CMD_SEND_KEY
-  8, // 2 -> CMD_REVERT
-  6, // 3 -> CMD_RESET
+  15, // 0 -> CMD_UNSPECIFIED
+  11, // 1 -> CMD_SEND_KEY
+  9, // 2 -> CMD_REVERT
+  7, // 3 -> CMD_RESET
   0, // 4 -> CMD_COMMIT
-  9, // 5 -> CMD_SELECT_CANDIDATE
+  10, // 5 -> CMD_SELECT_CANDIDATE
   3, // 6 -> CMD_FOCUS_CANDIDATE
-  12, // 7 -> CMD_SWITCH_INPUT_MODE
-  5, // 8 -> CMD_PLACE_CURSOR
+  13, // 7 -> CMD_SWITCH_INPUT_MODE
+  6, // 8 -> CMD_PLACE_CURSOR
   1, // 9 -> CMD_DISABLE
   2, // 10 -> CMD_ENABLE
-  11, // 11 -> CMD_SET_CONFIG
-  13, // 12 -> CMD_TEST_SEND_KEY
-  4, // 13 -> CMD_LIST_EMOJIS
-  7, // 14 -> CMD_RESET_USER_DATA
+  12, // 11 -> CMD_SET_CONFIG
+  14, // 12 -> CMD_TEST_SEND_KEY
+  5, // 13 -> CMD_LIST_EMOJIS
+  8, // 14 -> CMD_RESET_USER_DATA
+  4, // 15 -> CMD_GET_CANDIDATES
 };
 
 const std::string& CommandType_Name(
@@ -457,12 +462,12 @@ const std::string& CommandType_Name(
       ::PROTOBUF_NAMESPACE_ID::internal::InitializeEnumStrings(
           CommandType_entries,
           CommandType_entries_by_number,
-          15, CommandType_strings);
+          16, CommandType_strings);
   (void) dummy;
   int idx = ::PROTOBUF_NAMESPACE_ID::internal::LookUpEnumName(
       CommandType_entries,
       CommandType_entries_by_number,
-      15, value);
+      16, value);
   return idx == -1 ? ::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString() :
                      CommandType_strings[idx].get();
 }
@@ -470,7 +475,7 @@ bool CommandType_Parse(
     ::PROTOBUF_NAMESPACE_ID::ConstStringParam name, CommandType* value) {
   int int_value;
   bool success = ::PROTOBUF_NAMESPACE_ID::internal::LookUpEnumValue(
-      CommandType_entries, 15, name, &int_value);
+      CommandType_entries, 16, name, &int_value);
   if (success) {
     *value = static_cast<CommandType>(int_value);
   }
@@ -2332,6 +2337,7 @@ Response::Response(const Response& from)
     , decltype(_impl_.edit_state_){}
     , decltype(_impl_.committed_){}
     , decltype(_impl_.consumable_){}
+    , decltype(_impl_.candidates_pending_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
@@ -2342,8 +2348,8 @@ Response::Response(const Response& from)
     _this->_impl_.candidate_list_ = new ::khiin::proto::CandidateList(*from._impl_.candidate_list_);
   }
   ::memcpy(&_impl_.error_, &from._impl_.error_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.consumable_) -
-    reinterpret_cast<char*>(&_impl_.error_)) + sizeof(_impl_.consumable_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.candidates_pending_) -
+    reinterpret_cast<char*>(&_impl_.error_)) + sizeof(_impl_.candidates_pending_));
   // @@protoc_insertion_point(copy_constructor:khiin.proto.Response)
 }
 
@@ -2358,6 +2364,7 @@ inline void Response::SharedCtor(
     , decltype(_impl_.edit_state_){0}
     , decltype(_impl_.committed_){false}
     , decltype(_impl_.consumable_){false}
+    , decltype(_impl_.candidates_pending_){false}
     , /*decltype(_impl_._cached_size_)*/{}
   };
 }
@@ -2396,8 +2403,8 @@ void Response::Clear() {
   }
   _impl_.candidate_list_ = nullptr;
   ::memset(&_impl_.error_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.consumable_) -
-      reinterpret_cast<char*>(&_impl_.error_)) + sizeof(_impl_.consumable_));
+      reinterpret_cast<char*>(&_impl_.candidates_pending_) -
+      reinterpret_cast<char*>(&_impl_.error_)) + sizeof(_impl_.candidates_pending_));
   _internal_metadata_.Clear<std::string>();
 }
 
@@ -2457,6 +2464,14 @@ const char* Response::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx)
         } else
           goto handle_unusual;
         continue;
+      // bool candidates_pending = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _impl_.candidates_pending_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -2526,6 +2541,12 @@ uint8_t* Response::_InternalSerialize(
     target = ::_pbi::WireFormatLite::WriteBoolToArray(6, this->_internal_consumable(), target);
   }
 
+  // bool candidates_pending = 7;
+  if (this->_internal_candidates_pending() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(7, this->_internal_candidates_pending(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = stream->WriteRaw(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).data(),
         static_cast<int>(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size()), target);
@@ -2578,6 +2599,11 @@ size_t Response::ByteSizeLong() const {
     total_size += 1 + 1;
   }
 
+  // bool candidates_pending = 7;
+  if (this->_internal_candidates_pending() != 0) {
+    total_size += 1 + 1;
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     total_size += _internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size();
   }
@@ -2619,6 +2645,9 @@ void Response::MergeFrom(const Response& from) {
   if (from._internal_consumable() != 0) {
     _this->_internal_set_consumable(from._internal_consumable());
   }
+  if (from._internal_candidates_pending() != 0) {
+    _this->_internal_set_candidates_pending(from._internal_candidates_pending());
+  }
   _this->_internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
 }
 
@@ -2637,8 +2666,8 @@ void Response::InternalSwap(Response* other) {
   using std::swap;
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(Response, _impl_.consumable_)
-      + sizeof(Response::_impl_.consumable_)
+      PROTOBUF_FIELD_OFFSET(Response, _impl_.candidates_pending_)
+      + sizeof(Response::_impl_.candidates_pending_)
       - PROTOBUF_FIELD_OFFSET(Response, _impl_.preedit_)>(
           reinterpret_cast<char*>(&_impl_.preedit_),
           reinterpret_cast<char*>(&other->_impl_.preedit_));
@@ -179,12 +179,13 @@ enum CommandType : int {
   CMD_TEST_SEND_KEY = 12,
   CMD_LIST_EMOJIS = 13,
   CMD_RESET_USER_DATA = 14,
+  CMD_GET_CANDIDATES = 15,
   CommandType_INT_MIN_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::min(),
   CommandType_INT_MAX_SENTINEL_DO_NOT_USE_ = std::numeric_limits<int32_t>::max()
 };
 bool CommandType_IsValid(int value);
 constexpr CommandType CommandType_MIN = CMD_UNSPECIFIED;
-constexpr CommandType CommandType_MAX = CMD_RESET_USER_DATA;
+constexpr CommandType CommandType_MAX = CMD_GET_CANDIDATES;
 constexpr int CommandType_ARRAYSIZE = CommandType_MAX + 1;
 
 const std::string& CommandType_Name(CommandType value);
@@ -1404,6 +1405,7 @@ class Response final :
     kEditStateFieldNumber = 4,
     kCommittedFieldNumber = 5,
     kConsumableFieldNumber = 6,
+    kCandidatesPendingFieldNumber = 7,
   };
   // .khiin.proto.Preedit preedit = 2;
   bool has_preedit() const;
@@ -1477,6 +1479,15 @@ class Response final :
   void _internal_set_consumable(bool value);
   public:
 
+  // bool candidates_pending = 7;
+  void clear_candidates_pending();
+  bool candidates_pending() const;
+  void set_candidates_pending(bool value);
+  private:
+  bool _internal_candidates_pending() const;
+  void _internal_set_candidates_pending(bool value);
+  public:
+
   // @@protoc_insertion_point(class_scope:khiin.proto.Response)
  private:
   class _Internal;
@@ -1491,6 +1502,7 @@ class Response final :
     int edit_state_;
     bool committed_;
     bool consumable_;
+    bool candidates_pending_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -2668,6 +2680,26 @@ inline void Response::set_consumable(bool value) {
   // @@protoc_insertion_point(field_set:khiin.proto.Response.consumable)
 }
 
+// bool candidates_pending = 7;
+inline void Response::clear_candidates_pending() {
+  _impl_.candidates_pending_ = false;
+}
+inline bool Response::_internal_candidates_pending() const {
+  return _impl_.candidates_pending_;
+}
+inline bool Response::candidates_pending() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.Response.candidates_pending)
+  return _internal_candidates_pending();
+}
+inline void Response::_internal_set_candidates_pending(bool value) {
+  
+  _impl_.candidates_pending_ = value;
+}
+inline void Response::set_candidates_pending(bool value) {
+  _internal_set_candidates_pending(value);
+  // @@protoc_insertion_point(field_set:khiin.proto.Response.candidates_pending)
+}
+
 // -------------------------------------------------------------------
 
 // Command
@@ -67,8 +67,13 @@ PROTOBUF_CONSTEXPR AppConfig::AppConfig(
   , /*decltype(_impl_.autokhin_)*/nullptr
   , /*decltype(_impl_.easy_ch_)*/nullptr
   , /*decltype(_impl_.uppercase_nasal_)*/nullptr
+  , /*decltype(_impl_.deferred_candidates_)*/nullptr
+  , /*decltype(_impl_.prefetch_candidates_)*/nullptr
   , /*decltype(_impl_.input_mode_)*/0
   , /*decltype(_impl_.default_punctuation_)*/0
+  , /*decltype(_impl_.prefetch_budget_ms_)*/0u
+  , /*decltype(_impl_.sentence_beam_width_)*/0u
+  , /*decltype(_impl_.sentence_max_results_)*/0u
   , /*decltype(_impl_._cached_size_)*/{}} {}
 struct AppConfigDefaultTypeInternal {
   PROTOBUF_CONSTEXPR AppConfigDefaultTypeInternal()
@@ -1232,6 +1237,8 @@ class AppConfig::_Internal {
   static const ::khiin::proto::BoolValue& autokhin(const AppConfig* msg);
   static const ::khiin::proto::BoolValue& easy_ch(const AppConfig* msg);
   static const ::khiin::proto::BoolValue& uppercase_nasal(const AppConfig* msg);
+  static const ::khiin::proto::BoolValue& deferred_candidates(const AppConfig* msg);
+  static const ::khiin::proto::BoolValue& prefetch_candidates(const AppConfig* msg);
 };
 
 const ::khiin::proto::BoolValue&
@@ -1262,6 +1269,14 @@ const ::khiin::proto::BoolValue&
 AppConfig::_Internal::uppercase_nasal(const AppConfig* msg) {
   return *msg->_impl_.uppercase_nasal_;
 }
+const ::khiin::proto::BoolValue&
+AppConfig::_Internal::deferred_candidates(const AppConfig* msg) {
+  return *msg->_impl_.deferred_candidates_;
+}
+const ::khiin::proto::BoolValue&
+AppConfig::_Internal::prefetch_candidates(const AppConfig* msg) {
+  return *msg->_impl_.prefetch_candidates_;
+}
 AppConfig::AppConfig(::PROTOBUF_NAMESPACE_ID::Arena* arena,
                          bool is_message_owned)
   : ::PROTOBUF_NAMESPACE_ID::MessageLite(arena, is_message_owned) {
@@ -1279,8 +1294,13 @@ AppConfig::AppConfig(const AppConfig& from)
     , decltype(_impl_.autokhin_){nullptr}
     , decltype(_impl_.easy_ch_){nullptr}
     , decltype(_impl_.uppercase_nasal_){nullptr}
+    , decltype(_impl_.deferred_candidates_){nullptr}
+    , decltype(_impl_.prefetch_candidates_){nullptr}
     , decltype(_impl_.input_mode_){}
     , decltype(_impl_.default_punctuation_){}
+    , decltype(_impl_.prefetch_budget_ms_){}
+    , decltype(_impl_.sentence_beam_width_){}
+    , decltype(_impl_.sentence_max_results_){}
     , /*decltype(_impl_._cached_size_)*/{}};
 
   _internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
@@ -1305,9 +1325,15 @@ AppConfig::AppConfig(const AppConfig& from)
   if (from._internal_has_uppercase_nasal()) {
     _this->_impl_.uppercase_nasal_ = new ::khiin::proto::BoolValue(*from._impl_.uppercase_nasal_);
   }
+  if (from._internal_has_deferred_candidates()) {
+    _this->_impl_.deferred_candidates_ = new ::khiin::proto::BoolValue(*from._impl_.deferred_candidates_);
+  }
+  if (from._internal_has_prefetch_candidates()) {
+    _this->_impl_.prefetch_candidates_ = new ::khiin::proto::BoolValue(*from._impl_.prefetch_candidates_);
+  }
   ::memcpy(&_impl_.input_mode_, &from._impl_.input_mode_,
-    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.default_punctuation_) -
-    reinterpret_cast<char*>(&_impl_.input_mode_)) + sizeof(_impl_.default_punctuation_));
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.sentence_max_results_) -
+    reinterpret_cast<char*>(&_impl_.input_mode_)) + sizeof(_impl_.sentence_max_results_));
   // @@protoc_insertion_point(copy_constructor:khiin.proto.AppConfig)
 }
 
@@ -1323,8 +1349,13 @@ inline void AppConfig::SharedCtor(
     , decltype(_impl_.autokhin_){nullptr}
     , decltype(_impl_.easy_ch_){nullptr}
     , decltype(_impl_.uppercase_nasal_){nullptr}
+    , decltype(_impl_.deferred_candidates_){nullptr}
+    , decltype(_impl_.prefetch_candidates_){nullptr}
     , decltype(_impl_.input_mode_){0}
     , decltype(_impl_.default_punctuation_){0}
+    , decltype(_impl_.prefetch_budget_ms_){0u}
+    , decltype(_impl_.sentence_beam_width_){0u}
+    , decltype(_impl_.sentence_max_results_){0u}
     , /*decltype(_impl_._cached_size_)*/{}
   };
 }
@@ -1347,6 +1378,8 @@ inline void AppConfig::SharedDtor() {
   if (this != internal_default_instance()) delete _impl_.autokhin_;
   if (this != internal_default_instance()) delete _impl_.easy_ch_;
   if (this != internal_default_instance()) delete _impl_.uppercase_nasal_;
+  if (this != internal_default_instance()) delete _impl_.deferred_candidates_;
+  if (this != internal_default_instance()) delete _impl_.prefetch_candidates_;
 }
 
 void AppConfig::SetCachedSize(int size) const {
@@ -1387,9 +1420,17 @@ void AppConfig::Clear() {
     delete _impl_.uppercase_nasal_;
   }
   _impl_.uppercase_nasal_ = nullptr;
+  if (GetArenaForAllocation() == nullptr && _impl_.deferred_candidates_ != nullptr) {
+    delete _impl_.deferred_candidates_;
+  }
+  _impl_.deferred_candidates_ = nullptr;
+  if (GetArenaForAllocation() == nullptr && _impl_.prefetch_candidates_ != nullptr) {
+    delete _impl_.prefetch_candidates_;
+  }
+  _impl_.prefetch_candidates_ = nullptr;
   ::memset(&_impl_.input_mode_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&_impl_.default_punctuation_) -
-      reinterpret_cast<char*>(&_impl_.input_mode_)) + sizeof(_impl_.default_punctuation_));
+      reinterpret_cast<char*>(&_impl_.sentence_max_results_) -
+      reinterpret_cast<char*>(&_impl_.input_mode_)) + sizeof(_impl_.sentence_max_results_));
   _internal_metadata_.Clear<std::string>();
 }
 
@@ -1473,6 +1514,46 @@ const char* AppConfig::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx
         } else
           goto handle_unusual;
         continue;
+      // .khiin.proto.BoolValue deferred_candidates = 10;
+      case 10:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 82)) {
+          ptr = ctx->ParseMessage(_internal_mutable_deferred_candidates(), ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // .khiin.proto.BoolValue prefetch_candidates = 11;
+      case 11:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 90)) {
+          ptr = ctx->ParseMessage(_internal_mutable_prefetch_candidates(), ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 prefetch_budget_ms = 12;
+      case 12:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 96)) {
+          _impl_.prefetch_budget_ms_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 sentence_beam_width = 13;
+      case 13:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 104)) {
+          _impl_.sentence_beam_width_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // uint32 sentence_max_results = 14;
+      case 14:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 112)) {
+          _impl_.sentence_max_results_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -1565,6 +1646,38 @@ uint8_t* AppConfig::_InternalSerialize(
         _Internal::uppercase_nasal(this).GetCachedSize(), target, stream);
   }
 
+  // .khiin.proto.BoolValue deferred_candidates = 10;
+  if (this->_internal_has_deferred_candidates()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessage(10, _Internal::deferred_candidates(this),
+        _Internal::deferred_candidates(this).GetCachedSize(), target, stream);
+  }
+
+  // .khiin.proto.BoolValue prefetch_candidates = 11;
+  if (this->_internal_has_prefetch_candidates()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessage(11, _Internal::prefetch_candidates(this),
+        _Internal::prefetch_candidates(this).GetCachedSize(), target, stream);
+  }
+
+  // uint32 prefetch_budget_ms = 12;
+  if (this->_internal_prefetch_budget_ms() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(12, this->_internal_prefetch_budget_ms(), target);
+  }
+
+  // uint32 sentence_beam_width = 13;
+  if (this->_internal_sentence_beam_width() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(13, this->_internal_sentence_beam_width(), target);
+  }
+
+  // uint32 sentence_max_results = 14;
+  if (this->_internal_sentence_max_results() != 0) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(14, this->_internal_sentence_max_results(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = stream->WriteRaw(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).data(),
         static_cast<int>(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size()), target);
@@ -1630,6 +1743,20 @@ size_t AppConfig::ByteSizeLong() const {
         *_impl_.uppercase_nasal_);
   }
 
+  // .khiin.proto.BoolValue deferred_candidates = 10;
+  if (this->_internal_has_deferred_candidates()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+        *_impl_.deferred_candidates_);
+  }
+
+  // .khiin.proto.BoolValue prefetch_candidates = 11;
+  if (this->_internal_has_prefetch_candidates()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+        *_impl_.prefetch_candidates_);
+  }
+
   // .khiin.proto.InputMode input_mode = 3;
   if (this->_internal_input_mode() != 0) {
     total_size += 1 +
@@ -1642,6 +1769,21 @@ size_t AppConfig::ByteSizeLong() const {
       ::_pbi::WireFormatLite::EnumSize(this->_internal_default_punctuation());
   }
 
+  // uint32 prefetch_budget_ms = 12;
+  if (this->_internal_prefetch_budget_ms() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_prefetch_budget_ms());
+  }
+
+  // uint32 sentence_beam_width = 13;
+  if (this->_internal_sentence_beam_width() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_sentence_beam_width());
+  }
+
+  // uint32 sentence_max_results = 14;
+  if (this->_internal_sentence_max_results() != 0) {
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_sentence_max_results());
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     total_size += _internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size();
   }
@@ -1691,12 +1833,29 @@ void AppConfig::MergeFrom(const AppConfig& from) {
     _this->_internal_mutable_uppercase_nasal()->::khiin::proto::BoolValue::MergeFrom(
         from._internal_uppercase_nasal());
   }
+  if (from._internal_has_deferred_candidates()) {
+    _this->_internal_mutable_deferred_candidates()->::khiin::proto::BoolValue::MergeFrom(
+        from._internal_deferred_candidates());
+  }
+  if (from._internal_has_prefetch_candidates()) {
+    _this->_internal_mutable_prefetch_candidates()->::khiin::proto::BoolValue::MergeFrom(
+        from._internal_prefetch_candidates());
+  }
   if (from._internal_input_mode() != 0) {
     _this->_internal_set_input_mode(from._internal_input_mode());
   }
   if (from._internal_default_punctuation() != 0) {
     _this->_internal_set_default_punctuation(from._internal_default_punctuation());
   }
+  if (from._internal_prefetch_budget_ms() != 0) {
+    _this->_internal_set_prefetch_budget_ms(from._internal_prefetch_budget_ms());
+  }
+  if (from._internal_sentence_beam_width() != 0) {
+    _this->_internal_set_sentence_beam_width(from._internal_sentence_beam_width());
+  }
+  if (from._internal_sentence_max_results() != 0) {
+    _this->_internal_set_sentence_max_results(from._internal_sentence_max_results());
+  }
   _this->_internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
 }
 
@@ -1715,8 +1874,8 @@ void AppConfig::InternalSwap(AppConfig* other) {
   using std::swap;
   _internal_metadata_.InternalSwap(&other->_internal_metadata_);
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(AppConfig, _impl_.default_punctuation_)
-      + sizeof(AppConfig::_impl_.default_punctuation_)
+      PROTOBUF_FIELD_OFFSET(AppConfig, _impl_.sentence_max_results_)
+      + sizeof(AppConfig::_impl_.sentence_max_results_)
       - PROTOBUF_FIELD_OFFSET(AppConfig, _impl_.ime_enabled_)>(
           reinterpret_cast<char*>(&_impl_.ime_enabled_),
           reinterpret_cast<char*>(&other->_impl_.ime_enabled_));
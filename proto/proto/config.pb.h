@@ -701,8 +701,13 @@ class AppConfig final :
     kAutokhinFieldNumber = 6,
     kEasyChFieldNumber = 8,
     kUppercaseNasalFieldNumber = 9,
+    kDeferredCandidatesFieldNumber = 10,
+    kPrefetchCandidatesFieldNumber = 11,
     kInputModeFieldNumber = 3,
     kDefaultPunctuationFieldNumber = 7,
+    kPrefetchBudgetMsFieldNumber = 12,
+    kSentenceBeamWidthFieldNumber = 13,
+    kSentenceMaxResultsFieldNumber = 14,
   };
   // .khiin.proto.BoolValue ime_enabled = 1;
   bool has_ime_enabled() const;
@@ -830,6 +835,42 @@ class AppConfig final :
       ::khiin::proto::BoolValue* uppercase_nasal);
   ::khiin::proto::BoolValue* unsafe_arena_release_uppercase_nasal();
 
+  // .khiin.proto.BoolValue deferred_candidates = 10;
+  bool has_deferred_candidates() const;
+  private:
+  bool _internal_has_deferred_candidates() const;
+  public:
+  void clear_deferred_candidates();
+  const ::khiin::proto::BoolValue& deferred_candidates() const;
+  PROTOBUF_NODISCARD ::khiin::proto::BoolValue* release_deferred_candidates();
+  ::khiin::proto::BoolValue* mutable_deferred_candidates();
+  void set_allocated_deferred_candidates(::khiin::proto::BoolValue* deferred_candidates);
+  private:
+  const ::khiin::proto::BoolValue& _internal_deferred_candidates() const;
+  ::khiin::proto::BoolValue* _internal_mutable_deferred_candidates();
+  public:
+  void unsafe_arena_set_allocated_deferred_candidates(
+      ::khiin::proto::BoolValue* deferred_candidates);
+  ::khiin::proto::BoolValue* unsafe_arena_release_deferred_candidates();
+
+  // .khiin.proto.BoolValue prefetch_candidates = 11;
+  bool has_prefetch_candidates() const;
+  private:
+  bool _internal_has_prefetch_candidates() const;
+  public:
+  void clear_prefetch_candidates();
+  const ::khiin::proto::BoolValue& prefetch_candidates() const;
+  PROTOBUF_NODISCARD ::khiin::proto::BoolValue* release_prefetch_candidates();
+  ::khiin::proto::BoolValue* mutable_prefetch_candidates();
+  void set_allocated_prefetch_candidates(::khiin::proto::BoolValue* prefetch_candidates);
+  private:
+  const ::khiin::proto::BoolValue& _internal_prefetch_candidates() const;
+  ::khiin::proto::BoolValue* _internal_mutable_prefetch_candidates();
+  public:
+  void unsafe_arena_set_allocated_prefetch_candidates(
+      ::khiin::proto::BoolValue* prefetch_candidates);
+  ::khiin::proto::BoolValue* unsafe_arena_release_prefetch_candidates();
+
   // .khiin.proto.InputMode input_mode = 3;
   void clear_input_mode();
   ::khiin::proto::InputMode input_mode() const;
@@ -848,6 +889,33 @@ class AppConfig final :
   void _internal_set_default_punctuation(::khiin::proto::DefaultPunctuation value);
   public:
 
+  // uint32 prefetch_budget_ms = 12;
+  void clear_prefetch_budget_ms();
+  uint32_t prefetch_budget_ms() const;
+  void set_prefetch_budget_ms(uint32_t value);
+  private:
+  uint32_t _internal_prefetch_budget_ms() const;
+  void _internal_set_prefetch_budget_ms(uint32_t value);
+  public:
+
+  // uint32 sentence_beam_width = 13;
+  void clear_sentence_beam_width();
+  uint32_t sentence_beam_width() const;
+  void set_sentence_beam_width(uint32_t value);
+  private:
+  uint32_t _internal_sentence_beam_width() const;
+  void _internal_set_sentence_beam_width(uint32_t value);
+  public:
+
+  // uint32 sentence_max_results = 14;
+  void clear_sentence_max_results();
+  uint32_t sentence_max_results() const;
+  void set_sentence_max_results(uint32_t value);
+  private:
+  uint32_t _internal_sentence_max_results() const;
+  void _internal_set_sentence_max_results(uint32_t value);
+  public:
+
   // @@protoc_insertion_point(class_scope:khiin.proto.AppConfig)
  private:
   class _Internal;
@@ -863,8 +931,13 @@ class AppConfig final :
     ::khiin::proto::BoolValue* autokhin_;
     ::khiin::proto::BoolValue* easy_ch_;
     ::khiin::proto::BoolValue* uppercase_nasal_;
+    ::khiin::proto::BoolValue* deferred_candidates_;
+    ::khiin::proto::BoolValue* prefetch_candidates_;
     int input_mode_;
     int default_punctuation_;
+    uint32_t prefetch_budget_ms_;
+    uint32_t sentence_beam_width_;
+    uint32_t sentence_max_results_;
     mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   };
   union { Impl_ _impl_; };
@@ -2359,6 +2432,246 @@ inline void AppConfig::set_allocated_uppercase_nasal(::khiin::proto::BoolValue*
   // @@protoc_insertion_point(field_set_allocated:khiin.proto.AppConfig.uppercase_nasal)
 }
 
+// .khiin.proto.BoolValue deferred_candidates = 10;
+inline bool AppConfig::_internal_has_deferred_candidates() const {
+  return this != internal_default_instance() && _impl_.deferred_candidates_ != nullptr;
+}
+inline bool AppConfig::has_deferred_candidates() const {
+  return _internal_has_deferred_candidates();
+}
+inline void AppConfig::clear_deferred_candidates() {
+  if (GetArenaForAllocation() == nullptr && _impl_.deferred_candidates_ != nullptr) {
+    delete _impl_.deferred_candidates_;
+  }
+  _impl_.deferred_candidates_ = nullptr;
+}
+inline const ::khiin::proto::BoolValue& AppConfig::_internal_deferred_candidates() const {
+  const ::khiin::proto::BoolValue* p = _impl_.deferred_candidates_;
+  return p != nullptr ? *p : reinterpret_cast<const ::khiin::proto::BoolValue&>(
+      ::khiin::proto::_BoolValue_default_instance_);
+}
+inline const ::khiin::proto::BoolValue& AppConfig::deferred_candidates() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.AppConfig.deferred_candidates)
+  return _internal_deferred_candidates();
+}
+inline void AppConfig::unsafe_arena_set_allocated_deferred_candidates(
+    ::khiin::proto::BoolValue* deferred_candidates) {
+  if (GetArenaForAllocation() == nullptr) {
+    delete reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(_impl_.deferred_candidates_);
+  }
+  _impl_.deferred_candidates_ = deferred_candidates;
+  if (deferred_candidates) {
+    
+  } else {
+    
+  }
+  // @@protoc_insertion_point(field_unsafe_arena_set_allocated:khiin.proto.AppConfig.deferred_candidates)
+}
+inline ::khiin::proto::BoolValue* AppConfig::release_deferred_candidates() {
+  
+  ::khiin::proto::BoolValue* temp = _impl_.deferred_candidates_;
+  _impl_.deferred_candidates_ = nullptr;
+#ifdef PROTOBUF_FORCE_COPY_IN_RELEASE
+  auto* old =  reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(temp);
+  temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  if (GetArenaForAllocation() == nullptr) { delete old; }
+#else  // PROTOBUF_FORCE_COPY_IN_RELEASE
+  if (GetArenaForAllocation() != nullptr) {
+    temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  }
+#endif  // !PROTOBUF_FORCE_COPY_IN_RELEASE
+  return temp;
+}
+inline ::khiin::proto::BoolValue* AppConfig::unsafe_arena_release_deferred_candidates() {
+  // @@protoc_insertion_point(field_release:khiin.proto.AppConfig.deferred_candidates)
+  
+  ::khiin::proto::BoolValue* temp = _impl_.deferred_candidates_;
+  _impl_.deferred_candidates_ = nullptr;
+  return temp;
+}
+inline ::khiin::proto::BoolValue* AppConfig::_internal_mutable_deferred_candidates() {
+  
+  if (_impl_.deferred_candidates_ == nullptr) {
+    auto* p = CreateMaybeMessage<::khiin::proto::BoolValue>(GetArenaForAllocation());
+    _impl_.deferred_candidates_ = p;
+  }
+  return _impl_.deferred_candidates_;
+}
+inline ::khiin::proto::BoolValue* AppConfig::mutable_deferred_candidates() {
+  ::khiin::proto::BoolValue* _msg = _internal_mutable_deferred_candidates();
+  // @@protoc_insertion_point(field_mutable:khiin.proto.AppConfig.deferred_candidates)
+  return _msg;
+}
+inline void AppConfig::set_allocated_deferred_candidates(::khiin::proto::BoolValue* deferred_candidates) {
+  ::PROTOBUF_NAMESPACE_ID::Arena* message_arena = GetArenaForAllocation();
+  if (message_arena == nullptr) {
+    delete _impl_.deferred_candidates_;
+  }
+  if (deferred_candidates) {
+    ::PROTOBUF_NAMESPACE_ID::Arena* submessage_arena =
+        ::PROTOBUF_NAMESPACE_ID::Arena::InternalGetOwningArena(deferred_candidates);
+    if (message_arena != submessage_arena) {
+      deferred_candidates = ::PROTOBUF_NAMESPACE_ID::internal::GetOwnedMessage(
+          message_arena, deferred_candidates, submessage_arena);
+    }
+    
+  } else {
+    
+  }
+  _impl_.deferred_candidates_ = deferred_candidates;
+  // @@protoc_insertion_point(field_set_allocated:khiin.proto.AppConfig.deferred_candidates)
+}
+
+// .khiin.proto.BoolValue prefetch_candidates = 11;
+inline bool AppConfig::_internal_has_prefetch_candidates() const {
+  return this != internal_default_instance() && _impl_.prefetch_candidates_ != nullptr;
+}
+inline bool AppConfig::has_prefetch_candidates() const {
+  return _internal_has_prefetch_candidates();
+}
+inline void AppConfig::clear_prefetch_candidates() {
+  if (GetArenaForAllocation() == nullptr && _impl_.prefetch_candidates_ != nullptr) {
+    delete _impl_.prefetch_candidates_;
+  }
+  _impl_.prefetch_candidates_ = nullptr;
+}
+inline const ::khiin::proto::BoolValue& AppConfig::_internal_prefetch_candidates() const {
+  const ::khiin::proto::BoolValue* p = _impl_.prefetch_candidates_;
+  return p != nullptr ? *p : reinterpret_cast<const ::khiin::proto::BoolValue&>(
+      ::khiin::proto::_BoolValue_default_instance_);
+}
+inline const ::khiin::proto::BoolValue& AppConfig::prefetch_candidates() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.AppConfig.prefetch_candidates)
+  return _internal_prefetch_candidates();
+}
+inline void AppConfig::unsafe_arena_set_allocated_prefetch_candidates(
+    ::khiin::proto::BoolValue* prefetch_candidates) {
+  if (GetArenaForAllocation() == nullptr) {
+    delete reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(_impl_.prefetch_candidates_);
+  }
+  _impl_.prefetch_candidates_ = prefetch_candidates;
+  if (prefetch_candidates) {
+    
+  } else {
+    
+  }
+  // @@protoc_insertion_point(field_unsafe_arena_set_allocated:khiin.proto.AppConfig.prefetch_candidates)
+}
+inline ::khiin::proto::BoolValue* AppConfig::release_prefetch_candidates() {
+  
+  ::khiin::proto::BoolValue* temp = _impl_.prefetch_candidates_;
+  _impl_.prefetch_candidates_ = nullptr;
+#ifdef PROTOBUF_FORCE_COPY_IN_RELEASE
+  auto* old =  reinterpret_cast<::PROTOBUF_NAMESPACE_ID::MessageLite*>(temp);
+  temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  if (GetArenaForAllocation() == nullptr) { delete old; }
+#else  // PROTOBUF_FORCE_COPY_IN_RELEASE
+  if (GetArenaForAllocation() != nullptr) {
+    temp = ::PROTOBUF_NAMESPACE_ID::internal::DuplicateIfNonNull(temp);
+  }
+#endif  // !PROTOBUF_FORCE_COPY_IN_RELEASE
+  return temp;
+}
+inline ::khiin::proto::BoolValue* AppConfig::unsafe_arena_release_prefetch_candidates() {
+  // @@protoc_insertion_point(field_release:khiin.proto.AppConfig.prefetch_candidates)
+  
+  ::khiin::proto::BoolValue* temp = _impl_.prefetch_candidates_;
+  _impl_.prefetch_candidates_ = nullptr;
+  return temp;
+}
+inline ::khiin::proto::BoolValue* AppConfig::_internal_mutable_prefetch_candidates() {
+  
+  if (_impl_.prefetch_candidates_ == nullptr) {
+    auto* p = CreateMaybeMessage<::khiin::proto::BoolValue>(GetArenaForAllocation());
+    _impl_.prefetch_candidates_ = p;
+  }
+  return _impl_.prefetch_candidates_;
+}
+inline ::khiin::proto::BoolValue* AppConfig::mutable_prefetch_candidates() {
+  ::khiin::proto::BoolValue* _msg = _internal_mutable_prefetch_candidates();
+  // @@protoc_insertion_point(field_mutable:khiin.proto.AppConfig.prefetch_candidates)
+  return _msg;
+}
+inline void AppConfig::set_allocated_prefetch_candidates(::khiin::proto::BoolValue* prefetch_candidates) {
+  ::PROTOBUF_NAMESPACE_ID::Arena* message_arena = GetArenaForAllocation();
+  if (message_arena == nullptr) {
+    delete _impl_.prefetch_candidates_;
+  }
+  if (prefetch_candidates) {
+    ::PROTOBUF_NAMESPACE_ID::Arena* submessage_arena =
+        ::PROTOBUF_NAMESPACE_ID::Arena::InternalGetOwningArena(prefetch_candidates);
+    if (message_arena != submessage_arena) {
+      prefetch_candidates = ::PROTOBUF_NAMESPACE_ID::internal::GetOwnedMessage(
+          message_arena, prefetch_candidates, submessage_arena);
+    }
+    
+  } else {
+    
+  }
+  _impl_.prefetch_candidates_ = prefetch_candidates;
+  // @@protoc_insertion_point(field_set_allocated:khiin.proto.AppConfig.prefetch_candidates)
+}
+
+// uint32 prefetch_budget_ms = 12;
+inline void AppConfig::clear_prefetch_budget_ms() {
+  _impl_.prefetch_budget_ms_ = 0u;
+}
+inline uint32_t AppConfig::_internal_prefetch_budget_ms() const {
+  return _impl_.prefetch_budget_ms_;
+}
+inline uint32_t AppConfig::prefetch_budget_ms() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.AppConfig.prefetch_budget_ms)
+  return _internal_prefetch_budget_ms();
+}
+inline void AppConfig::_internal_set_prefetch_budget_ms(uint32_t value) {
+  
+  _impl_.prefetch_budget_ms_ = value;
+}
+inline void AppConfig::set_prefetch_budget_ms(uint32_t value) {
+  _internal_set_prefetch_budget_ms(value);
+  // @@protoc_insertion_point(field_set:khiin.proto.AppConfig.prefetch_budget_ms)
+}
+
+// uint32 sentence_beam_width = 13;
+inline void AppConfig::clear_sentence_beam_width() {
+  _impl_.sentence_beam_width_ = 0u;
+}
+inline uint32_t AppConfig::_internal_sentence_beam_width() const {
+  return _impl_.sentence_beam_width_;
+}
+inline uint32_t AppConfig::sentence_beam_width() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.AppConfig.sentence_beam_width)
+  return _internal_sentence_beam_width();
+}
+inline void AppConfig::_internal_set_sentence_beam_width(uint32_t value) {
+  
+  _impl_.sentence_beam_width_ = value;
+}
+inline void AppConfig::set_sentence_beam_width(uint32_t value) {
+  _internal_set_sentence_beam_width(value);
+  // @@protoc_insertion_point(field_set:khiin.proto.AppConfig.sentence_beam_width)
+}
+
+// uint32 sentence_max_results = 14;
+inline void AppConfig::clear_sentence_max_results() {
+  _impl_.sentence_max_results_ = 0u;
+}
+inline uint32_t AppConfig::_internal_sentence_max_results() const {
+  return _impl_.sentence_max_results_;
+}
+inline uint32_t AppConfig::sentence_max_results() const {
+  // @@protoc_insertion_point(field_get:khiin.proto.AppConfig.sentence_max_results)
+  return _internal_sentence_max_results();
+}
+inline void AppConfig::_internal_set_sentence_max_results(uint32_t value) {
+  
+  _impl_.sentence_max_results_ = value;
+}
+inline void AppConfig::set_sentence_max_results(uint32_t value) {
+  _internal_set_sentence_max_results(value);
+  // @@protoc_insertion_point(field_set:khiin.proto.AppConfig.sentence_max_results)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__